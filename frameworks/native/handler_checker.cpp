@@ -26,6 +26,12 @@ void HandlerChecker::ScheduleCheck()
         return;
     }
 
+    isHeartbeatCheck_ = (heartbeat_ != nullptr) && heartbeat_->IsAttached() && isCompleted_.load();
+    if (isHeartbeatCheck_) {
+        lastBeats_ = heartbeat_->GetBeats();
+        return;
+    }
+
     bool expected = true;
     if (!isCompleted_.compare_exchange_strong(expected, false)) {
         return;
@@ -33,9 +39,16 @@ void HandlerChecker::ScheduleCheck()
 
     taskSlow_ = false;
     auto weak = weak_from_this();
-    auto checkTask = [weak]() {
+    uint64_t postTime = GetCurrentTickMicroseconds();
+    probePostTime_.store(postTime, std::memory_order_relaxed);
+    auto checkTask = [weak, postTime]() {
         auto self = weak.lock();
         if (self) {
+            uint64_t now = GetCurrentTickMicroseconds();
+            uint64_t latency = (now > postTime) ? (now - postTime) : 0;
+            self->probeLatency_.Record(latency);
+            self->lastProbeLatency_.store(latency, std::memory_order_relaxed);
+            self->probePostTime_.store(0, std::memory_order_relaxed);
             if (self->name_ == IPC_FULL_TASK) {
                 if (__get_global_hook_flag() && __get_hook_flag()) {
                     __set_hook_flag(false);
@@ -50,14 +63,63 @@ void HandlerChecker::ScheduleCheck()
     if (!handler_->PostTask(checkTask, taskName, 0, priority_)) {
         XCOLLIE_LOGE("post %{public}s failed", taskName.c_str());
     }
+    if (isLadder_.load(std::memory_order_relaxed)) {
+        for (size_t i = 0; i < sizeof(ladder_) / sizeof(ladder_[0]); i++) {
+            if (ladder_[i].priority < priority_) {
+                ScheduleLadderProbe(i);
+            }
+        }
+    }
+}
+
+void HandlerChecker::ScheduleLadderProbe(size_t index)
+{
+    ProbeRung& rung = ladder_[index];
+    if (rung.postTime.load(std::memory_order_relaxed) != 0) {
+        return;
+    }
+    auto weak = weak_from_this();
+    uint64_t postTime = GetCurrentTickMicroseconds();
+    rung.postTime.store(postTime, std::memory_order_relaxed);
+    auto ladderTask = [weak, postTime, index]() {
+        auto self = weak.lock();
+        if (self) {
+            uint64_t now = GetCurrentTickMicroseconds();
+            ProbeRung& rung = self->ladder_[index];
+            rung.latency.store((now > postTime) ? (now - postTime) : 0, std::memory_order_relaxed);
+            rung.postTime.store(0, std::memory_order_relaxed);
+        }
+    };
+    if (!handler_->PostTask(ladderTask, "XCollie Watchdog Ladder Task", 0, rung.priority)) {
+        rung.postTime.store(0, std::memory_order_relaxed);
+    }
 }
 
 int HandlerChecker::GetCheckState()
 {
+    if (isHeartbeatCheck_) {
+        return GetHeartbeatState();
+    }
     if (isCompleted_.load()) {
         taskSlow_ = false;
         return CheckStatus::COMPLETED;
     }
+    return GetSlowState();
+}
+
+int HandlerChecker::GetHeartbeatState()
+{
+    uint64_t beats = heartbeat_->GetBeats();
+    // an event begun or finished since the last check, or an idle queue, means the looper is alive
+    if (beats != lastBeats_ || (!HeartbeatSlot::IsInEvent(beats) && handler_->IsIdle())) {
+        taskSlow_ = false;
+        return CheckStatus::COMPLETED;
+    }
+    return GetSlowState();
+}
+
+int HandlerChecker::GetSlowState()
+{
     if (!taskSlow_) {
         taskSlow_ = true;
         return CheckStatus::WAITED_HALF;
@@ -68,14 +130,76 @@ int HandlerChecker::GetCheckState()
 std::string HandlerChecker::GetDumpInfo()
 {
     std::string ret;
+    if (heartbeat_ != nullptr) {
+        uint64_t beats = heartbeat_->GetBeats();
+        ret += "Heartbeat beats:" + std::to_string(beats) + ", in event:" +
+            (HeartbeatSlot::IsInEvent(beats) ? "true" : "false") + "\n";
+    }
+    LatencyHistogram::Summary latency = probeLatency_.GetSummary();
+    if (latency.count != 0) {
+        ret += "Probe latency(us) count:" + std::to_string(latency.count) + " p50:" + std::to_string(latency.p50) +
+            " p99:" + std::to_string(latency.p99) + " max:" + std::to_string(latency.max) + ", pending:" +
+            std::to_string(GetPendingProbeTime(GetCurrentTickMicroseconds())) + "\n";
+    }
+    ProbeLadderClass ladderClass = GetProbeLadderClass(GetCurrentTickMicroseconds());
+    if (ladderClass != ProbeLadderClass::NONE) {
+        static const char* const LADDER_CLASS_NAMES[] = {"none", "blocked", "starved", "slow"};
+        ret += std::string("Probe ladder:") + LADDER_CLASS_NAMES[static_cast<int>(ladderClass)];
+        for (const auto& rung : ladder_) {
+            if (rung.priority < priority_) {
+                ret += std::string(", ") +
+                    (rung.priority == AppExecFwk::EventQueue::Priority::VIP ? "vip" : "immediate") +
+                    " probe latency(us):" + std::to_string(rung.latency.load(std::memory_order_relaxed));
+            }
+        }
+        ret += "\n";
+    }
     if (handler_) {
         HandlerDumper handlerDumper;
         handler_->Dump(handlerDumper);
-        ret = handlerDumper.GetDumpInfo();
+        ret += handlerDumper.GetDumpInfo();
     }
     return ret;
 }
 
+const LatencyHistogram& HandlerChecker::GetProbeLatency() const
+{
+    return probeLatency_;
+}
+
+uint64_t HandlerChecker::GetPendingProbeTime(uint64_t now) const
+{
+    uint64_t postTime = probePostTime_.load(std::memory_order_relaxed);
+    return (postTime != 0 && now > postTime) ? (now - postTime) : 0;
+}
+
+void HandlerChecker::SetProbeLadder(bool isEnable)
+{
+    isLadder_.store(isEnable, std::memory_order_relaxed);
+}
+
+ProbeLadderClass HandlerChecker::GetProbeLadderClass(uint64_t now) const
+{
+    uint64_t pending = GetPendingProbeTime(now);
+    if (!isLadder_.load(std::memory_order_relaxed) || pending == 0) {
+        return ProbeLadderClass::NONE;
+    }
+    // the lowest probe above priority_ that has run tells a busy queue, blocked only when none has
+    for (const auto& rung : ladder_) {
+        if (rung.priority >= priority_ || rung.postTime.load(std::memory_order_relaxed) != 0) {
+            continue;
+        }
+        // 2: the higher probe waited for at least half of the time the probe has been pending
+        return (rung.latency.load(std::memory_order_relaxed) * 2 >= pending) ? ProbeLadderClass::SLOW :
+            ProbeLadderClass::STARVED;
+    }
+    return ProbeLadderClass::BLOCKED;
+}
+
+uint64_t HandlerChecker::GetLastProbeLatency() const
+{
+    return lastProbeLatency_.load(std::memory_order_relaxed);
+}
 
 std::shared_ptr<AppExecFwk::EventHandler> HandlerChecker::GetHandler() const
 {
@@ -21,6 +21,8 @@
 
 #include "dumper.h"
 #include "event_handler.h"
+#include "watchdog_heartbeat.h"
+#include "watchdog_histogram.h"
 #include "xcollie_define.h"
 
 namespace OHOS {
@@ -31,6 +33,21 @@ enum CheckStatus {
     WAITED_HALF = 2,
 };
 
+// Why a stalled probe has not run, as told by the ladder of probes at the IMMEDIATE and VIP priorities above it.
+enum class ProbeLadderClass {
+    NONE = 0, // no ladder or nothing stalled
+    BLOCKED, // no probe of the ladder has run either, the thread is stuck in one task
+    STARVED, // a higher probe ran at once, higher priority work keeps the probe waiting
+    SLOW, // a higher probe ran late, the thread moves on but every task is slow
+};
+
+// A probe of the ladder, posted at priority next to every probe at a lower priority.
+struct ProbeRung {
+    AppExecFwk::EventQueue::Priority priority;
+    std::atomic<uint64_t> postTime {0}; // microseconds, 0 when the probe is not pending
+    std::atomic<uint64_t> latency {0};
+};
+
 class HandlerChecker : public std::enable_shared_from_this<HandlerChecker> {
 public:
     HandlerChecker(std::string name, std::shared_ptr<AppExecFwk::EventHandler> handler)
@@ -44,6 +61,9 @@ public:
     HandlerChecker(std::string name, std::shared_ptr<AppExecFwk::EventHandler> handler,
         AppExecFwk::EventQueue::Priority priority)
         : name_(name), handler_(handler), priority_(priority) {};
+    HandlerChecker(std::string name, std::shared_ptr<AppExecFwk::EventHandler> handler,
+        std::shared_ptr<HeartbeatSlot> heartbeat)
+        : name_(name), handler_(handler), heartbeat_(heartbeat) {};
     ~HandlerChecker() {};
 
 public:
@@ -51,13 +71,36 @@ public:
     int GetCheckState();
     std::shared_ptr<AppExecFwk::EventHandler> GetHandler() const;
     std::string GetDumpInfo();
+    // Post to run latency of every probe task, in microseconds. Heartbeat checks post no probe.
+    const LatencyHistogram& GetProbeLatency() const;
+    // How long the probe posted last has been waiting, 0 when it has run.
+    uint64_t GetPendingProbeTime(uint64_t now) const;
+    // Post to run latency of the probe that ran last, in microseconds.
+    uint64_t GetLastProbeLatency() const;
+    // Also post probes at the ladder priorities above the configured one next to its probe.
+    void SetProbeLadder(bool isEnable);
+    ProbeLadderClass GetProbeLadderClass(uint64_t now) const;
 
 private:
+    void ScheduleLadderProbe(size_t index);
+    int GetHeartbeatState();
+    int GetSlowState();
+
     std::string name_;
     std::shared_ptr<AppExecFwk::EventHandler> handler_;
     std::atomic<bool> isCompleted_ = true;
     bool taskSlow_ = false;
     AppExecFwk::EventQueue::Priority priority_ = AppExecFwk::EventQueue::Priority::IMMEDIATE;
+    // heartbeat mode, the looper reports its progress and nothing is posted while the slot is attached
+    std::shared_ptr<HeartbeatSlot> heartbeat_;
+    bool isHeartbeatCheck_ = false; // the last ScheduleCheck took a heartbeat snapshot
+    uint64_t lastBeats_ = 0;
+    LatencyHistogram probeLatency_;
+    std::atomic<uint64_t> probePostTime_ {0}; // microseconds, 0 when no probe is pending
+    std::atomic<uint64_t> lastProbeLatency_ {0};
+    std::atomic_bool isLadder_ {false};
+    // lowest priority first, a rung is only used above priority_
+    ProbeRung ladder_[2] {{AppExecFwk::EventQueue::Priority::IMMEDIATE}, {AppExecFwk::EventQueue::Priority::VIP}};
 };
 
 class HandlerDumper : public AppExecFwk::Dumper {
@@ -20,6 +20,7 @@
 
 #include "handler_checker.h"
 #include "event_handler.h"
+#include "xcollie_utils.h"
 using namespace testing::ext;
 using namespace OHOS::AppExecFwk;
 namespace OHOS {
@@ -139,5 +140,128 @@ HWTEST_F(HandlerCheckerTest, HandlerCheckerTest_004, TestSize.Level3)
     
     ASSERT_EQ(handlerDumper.GetTag(), "");
 }
+
+/**
+ * @tc.name: HandlerCheckerTest_005
+ * @tc.desc: Verify heartbeat mode reports a looper stuck in one event without posting a check task
+ * @tc.type: FUNC
+ */
+HWTEST_F(HandlerCheckerTest, HandlerCheckerTest_005, TestSize.Level1)
+{
+    std::atomic<bool> isFinished = false;
+    auto runner = EventRunner::Create(true);
+    auto handler = std::make_shared<TestEventHandler>(runner);
+    auto heartbeat = std::make_shared<HeartbeatSlot>();
+    HandlerChecker handlerChecker("HandlerCheckerTest_005", handler, heartbeat);
+    auto blockFunc = [&isFinished, heartbeat]() {
+        heartbeat->BeginEvent();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1500));
+        heartbeat->EndEvent();
+        isFinished = true;
+    };
+    ASSERT_TRUE(handler->PostTask(blockFunc, "Block1500", 0, EventQueue::Priority::IMMEDIATE));
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    ASSERT_TRUE(HeartbeatSlot::IsInEvent(heartbeat->GetBeats()));
+
+    handlerChecker.ScheduleCheck();
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    ASSERT_EQ(handlerChecker.GetCheckState(), CheckStatus::WAITED_HALF);
+    handlerChecker.ScheduleCheck();
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    ASSERT_EQ(handlerChecker.GetCheckState(), CheckStatus::WAITING);
+    ASSERT_NE(handlerChecker.GetDumpInfo().find("in event:true"), std::string::npos);
+
+    for (int i = 0; !isFinished; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        ASSERT_LT(i, 30);
+    }
+    // the event ended since the last snapshot
+    ASSERT_EQ(handlerChecker.GetCheckState(), CheckStatus::COMPLETED);
+    // no progress but nothing to run either
+    handlerChecker.ScheduleCheck();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    ASSERT_EQ(handlerChecker.GetCheckState(), CheckStatus::COMPLETED);
+
+    // a detached slot falls back to a posted check task
+    heartbeat->SetAttached(false);
+    handlerChecker.ScheduleCheck();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    ASSERT_EQ(handlerChecker.GetCheckState(), CheckStatus::COMPLETED);
+}
+
+/**
+ * @tc.name: HandlerCheckerTest_006
+ * @tc.desc: Verify the post to run latency of every probe is recorded and dumped
+ * @tc.type: FUNC
+ */
+HWTEST_F(HandlerCheckerTest, HandlerCheckerTest_006, TestSize.Level1)
+{
+    auto runner = EventRunner::Create("HandlerCheckerTest_006");
+    auto handler = std::make_shared<TestEventHandler>(runner);
+    auto handlerChecker = std::make_shared<HandlerChecker>("HandlerCheckerTest_006", handler);
+    auto blockFunc = []() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    };
+    ASSERT_TRUE(handler->PostTask(blockFunc, "Block200", 0, EventQueue::Priority::IMMEDIATE));
+    handlerChecker->ScheduleCheck();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    ASSERT_GT(handlerChecker->GetPendingProbeTime(GetCurrentTickMicroseconds()), 0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    ASSERT_EQ(handlerChecker->GetCheckState(), CheckStatus::COMPLETED);
+    ASSERT_EQ(handlerChecker->GetPendingProbeTime(GetCurrentTickMicroseconds()), 0);
+    handlerChecker->ScheduleCheck();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    LatencyHistogram::Summary latency = handlerChecker->GetProbeLatency().GetSummary();
+    ASSERT_EQ(latency.count, 2);
+    ASSERT_GE(latency.max, 100000); // 100000: the first probe waited behind the 200ms task
+    ASSERT_NE(handlerChecker->GetDumpInfo().find("Probe latency(us) count:2"), std::string::npos);
+}
+
+/**
+ * @tc.name: HandlerCheckerTest_007
+ * @tc.desc: Verify the probe ladder tells a blocked thread from a starved queue
+ * @tc.type: FUNC
+ */
+HWTEST_F(HandlerCheckerTest, HandlerCheckerTest_007, TestSize.Level1)
+{
+    auto runner = EventRunner::Create("HandlerCheckerTest_007");
+    auto handler = std::make_shared<TestEventHandler>(runner);
+    auto handlerChecker = std::make_shared<HandlerChecker>("HandlerCheckerTest_007", handler,
+        EventQueue::Priority::LOW);
+    handlerChecker->SetProbeLadder(true);
+    auto sleepFunc = [](int ms) {
+        return [ms]() { std::this_thread::sleep_for(std::chrono::milliseconds(ms)); };
+    };
+    ASSERT_TRUE(handler->PostTask(sleepFunc(400), "Block400", 0, EventQueue::Priority::HIGH));
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    handlerChecker->ScheduleCheck();
+    std::this_thread::sleep_for(std::chrono::milliseconds(150));
+    ASSERT_EQ(handlerChecker->GetProbeLadderClass(GetCurrentTickMicroseconds()), ProbeLadderClass::BLOCKED);
+    ASSERT_NE(handlerChecker->GetDumpInfo().find("Probe ladder:blocked"), std::string::npos);
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    ASSERT_EQ(handlerChecker->GetCheckState(), CheckStatus::COMPLETED);
+    ASSERT_EQ(handlerChecker->GetProbeLadderClass(GetCurrentTickMicroseconds()), ProbeLadderClass::NONE);
+
+    for (int i = 0; i < 10; i++) { // 10: keep high priority work queued for about 500ms
+        ASSERT_TRUE(handler->PostTask(sleepFunc(50), "Busy50", 0, EventQueue::Priority::HIGH));
+    }
+    handlerChecker->ScheduleCheck();
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    ASSERT_EQ(handlerChecker->GetProbeLadderClass(GetCurrentTickMicroseconds()), ProbeLadderClass::STARVED);
+    ASSERT_NE(handlerChecker->GetDumpInfo().find("Probe ladder:starved"), std::string::npos);
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+
+    // an immediate check flooded by immediate work is told apart by the vip probe
+    auto immediateChecker = std::make_shared<HandlerChecker>("HandlerCheckerTest_007_Immediate", handler);
+    immediateChecker->SetProbeLadder(true);
+    for (int i = 0; i < 10; i++) { // 10: keep immediate work queued for about 500ms
+        ASSERT_TRUE(handler->PostTask(sleepFunc(50), "Busy50", 0, EventQueue::Priority::IMMEDIATE));
+    }
+    immediateChecker->ScheduleCheck();
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    ASSERT_EQ(immediateChecker->GetProbeLadderClass(GetCurrentTickMicroseconds()), ProbeLadderClass::STARVED);
+    ASSERT_NE(immediateChecker->GetDumpInfo().find("vip probe latency(us)"), std::string::npos);
+}
 } // end of namespace HiviewDFX
 } // end of namespace OHOS
\ No newline at end of file
@@ -17,9 +17,13 @@
 
 #include <dlfcn.h>
 #include <uv.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
 #include <csignal>
 #include <fstream>
 #include <sstream>
+#include <thread>
 
 #include "async_stack.h"
 #include "watchdog.h"
@@ -491,6 +495,8 @@ HWTEST_F(ThreadSamplerTest, ThreadSamplerTest_006, TestSize.Level0)
 #include "thread_sampler.h"
 #undef private
 #undef protected
+#include "sample_symbolizer.h"
+#include "thread_sampler_api.h"
 #include "thread_sampler_utils.h"
 
 namespace OHOS {
@@ -504,6 +510,34 @@ void WaitFewSec(int waitSec)
     }
 }
 
+__attribute__((noinline)) int DeepCall(int depth, const std::atomic<bool>& stop)
+{
+    // keeps a frame per level, the recursion must not be turned into a loop
+    volatile int level = depth;
+    if (depth > 0) {
+        return DeepCall(depth - 1, stop) + level;
+    }
+    while (!stop) {
+        level = level + 1;
+    }
+    return level;
+}
+
+__attribute__((noinline)) int LeafCall(int value)
+{
+    return value + 1;
+}
+
+__attribute__((noinline)) int StaleLrSpin(const std::atomic<bool>& stop)
+{
+    // after the first call lr points back into this function, not to its caller
+    volatile int level = LeafCall(0);
+    while (!stop) {
+        level = level + 1;
+    }
+    return level;
+}
+
 bool ThreadSamplerTest::InstallThreadSamplerTestSignal()
 {
     struct sigaction action {};
@@ -533,28 +567,34 @@ HWTEST_F(ThreadSamplerTest, ThreadSamplerTest_007, TestSize.Level3)
     flag = ThreadSampler::GetInstance().Init(sampleCnt, false);
     ASSERT_TRUE(flag);
     ASSERT_TRUE(ThreadSampler::GetInstance().init_);
-    ASSERT_NE(ThreadSampler::GetInstance().mmapStart_, MAP_FAILED);
+    SampledThread* mainThread = ThreadSampler::GetInstance().FindThread(getpid());
+    ASSERT_NE(mainThread, nullptr);
+    ASSERT_NE(mainThread->mmapStart, MAP_FAILED);
 
     void* ctx = nullptr;
     ThreadSampler::GetInstance().init_ = false;
     // should return before read ctx.
     ThreadSampler::GetInstance().WriteContext(ctx);
-    ASSERT_EQ(ThreadSampler::GetInstance().GetReadContext(), nullptr);
+    ASSERT_EQ(ThreadSampler::GetInstance().GetReadContext(*mainThread), nullptr);
 
     ThreadSampler::GetInstance().init_ = true;
-    ThreadSampler::GetInstance().mmapStart_ = MAP_FAILED;
+    void* mmapStart = mainThread->mmapStart;
+    mainThread->mmapStart = MAP_FAILED;
     // should return before read ctx.
     ThreadSampler::GetInstance().WriteContext(ctx);
-    ASSERT_EQ(ThreadSampler::GetInstance().GetReadContext(), nullptr);
+    ASSERT_EQ(ThreadSampler::GetInstance().GetReadContext(*mainThread), nullptr);
+    mainThread->mmapStart = mmapStart;
     ThreadSampler::GetInstance().Deinit();
 
     ThreadSampler::GetInstance().Init(sampleCnt, true);
-    ThreadSampler::GetInstance().submitterStackIdIndex_ = 1;
+    mainThread = ThreadSampler::GetInstance().FindThread(getpid());
+    ASSERT_NE(mainThread, nullptr);
+    mainThread->submitterStackIdIndex = 1;
 
     int waitSec = 5;
     ThreadSampler::GetInstance().Sample();
     WaitFewSec(waitSec);
-    ASSERT_EQ(ThreadSampler::GetInstance().submitterStackIds_[0], 0);
+    ASSERT_EQ(mainThread->submitterStackIds[0], 0);
     ThreadSampler::GetInstance().Deinit();
 }
 
@@ -595,7 +635,7 @@ HWTEST_F(ThreadSamplerTest, ThreadSamplerTest_008, TestSize.Level3)
     ASSERT_TRUE(stack.find("========SubmitterStacktrace========") == std::string::npos);
 
     ThreadSampler::GetInstance().recordSubmitterStack_ = true;
-    ThreadSampler::GetInstance().submitterStackIds_[0] = 0;
+    ThreadSampler::GetInstance().FindThread(getpid())->submitterStackIds[0] = 0;
     ThreadSampler::GetInstance().CollectStack(stack, false);
     ASSERT_NE(stack, "");
     ASSERT_TRUE(stack.find("========SubmitterStacktrace========") == std::string::npos);
@@ -635,5 +675,619 @@ HWTEST_F(ThreadSamplerTest, ThreadSamplerTest_009, TestSize.Level3)
     std::string timeStr = TimeFormat(testTime);
     ASSERT_EQ(timeStr, "2024-05-21-17-12-36.003107");
 }
+
+/**
+ * @tc.name: ThreadSamplerTest_010
+ * @tc.desc: Sample a thread other than the main thread through its own capture ring.
+ * @tc.type: FUNC
+ * @tc.require
+ */
+HWTEST_F(ThreadSamplerTest, ThreadSamplerTest_010, TestSize.Level3)
+{
+    printf("ThreadSamplerTest_010\n");
+    InstallThreadSamplerTestSignal();
+
+    size_t sampleCnt = 1;
+    ASSERT_FALSE(ThreadSampler::GetInstance().Init(sampleCnt, false, -1));
+    ASSERT_FALSE(ThreadSampler::GetInstance().init_);
+    ASSERT_TRUE(ThreadSampler::GetInstance().Init(sampleCnt, false));
+
+    std::atomic<int32_t> workerTid {0};
+    std::atomic<bool> stop {false};
+    std::thread worker([&workerTid, &stop, sampleCnt] {
+        // the stack range of the calling thread comes from its pthread attributes
+        if (ThreadSampler::GetInstance().Init(sampleCnt, false, gettid())) {
+            workerTid = gettid();
+        } else {
+            workerTid = -1;
+        }
+        while (!stop) {
+            WaitFewSec(1);
+        }
+    });
+    while (workerTid == 0) {
+        usleep(MILLSEC_TO_MICROSEC);
+    }
+    ASSERT_GT(workerTid.load(), 0);
+    SampledThread* mainThread = ThreadSampler::GetInstance().FindThread(getpid());
+    SampledThread* workerThread = ThreadSampler::GetInstance().FindThread(workerTid);
+    ASSERT_NE(mainThread, nullptr);
+    ASSERT_NE(workerThread, nullptr);
+    ASSERT_NE(mainThread->mmapStart, workerThread->mmapStart);
+    // no thread has this tid, it is above the pid limit
+    ASSERT_EQ(ThreadSampler::GetInstance().Sample(INT32_MAX), -1);
+
+    int waitSec = 2;
+    ASSERT_EQ(ThreadSampler::GetInstance().Sample(workerTid), 0);
+    WaitFewSec(waitSec);
+    std::string stack;
+    bool collected = ThreadSampler::GetInstance().CollectStack(workerTid, stack, false);
+    stop = true;
+    worker.join();
+    ASSERT_EQ(collected, !workerThread->timeStampedPcsList.empty());
+#if defined(__aarch64__)
+    ASSERT_TRUE(collected);
+    ASSERT_FALSE(workerThread->timeStampedPcsList.empty());
+    ASSERT_TRUE(mainThread->timeStampedPcsList.empty());
+#endif
+    ASSERT_NE(stack, "");
+    ThreadSampler::GetInstance().Deinit();
+    ASSERT_EQ(ThreadSampler::GetInstance().FindThread(getpid()), nullptr);
+}
+
+/**
+ * @tc.name: ThreadSamplerTest_011
+ * @tc.desc: Fill a deeper capture ring before unwinding and count the dropped samples.
+ * @tc.type: FUNC
+ * @tc.require
+ */
+HWTEST_F(ThreadSamplerTest, ThreadSamplerTest_011, TestSize.Level3)
+{
+    printf("ThreadSamplerTest_011\n");
+    InstallThreadSamplerTestSignal();
+
+    ASSERT_FALSE(ThreadSampler::GetInstance().SetRingDepth(0));
+    ASSERT_FALSE(ThreadSampler::GetInstance().SetRingDepth(ThreadSampler::SAMPLER_MAX_RING_DEPTH + 1));
+    uint32_t depth = 4;
+    ASSERT_TRUE(ThreadSampler::GetInstance().SetRingDepth(depth));
+    size_t sampleCnt = 10;
+    ASSERT_TRUE(ThreadSampler::GetInstance().Init(sampleCnt, false));
+    SampledThread* mainThread = ThreadSampler::GetInstance().FindThread(getpid());
+    ASSERT_NE(mainThread, nullptr);
+    ASSERT_EQ(mainThread->depth, depth);
+
+    // the signal is handled on this thread before the request returns, nothing is unwound meanwhile
+    for (uint32_t i = 0; i <= depth; i++) {
+        ThreadSampler::GetInstance().SendSampleRequest(*mainThread);
+    }
+#if defined(__aarch64__)
+    ASSERT_EQ(mainThread->head.load(), depth);
+    ASSERT_EQ(ThreadSampler::GetInstance().GetDroppedCount(0), 1U);
+#endif
+    ASSERT_EQ(mainThread->tail.load(), 0U);
+    ThreadSampler::GetInstance().ProcessStackBuffer();
+    ASSERT_EQ(mainThread->tail.load(), mainThread->head.load());
+    ASSERT_EQ(ThreadSampler::GetInstance().GetReadContext(*mainThread), nullptr);
+#if defined(__aarch64__)
+    ASSERT_EQ(mainThread->timeStampedPcsList.size(), depth);
+#endif
+
+    ThreadSampler::GetInstance().SetRingDepth(ThreadSampler::SAMPLER_DEFAULT_RING_DEPTH);
+    ThreadSampler::GetInstance().Deinit();
+}
+
+/**
+ * @tc.name: ThreadSamplerTest_012
+ * @tc.desc: Check the adaptive stack copy size and the signal handler time of samples.
+ * @tc.type: FUNC
+ * @tc.require
+ */
+HWTEST_F(ThreadSamplerTest, ThreadSamplerTest_012, TestSize.Level3)
+{
+    printf("ThreadSamplerTest_012\n");
+    InstallThreadSamplerTestSignal();
+
+    size_t sampleCnt = 1;
+    ASSERT_TRUE(ThreadSampler::GetInstance().Init(sampleCnt, false));
+    SampledThread* mainThread = ThreadSampler::GetInstance().FindThread(getpid());
+    ASSERT_NE(mainThread, nullptr);
+    auto context = std::make_unique<ThreadUnwindContext>();
+    context->usedSize = 1000;
+    ThreadSampler::GetInstance().UpdateCopyLimit(*mainThread, *context);
+    ASSERT_EQ(mainThread->copyLimit.load(), static_cast<uint32_t>(STACK_BUFFER_SIZE));
+
+    ThreadSampler::GetInstance().SetAdaptiveCopy(true);
+    for (uint32_t i = 0; i < ADAPTIVE_COPY_WINDOW; i++) {
+        ThreadSampler::GetInstance().UpdateCopyLimit(*mainThread, *context);
+    }
+    // the deepest read plus 2KB headroom, aligned to 16 bytes
+    ASSERT_EQ(mainThread->copyLimit.load(), 3056U);
+
+    uintptr_t sp = 0x10000;
+    context->sp = sp;
+    context->stackSize = 128; // 128: stack above sp
+    context->copySize = 64; // 64: stack copied by the handler
+    context->usedSize = 0;
+    UnwindInfo unwindInfo = {.context = context.get(), .maps = nullptr};
+    uintptr_t val = 0;
+    ASSERT_EQ(ThreadSampler::AccessMem(sp + sizeof(uintptr_t), &val, &unwindInfo), 0);
+    ASSERT_EQ(context->usedSize, 2 * sizeof(uintptr_t));
+    ASSERT_FALSE(context->truncated);
+    ASSERT_EQ(ThreadSampler::AccessMem(sp + context->copySize, &val, &unwindInfo), -1);
+    ASSERT_TRUE(context->truncated);
+    ThreadSampler::GetInstance().UpdateCopyLimit(*mainThread, *context);
+    ASSERT_EQ(mainThread->copyLimit.load(), static_cast<uint32_t>(STACK_BUFFER_SIZE));
+    ThreadSampler::GetInstance().SetAdaptiveCopy(false);
+
+    int waitSec = 1;
+    ThreadSampler::GetInstance().Sample();
+    WaitFewSec(waitSec);
+    std::string stack;
+    ThreadSampler::GetInstance().CollectStack(stack, false);
+#if defined(__aarch64__)
+    ASSERT_EQ(mainThread->residencyTimes.size(), 1U);
+    ASSERT_NE(stack.find("SignalHandlerTime:"), std::string::npos);
+#endif
+    ThreadSampler::GetInstance().Deinit();
+}
+
+/**
+ * @tc.name: ThreadSamplerTest_013
+ * @tc.desc: Benchmark frame pointer unwind against DWARF unwind on the same samples of a deep call stack.
+ * @tc.type: PERF
+ * @tc.require
+ */
+HWTEST_F(ThreadSamplerTest, ThreadSamplerTest_013, TestSize.Level3)
+{
+    printf("ThreadSamplerTest_013\n");
+    InstallThreadSamplerTestSignal();
+
+    constexpr int callDepth = 64;
+    constexpr int sampleNum = 50;
+    size_t sampleCnt = 1;
+    ASSERT_TRUE(ThreadSampler::GetInstance().Init(sampleCnt, false));
+    std::atomic<int32_t> workerTid {0};
+    std::atomic<bool> stop {false};
+    std::thread worker([&workerTid, &stop, sampleCnt] {
+        workerTid = ThreadSampler::GetInstance().Init(sampleCnt, false, gettid()) ? gettid() : -1;
+        DeepCall(callDepth, stop);
+    });
+    while (workerTid == 0) {
+        usleep(MILLSEC_TO_MICROSEC);
+    }
+    ASSERT_GT(workerTid.load(), 0);
+    SampledThread* thread = ThreadSampler::GetInstance().FindThread(workerTid);
+    ASSERT_NE(thread, nullptr);
+    auto& sampler = ThreadSampler::GetInstance();
+
+    int samples = 0;
+    int fpFailed = 0;
+    int agreed = 0;
+    uint64_t fpCost = 0;
+    uint64_t dwarfCost = 0;
+    for (int i = 0; i < sampleNum; i++) {
+        sampler.SendSampleRequest(*thread);
+        ThreadUnwindContext* context = nullptr;
+        for (int retry = 0; retry < INTERVAL && context == nullptr; retry++) {
+            usleep(MILLSEC_TO_MICROSEC);
+            context = sampler.GetReadContext(*thread);
+        }
+        if (context == nullptr) {
+            continue;
+        }
+        std::vector<uintptr_t> fpPcs;
+        uint64_t begin = GetCurrentTimeNanoseconds();
+        bool fpDone = DoFpUnwind(*context, sampler.maps_, fpPcs);
+        uint64_t middle = GetCurrentTimeNanoseconds();
+        bool truncated = context->truncated;
+        UnwindInfo unwindInfo = {.context = context, .maps = sampler.maps_.get()};
+        DoUnwind(sampler.unwinder_, unwindInfo);
+        std::vector<uintptr_t> dwarfPcs = sampler.unwinder_->GetPcs();
+        uint64_t end = GetCurrentTimeNanoseconds();
+        sampler.ReleaseReadContext(*thread);
+        samples++;
+        fpCost += middle - begin;
+        dwarfCost += end - middle;
+        fpFailed += fpDone ? 0 : 1;
+        agreed += (fpDone && fpPcs == dwarfPcs) ? 1 : 0;
+        if (fpDone && !truncated) {
+            ASSERT_EQ(fpPcs, dwarfPcs);
+        }
+    }
+    stop = true;
+    worker.join();
+    if (samples > 0) {
+        printf("samples:%d, fp unwind:%llu ns, dwarf unwind:%llu ns, fp failed:%d, same stack:%d\n", samples,
+            static_cast<unsigned long long>(fpCost / samples), static_cast<unsigned long long>(dwarfCost / samples),
+            fpFailed, agreed);
+    }
+#if defined(__aarch64__)
+    ASSERT_GT(samples, 0);
+#endif
+    sampler.Deinit();
+}
+
+/**
+ * @tc.name: ThreadSamplerTest_014
+ * @tc.desc: Benchmark back-to-back Init/Deinit cycles with and without the warm cache.
+ * @tc.type: PERF
+ * @tc.require
+ */
+HWTEST_F(ThreadSamplerTest, ThreadSamplerTest_014, TestSize.Level3)
+{
+    printf("ThreadSamplerTest_014\n");
+    constexpr int cycleNum = 10;
+    size_t sampleCnt = 1;
+    auto& sampler = ThreadSampler::GetInstance();
+    auto cycles = [&sampler, sampleCnt] {
+        uint64_t begin = GetCurrentTimeNanoseconds();
+        for (int i = 0; i < cycleNum; i++) {
+            sampler.Init(sampleCnt, false);
+            sampler.Deinit();
+        }
+        return (GetCurrentTimeNanoseconds() - begin) / cycleNum;
+    };
+    uint64_t coldCost = cycles();
+    ASSERT_EQ(sampler.maps_, nullptr);
+
+    sampler.SetWarmCache(true);
+    ASSERT_TRUE(sampler.Init(sampleCnt, false));
+    sampler.Deinit();
+    auto maps = sampler.maps_;
+    ASSERT_NE(maps, nullptr);
+    uint64_t warmCost = cycles();
+    printf("init and deinit, cold:%llu ns, warm:%llu ns\n", static_cast<unsigned long long>(coldCost),
+        static_cast<unsigned long long>(warmCost));
+    uint64_t adds = 0;
+    uint64_t subs = 0;
+    if (GetLoadCounts(adds, subs)) {
+        // nothing was loaded in between, the maps are not reloaded
+        ASSERT_EQ(sampler.maps_, maps);
+    }
+
+    sampler.SetWarmCache(false);
+    ASSERT_TRUE(sampler.Init(sampleCnt, false));
+    sampler.Deinit();
+    ASSERT_EQ(sampler.maps_, nullptr);
+}
+
+struct StreamedStack {
+    std::string parts[2]; // 2: the stack and the heaviest stack
+    int pieces {0};
+    int stopPiece {-1};
+};
+
+int AppendStreamedPiece(void* context, int part, const char* data, size_t size)
+{
+    auto stack = static_cast<StreamedStack*>(context);
+    stack->parts[part].append(data, size);
+    return (++stack->pieces == stack->stopPiece) ? 1 : 0;
+}
+
+/**
+ * @tc.name: ThreadSamplerTest_015
+ * @tc.desc: Collect the raw samples as a record, decode it and symbolize it offline.
+ * @tc.type: FUNC
+ * @tc.require
+ */
+HWTEST_F(ThreadSamplerTest, ThreadSamplerTest_015, TestSize.Level3)
+{
+    printf("ThreadSamplerTest_015\n");
+    SampleRecord record;
+    record.pid = 1;
+    record.tid = 2;
+    record.buildIds.push_back(std::string("\x01\x02\x00\xff", 4)); // 4: build id bytes
+    record.mappings.push_back({0x5000, 0x9000, 0x1000, 1, "/system/lib64/libtest.z.so"});
+    record.samples.push_back({300, {0x8004, 0x5008, 0x7ffc}, {0x6000}});
+    record.samples.push_back({200, {0x8004}, {}});
+    std::string data;
+    EncodeSampleRecord(record, data);
+    SampleRecord decoded;
+    ASSERT_TRUE(DecodeSampleRecord(reinterpret_cast<const uint8_t*>(data.data()), data.size(), decoded));
+    ASSERT_EQ(decoded.buildIds, record.buildIds);
+    ASSERT_EQ(decoded.mappings[0].end, 0x9000U);
+    ASSERT_EQ(decoded.mappings[0].name, record.mappings[0].name);
+    ASSERT_EQ(decoded.samples[0].pcs, record.samples[0].pcs);
+    ASSERT_EQ(decoded.samples[0].submitterPcs, record.samples[0].submitterPcs);
+    ASSERT_EQ(decoded.samples[1].snapshotTime, 200U);
+    ASSERT_FALSE(DecodeSampleRecord(reinterpret_cast<const uint8_t*>(data.data()), data.size() - 1, decoded));
+
+    InstallThreadSamplerTestSignal();
+    auto& sampler = ThreadSampler::GetInstance();
+    ASSERT_TRUE(sampler.Init(SAMPLE_CNT, false));
+    int waitSec = 1;
+    for (int i = 0; i < 2; i++) { // 2: samples
+        sampler.Sample();
+        WaitFewSec(waitSec);
+    }
+    ASSERT_TRUE(sampler.CollectRecord(data));
+    ASSERT_TRUE(DecodeSampleRecord(reinterpret_cast<const uint8_t*>(data.data()), data.size(), decoded));
+    ASSERT_EQ(decoded.tid, getpid());
+    const auto& pcsList = sampler.FindThread(getpid())->timeStampedPcsList;
+    ASSERT_EQ(decoded.samples.size(), pcsList.size());
+    for (size_t i = 0; i < pcsList.size(); i++) {
+        ASSERT_EQ(decoded.samples[i].snapshotTime, pcsList[i].snapshotTime);
+        ASSERT_TRUE(std::equal(pcsList[i].pcVec.begin(), pcsList[i].pcVec.end(), decoded.samples[i].pcs.begin(),
+            decoded.samples[i].pcs.end()));
+    }
+    // the export builds the record once and hands it to the writer whole
+    ASSERT_EQ(ThreadSamplerCollectRecord(0, nullptr, nullptr), -1);
+    StreamedStack written;
+    ASSERT_EQ(ThreadSamplerCollectRecord(0, AppendStreamedPiece, &written), 0);
+    ASSERT_EQ(written.pieces, 1);
+    ASSERT_TRUE(DecodeSampleRecord(reinterpret_cast<const uint8_t*>(written.parts[0].data()), written.parts[0].size(),
+        decoded));
+    ASSERT_EQ(decoded.tid, getpid());
+    std::string stack;
+    sampler.CollectStack(stack, false);
+    printf("record:%zu bytes, symbolized in process:%zu bytes\n", data.size(), stack.size());
+#if defined(__aarch64__)
+    ASSERT_FALSE(decoded.mappings.empty());
+    SampleSymbolizer symbolizer;
+    ASSERT_TRUE(symbolizer.Symbolize(data, stack));
+    ASSERT_NE(stack.find("#00 pc"), std::string::npos);
+#endif
+    sampler.Deinit();
+}
+
+/**
+ * @tc.name: ThreadSamplerTest_016
+ * @tc.desc: Run the flight recorder with a session in between and check its cpu cost stays in the budget.
+ * @tc.type: PERF
+ * @tc.require
+ */
+HWTEST_F(ThreadSamplerTest, ThreadSamplerTest_016, TestSize.Level3)
+{
+    printf("ThreadSamplerTest_016\n");
+    constexpr uint32_t interval = 50;
+    constexpr uint32_t window = 1000;
+    constexpr size_t memoryBudget = 64 * 1024;
+    constexpr uint32_t cpuBudget = 10;
+    constexpr uint64_t permille = 1000;
+    constexpr int sampleNum = 40;
+    InstallThreadSamplerTestSignal();
+    auto& sampler = ThreadSampler::GetInstance();
+    ASSERT_FALSE(sampler.StartFlightRecorder(0, window, memoryBudget, cpuBudget));
+    ASSERT_TRUE(sampler.StartFlightRecorder(interval, window, memoryBudget, cpuBudget));
+    ASSERT_EQ(sampler.flightSamples_.size(), window / interval);
+    for (int i = 0; i < sampleNum; i++) {
+        sampler.FlightRecorderSample();
+        usleep(interval * MILLSEC_TO_MICROSEC);
+    }
+    std::string stack;
+    bool collected = sampler.CollectFlightStack(window, stack);
+    FlightRecorderStats stats = sampler.GetFlightRecorderStats();
+    uint64_t elapsed = GetCurrentTimeNanoseconds() - stats.startTime;
+    printf("flight recorder collected:%d, samples:%llu, skipped:%llu, cpu:%llu ns in %llu ns, max:%llu ns, "
+        "memory:%llu\n", collected, static_cast<unsigned long long>(stats.sampleCount),
+        static_cast<unsigned long long>(stats.skippedCount),
+        static_cast<unsigned long long>(stats.costTime), static_cast<unsigned long long>(elapsed),
+        static_cast<unsigned long long>(stats.maxCostTime), static_cast<unsigned long long>(stats.memorySize));
+    // the budget is earned as time passes, only the sample spending the last of it can go over
+    ASSERT_LE(stats.costTime, elapsed * cpuBudget / permille + stats.maxCostTime);
+    ASSERT_EQ(stack.find("FlightRecorder samples:"), 0U);
+    std::string samples;
+    ASSERT_TRUE(sampler.CopyFlightSamples(window, samples));
+    std::string symbolized;
+    ASSERT_EQ(sampler.SymbolizeFlightSamples(samples, symbolized), collected);
+    ASSERT_EQ(symbolized.find("FlightRecorder samples:"), 0U);
+    // the exports hand the samples and their symbolization to the writer in one pass
+    StreamedStack copied;
+    ASSERT_EQ(ThreadSamplerCopyFlightSamples(window, AppendStreamedPiece, &copied), 0);
+    ASSERT_EQ(copied.pieces, 1);
+    StreamedStack written;
+    ASSERT_EQ(ThreadSamplerSymbolizeFlightSamples(copied.parts[0].data(), copied.parts[0].size(),
+        AppendStreamedPiece, &written), collected ? 0 : -1);
+    ASSERT_EQ(written.pieces, collected ? 1 : 0);
+
+    // a session samples the main thread into the ring, its Deinit leaves the recorder running
+    std::atomic<bool> sessionDone {false};
+    std::thread reporter([&sampler, &samples, &sessionDone]() {
+        // the report thread symbolizes with its own maps while the session refreshes and unwinds
+        std::string text;
+        while (!sessionDone.load()) {
+            sampler.SymbolizeFlightSamples(samples, text);
+        }
+    });
+    bool inited = sampler.Init(SAMPLE_CNT, false);
+    uint64_t head = sampler.flightHead_;
+    for (int i = 0; inited && i < 2; i++) { // 2: the second sample unwinds the first
+        sampler.Sample();
+        usleep(interval * MILLSEC_TO_MICROSEC);
+    }
+    sessionDone = true;
+    reporter.join();
+    ASSERT_TRUE(inited);
+#if defined(__aarch64__)
+    ASSERT_TRUE(collected);
+    ASSERT_GT(sampler.flightHead_, head);
+#else
+    ASSERT_GE(sampler.flightHead_, head);
+#endif
+    ASSERT_TRUE(sampler.Deinit());
+    ASSERT_TRUE(sampler.init_);
+    ASSERT_NE(sampler.FindThread(getpid()), nullptr);
+
+    ASSERT_TRUE(sampler.StopFlightRecorder());
+    ASSERT_FALSE(sampler.init_);
+    ASSERT_EQ(sampler.symbolizerMaps_, nullptr);
+    ASSERT_EQ(sampler.FindThread(getpid()), nullptr);
+    ASSERT_FALSE(sampler.CollectFlightStack(window, stack));
+}
+
+/**
+ * @tc.name: ThreadSamplerTest_017
+ * @tc.desc: Export the samples as collapsed stacks and a pprof profile.
+ * @tc.type: FUNC
+ * @tc.require
+ */
+HWTEST_F(ThreadSamplerTest, ThreadSamplerTest_017, TestSize.Level3)
+{
+    printf("ThreadSamplerTest_017\n");
+    SampleRecord record;
+    record.mappings.push_back({0x5000, 0x9000, 0x1000, SAMPLE_RECORD_NO_BUILD_ID, "/system/lib64/libtest.z.so"});
+    record.samples.push_back({100, {0x8004, 0x5008}, {}});
+    record.samples.push_back({200, {0x8004, 0x5008}, {}});
+    record.samples.push_back({300, {0x7000}, {0x6000}});
+    SampleFunctionNames names = {{0x8004, "Leaf;Func"}, {0x5008, "Main"}, {0x6000, "Submit"}};
+    std::string data;
+    ASSERT_TRUE(EncodeSampleProfile(SAMPLE_PROFILE_COLLAPSED, record, names, data));
+    ASSERT_EQ(data, "Main;Leaf:Func 2\nSubmit;[async];libtest.z.so+0x3000 1\n");
+    ASSERT_TRUE(EncodeSampleProfile(SAMPLE_PROFILE_PPROF, record, names, data));
+    ASSERT_FALSE(data.empty());
+    ASSERT_EQ(data[0], '\x0a'); // 0x0a: field 1, sample_type, length delimited
+    ASSERT_NE(data.find("snapshot_time"), std::string::npos);
+    ASSERT_FALSE(EncodeSampleProfile(-1, record, names, data));
+
+    InstallThreadSamplerTestSignal();
+    auto& sampler = ThreadSampler::GetInstance();
+    ASSERT_TRUE(sampler.Init(SAMPLE_CNT, false));
+    int waitSec = 1;
+    for (int i = 0; i < 2; i++) { // 2: samples
+        sampler.Sample();
+        WaitFewSec(waitSec);
+    }
+    ASSERT_TRUE(sampler.CollectProfile(SAMPLE_PROFILE_COLLAPSED, data));
+    printf("collapsed stacks:\n%s", data.c_str());
+    ASSERT_TRUE(sampler.CollectProfile(SAMPLE_PROFILE_PPROF, data));
+    printf("pprof profile:%zu bytes\n", data.size());
+#if defined(__aarch64__)
+    ASSERT_FALSE(data.empty());
+#endif
+    // the export symbolizes and encodes once and hands the profile to the writer whole
+    StreamedStack written;
+    ASSERT_EQ(ThreadSamplerCollectProfile(0, SAMPLE_PROFILE_COLLAPSED, AppendStreamedPiece, &written), 0);
+    ASSERT_EQ(written.pieces, 1);
+    ASSERT_EQ(ThreadSamplerCollectProfile(0, -1, AppendStreamedPiece, &written), -1);
+    ASSERT_EQ(ThreadSamplerCollectProfile(0, SAMPLE_PROFILE_COLLAPSED, nullptr, nullptr), -1);
+    sampler.Deinit();
+}
+
+/**
+ * @tc.name: ThreadSamplerTest_018
+ * @tc.desc: Stream the stacks through a writer and check they match the collected ones.
+ * @tc.type: FUNC
+ * @tc.require
+ */
+HWTEST_F(ThreadSamplerTest, ThreadSamplerTest_018, TestSize.Level3)
+{
+    printf("ThreadSamplerTest_018\n");
+    InstallThreadSamplerTestSignal();
+    auto& sampler = ThreadSampler::GetInstance();
+    ASSERT_TRUE(sampler.Init(SAMPLE_CNT, false));
+    ASSERT_EQ(ThreadSamplerCollectStream(0, 0, nullptr, nullptr), -1);
+    int waitSec = 1;
+    for (int i = 0; i < 3; i++) { // 3: samples
+        sampler.Sample();
+        WaitFewSec(waitSec);
+    }
+    std::string stack;
+    bool collected = sampler.CollectStack(stack, false);
+    StreamedStack streamed;
+    ASSERT_EQ(ThreadSamplerCollectStream(0, 0, AppendStreamedPiece, &streamed), collected ? 0 : -1);
+    printf("stack:%zu bytes in %d pieces\n", streamed.parts[0].size(), streamed.pieces);
+    ASSERT_EQ(streamed.parts[0], stack);
+    ASSERT_TRUE(streamed.parts[1].empty());
+    if (collected && streamed.pieces > 1) {
+        // the writer stops the collection at its first piece
+        StreamedStack stopped;
+        stopped.stopPiece = 1;
+        ASSERT_EQ(ThreadSamplerCollectStream(0, 0, AppendStreamedPiece, &stopped), -1);
+        ASSERT_EQ(stopped.pieces, 1);
+    }
+    sampler.Deinit();
+}
+
+/**
+ * @tc.name: ThreadSamplerTest_019
+ * @tc.desc: Frame pointer unwind of a thread whose lr is stale must give the same pcs as DWARF unwind.
+ * @tc.type: FUNC
+ * @tc.require
+ */
+HWTEST_F(ThreadSamplerTest, ThreadSamplerTest_019, TestSize.Level3)
+{
+    printf("ThreadSamplerTest_019\n");
+    InstallThreadSamplerTestSignal();
+
+    constexpr int sampleNum = 20;
+    size_t sampleCnt = 1;
+    ASSERT_TRUE(ThreadSampler::GetInstance().Init(sampleCnt, false));
+    std::atomic<int32_t> workerTid {0};
+    std::atomic<bool> stop {false};
+    std::thread worker([&workerTid, &stop, sampleCnt] {
+        workerTid = ThreadSampler::GetInstance().Init(sampleCnt, false, gettid()) ? gettid() : -1;
+        StaleLrSpin(stop);
+    });
+    while (workerTid == 0) {
+        usleep(MILLSEC_TO_MICROSEC);
+    }
+    ASSERT_GT(workerTid.load(), 0);
+    SampledThread* thread = ThreadSampler::GetInstance().FindThread(workerTid);
+    ASSERT_NE(thread, nullptr);
+    auto& sampler = ThreadSampler::GetInstance();
+
+    int compared = 0;
+    for (int i = 0; i < sampleNum; i++) {
+        sampler.SendSampleRequest(*thread);
+        ThreadUnwindContext* context = nullptr;
+        for (int retry = 0; retry < INTERVAL && context == nullptr; retry++) {
+            usleep(MILLSEC_TO_MICROSEC);
+            context = sampler.GetReadContext(*thread);
+        }
+        if (context == nullptr) {
+            continue;
+        }
+        std::vector<uintptr_t> fpPcs;
+        bool fpDone = DoFpUnwind(*context, sampler.maps_, fpPcs);
+        bool truncated = context->truncated;
+        UnwindInfo unwindInfo = {.context = context, .maps = sampler.maps_.get()};
+        DoUnwind(sampler.unwinder_, unwindInfo);
+        std::vector<uintptr_t> dwarfPcs = sampler.unwinder_->GetPcs();
+        sampler.ReleaseReadContext(*thread);
+        if (!fpDone || truncated) {
+            continue;
+        }
+        ASSERT_EQ(fpPcs, dwarfPcs);
+        compared++;
+    }
+    stop = true;
+    worker.join();
+#if defined(__aarch64__)
+    ASSERT_GT(compared, 0);
+#endif
+    sampler.Deinit();
+}
+
+/**
+ * @tc.name: ThreadSamplerTest_020
+ * @tc.desc: A sample whose sp is off the stack range is counted as dropped and its mapping looked up once.
+ * @tc.type: FUNC
+ * @tc.require
+ */
+HWTEST_F(ThreadSamplerTest, ThreadSamplerTest_020, TestSize.Level3)
+{
+    printf("ThreadSamplerTest_020\n");
+    auto& sampler = ThreadSampler::GetInstance();
+    ASSERT_TRUE(sampler.Init(SAMPLE_CNT, false));
+    SampledThread* thread = sampler.FindThread(getpid());
+    ASSERT_NE(thread, nullptr);
+    constexpr size_t altSize = 64 * 1024;
+    void* alt = mmap(nullptr, altSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    ASSERT_NE(alt, MAP_FAILED);
+    uintptr_t altBegin = reinterpret_cast<uintptr_t>(alt);
+    uintptr_t stackBegin = thread->stackBegin.load();
+
+    // an alternate stack does not extend the range, it is remembered so later samples skip the lookup
+    thread->straySp = altBegin + altSize / 2; // 2: the middle of the alternate stack
+    sampler.ProcessStackBuffer(*thread);
+#if defined(__aarch64__) || defined(__loongarch_lp64)
+    ASSERT_EQ(thread->straySp.load(), 0U);
+    ASSERT_EQ(thread->stackBegin.load(), stackBegin);
+    ASSERT_LE(thread->strayBegin, altBegin);
+    ASSERT_GE(thread->strayEnd, altBegin + altSize);
+#endif
+    munmap(alt, altSize);
+    sampler.Deinit();
+}
 }  // end of namespace HiviewDFX
 }  // end of namespace OHOS
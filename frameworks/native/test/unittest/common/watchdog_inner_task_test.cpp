@@ -14,21 +14,29 @@
  */
 
 #include <gtest/gtest.h>
+#include <atomic>
+#include <set>
 #include <string>
 #include <thread>
+#include <vector>
 #include <fstream>
 #include <fcntl.h>
 #include <sys/prctl.h>
+#include <sys/wait.h>
 #include <unistd.h>
 #include <dlfcn.h>
 #include <chrono>
+#include <cinttypes>
 #include <cstdio>
+#include <cstdlib>
+#include <new>
 
 #define private public
 #define protected public
 #include "watchdog_inner.h"
 #undef private
 #undef protected
+#include "watchdog_supervisor.h"
 
 #include "xcollie_define.h"
 #include "xcollie_utils.h"
@@ -38,6 +46,34 @@
 
 using namespace testing::ext;
 using namespace OHOS::AppExecFwk;
+
+namespace {
+thread_local bool g_countAllocation = false;
+std::atomic<size_t> g_allocationCount {0};
+}
+
+void* operator new(std::size_t size)
+{
+    if (g_countAllocation) {
+        g_allocationCount++;
+    }
+    void* ptr = malloc(size == 0 ? 1 : size);
+    if (ptr == nullptr) {
+        abort();
+    }
+    return ptr;
+}
+
+void operator delete(void* ptr) noexcept
+{
+    free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+    free(ptr);
+}
+
 namespace OHOS {
 namespace HiviewDFX {
 
@@ -104,6 +140,10 @@ HWTEST_F(WatchdogInnerTaskTest, WatchdogInnerTaskTest_RunPeriodicalTask_001, Tes
     auto taskFunc = [&taskResult]() { taskResult = 1; };
     std::string name = "RunPeriodicalTask_001";
     WatchdogInner::GetInstance().RunPeriodicalTask(name, taskFunc, 2000, 0);
+    {
+        std::unique_lock<std::mutex> lock(WatchdogInner::GetInstance().lock_);
+        WatchdogInner::GetInstance().DrainSubmitQueueLocked();
+    }
     ASSERT_TRUE(WatchdogInner::GetInstance().checkerQueue_.size() > 0);
     WatchdogInner::GetInstance().TriggerTimerCountTask(name, false, "test");
     WatchdogInner::GetInstance().TriggerTimerCountTask(name, true, "test");
@@ -134,13 +174,707 @@ HWTEST_F(WatchdogInnerTaskTest, WatchdogInnerTaskTest_FetchNextTask_001, TestSiz
     int id = WatchdogInner::GetInstance().InsertWatchdogTaskLocked(name, WatchdogTask(name, taskFunc,
         delay, interval, isOneshot));
     ASSERT_GT(id, 0);
+    WatchdogTask* fetchedTask = nullptr;
     WatchdogInner::GetInstance().isNeedStop_.store(true);
-    ASSERT_EQ(WatchdogInner::GetInstance().FetchNextTask(now, task), 60000);
+    ASSERT_EQ(WatchdogInner::GetInstance().FetchNextTask(now, fetchedTask), 60000);
     WatchdogInner::GetInstance().isNeedStop_.store(false);
     WatchdogTask task1;
-    ASSERT_EQ(WatchdogInner::GetInstance().FetchNextTask(now, task1), 60000);
+    ASSERT_EQ(WatchdogInner::GetInstance().FetchNextTask(now, fetchedTask), 60000);
     WatchdogTask task2("", taskFunc, delay, interval, isOneshot);
-    ASSERT_EQ(WatchdogInner::GetInstance().FetchNextTask(now, task1), 60000);
+    ASSERT_EQ(WatchdogInner::GetInstance().FetchNextTask(now, fetchedTask), 60000);
+}
+
+/**
+ * @tc.name: WatchdogInner SetTimer/CancelTimer throughput;
+ * @tc.desc: Measure RunXCollieTask/RemoveXCollieTask pairs with 16/64/128 queued tasks
+ * @tc.type: PERF
+ */
+HWTEST_F(WatchdogInnerTaskTest, WatchdogInnerTaskTest_TimerThroughput_001, TestSize.Level1)
+{
+    constexpr uint64_t longTimeout = 3600000; // 1h, never fire during the test
+    constexpr int loopCount = 10000;
+    const size_t queueSizes[] = {16, 64, 128};
+    for (size_t queueSize : queueSizes) {
+        std::vector<int64_t> prefillIds;
+        for (size_t i = 0; i + 1 < queueSize; i++) {
+            int64_t id = WatchdogInner::GetInstance().RunXCollieTask("TimerThroughput_prefill",
+                longTimeout + i, nullptr, nullptr, XCOLLIE_FLAG_NOOP);
+            if (id > 0) {
+                prefillIds.push_back(id);
+            }
+        }
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < loopCount; i++) {
+            int64_t id = WatchdogInner::GetInstance().RunXCollieTask("TimerThroughput",
+                longTimeout, nullptr, nullptr, XCOLLIE_FLAG_NOOP);
+            WatchdogInner::GetInstance().RemoveXCollieTask(id);
+        }
+        {
+            std::unique_lock<std::mutex> lock(WatchdogInner::GetInstance().lock_);
+            WatchdogInner::GetInstance().DrainSubmitQueueLocked();
+        }
+        auto costUs = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start).count();
+        double opsPerSec = costUs > 0 ? static_cast<double>(loopCount) * 1000000 / costUs : 0;
+        printf("queued tasks: %zu, SetTimer/CancelTimer pairs per second: %.0f\n", queueSize, opsPerSec);
+        for (int64_t id : prefillIds) {
+            WatchdogInner::GetInstance().RemoveXCollieTask(id);
+        }
+        {
+            std::unique_lock<std::mutex> lock(WatchdogInner::GetInstance().lock_);
+            WatchdogInner::GetInstance().DrainSubmitQueueLocked();
+        }
+        ASSERT_GT(opsPerSec, 0);
+    }
+}
+
+/**
+ * @tc.name: WatchdogTimerWheel arm, cancel and expire
+ * @tc.desc: Verify timers expire in time order, cancelled timers never fire
+ * @tc.type: FUNC
+ */
+HWTEST_F(WatchdogInnerTaskTest, WatchdogInnerTaskTest_TimerWheel_001, TestSize.Level1)
+{
+    WatchdogTimerWheel wheel;
+    uint64_t now = 1000;
+    ASSERT_EQ(wheel.NextTimeout(), UINT64_MAX);
+    const uint64_t delays[] = {5, 70, 5000, 300000};
+    std::vector<int64_t> ids;
+    for (uint64_t delay : delays) {
+        WatchdogTask task;
+        task.id = static_cast<int64_t>(ids.size() + 1);
+        task.nextTickTime = now + delay;
+        ids.push_back(task.id);
+        wheel.Add(std::move(task), now);
+    }
+    ASSERT_EQ(wheel.Size(), 4);
+    ASSERT_LE(wheel.NextTimeout(), 5);
+    ASSERT_TRUE(wheel.Remove(ids[1]));
+    ASSERT_FALSE(wheel.Remove(ids[1]));
+
+    WatchdogTask expired;
+    std::vector<int64_t> fired;
+    while (!wheel.Empty()) {
+        uint64_t timeout = wheel.NextTimeout();
+        ASSERT_GT(timeout, 0);
+        now += timeout;
+        wheel.Update(now);
+        while (wheel.PopExpired(expired)) {
+            ASSERT_LE(expired.nextTickTime, now);
+            fired.push_back(expired.id);
+        }
+    }
+    ASSERT_EQ(fired.size(), 3);
+    ASSERT_EQ(fired[0], ids[0]);
+    ASSERT_EQ(fired[1], ids[2]);
+    ASSERT_EQ(fired[2], ids[3]);
+    ASSERT_EQ(now, 1000 + delays[3]);
+}
+
+/**
+ * @tc.name: WatchdogInner timer counter ring
+ * @tc.desc: Verify timer count windows, reset and concurrent triggers through the registry
+ * @tc.type: FUNC
+ */
+HWTEST_F(WatchdogInnerTaskTest, WatchdogInnerTaskTest_TimerCounter_001, TestSize.Level1)
+{
+    TimerCounter counter(1000, 3);
+    uint64_t interval = 0;
+    counter.Trigger(100, "first");
+    counter.Trigger(1100, "second");
+    counter.Trigger(2100, "third");
+    ASSERT_FALSE(counter.Check(interval));
+    counter.Trigger(2200, "fourth");
+    counter.Trigger(2300, "fifth");
+    ASSERT_TRUE(counter.Check(interval));
+    ASSERT_EQ(interval, 200);
+    ASSERT_EQ(counter.GetMessage(), "fifth");
+    ASSERT_FALSE(counter.Check(interval));
+
+    counter.Trigger(3000, "");
+    counter.Trigger(3001, "");
+    counter.Reset();
+    counter.Trigger(3002, "");
+    ASSERT_FALSE(counter.Check(interval));
+
+    std::string name = "TimerCounter_001";
+    ASSERT_GT(WatchdogInner::GetInstance().SetTimerCountTask(name, 60000, 100), 0);
+    const int threadNum = 8;
+    std::vector<std::thread> threads;
+    for (int i = 0; i < threadNum; i++) {
+        threads.emplace_back([&name]() {
+            for (int j = 0; j < 1000; j++) {
+                WatchdogInner::GetInstance().TriggerTimerCountTask(name, true, "burst");
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    ASSERT_TRUE(WatchdogInner::GetInstance().RemoveInnerTask(name));
+    // the counter is gone together with its task
+    WatchdogInner::GetInstance().TriggerTimerCountTask(name, true, "after remove");
+    ASSERT_GT(WatchdogInner::GetInstance().SetTimerCountTask(name, 60000, 100), 0);
+    ASSERT_TRUE(WatchdogInner::GetInstance().RemoveInnerTask(name));
+}
+
+/**
+ * @tc.name: WatchdogInner task slack coalescing
+ * @tc.desc: Verify the scheduler sleeps until the first task runs out of slack and then runs every due task
+ * @tc.type: FUNC
+ */
+HWTEST_F(WatchdogInnerTaskTest, WatchdogInnerTaskTest_TaskSlack_001, TestSize.Level1)
+{
+    WatchdogTaskQueue queue;
+    ASSERT_EQ(queue.EarliestDeadline(), UINT64_MAX);
+    const uint64_t ticks[] = {1000, 1020, 1100, 2000};
+    const uint64_t slacks[] = {50, 5, 0, 1000};
+    for (size_t i = 0; i < sizeof(ticks) / sizeof(ticks[0]); i++) {
+        WatchdogTask task;
+        task.id = static_cast<int64_t>(i + 1);
+        task.nextTickTime = ticks[i];
+        task.slack = slacks[i];
+        queue.push(std::move(task));
+    }
+    // the second task closes its window first, the first one joins its wakeup
+    ASSERT_EQ(queue.EarliestDeadline(), 1025);
+    uint64_t now = queue.EarliestDeadline();
+    int runInWakeup = 0;
+    while (!queue.empty() && queue.top().nextTickTime <= now) {
+        queue.pop();
+        runInWakeup++;
+    }
+    ASSERT_EQ(runInWakeup, 2);
+    ASSERT_EQ(queue.EarliestDeadline(), 1100);
+
+    // no slack unless the task opts in
+    WatchdogTask periodic("TaskSlack_001", [] {}, 0, 3000, false);
+    ASSERT_EQ(periodic.slack, 0);
+    periodic.AllowSlack();
+    ASSERT_EQ(periodic.slack, 300);
+    WatchdogTask oneshot("TaskSlack_001", [] {}, 0, 3000, true);
+    oneshot.AllowSlack();
+    ASSERT_EQ(oneshot.slack, 0);
+    printf("watchdog wakeups: %" PRIu64 ", per minute: %" PRIu64 "\n",
+        WatchdogInner::GetInstance().GetWakeupCount(), WatchdogInner::GetInstance().GetWakeupsPerMinute());
+}
+
+/**
+ * @tc.name: WatchdogInner timer lateness with reports in flight
+ * @tc.desc: Verify slow fault reports posted by the watchdog thread do not delay the timers behind them
+ * @tc.type: FUNC
+ */
+HWTEST_F(WatchdogInnerTaskTest, WatchdogInnerTaskTest_ReportLateness_001, TestSize.Level1)
+{
+    constexpr int reportNum = 4;
+    constexpr uint64_t reportCostMs = 300;
+    constexpr int timerNum = 10;
+    constexpr uint64_t timerStepMs = 50;
+    WatchdogInner::GetInstance().RunOneShotTask("ReportLateness_001_report", [] {
+        for (int i = 0; i < reportNum; i++) {
+            WatchdogInner::GetInstance().PostReport([] {
+                std::this_thread::sleep_for(std::chrono::milliseconds(reportCostMs));
+            });
+        }
+    }, 0);
+
+    struct LatenessState {
+        std::atomic<int> fired {0};
+        std::atomic<uint64_t> maxLateness {0};
+    };
+    auto state = std::make_shared<LatenessState>();
+    uint64_t begin = GetCurrentTickMillseconds();
+    for (int i = 0; i < timerNum; i++) {
+        uint64_t delay = timerStepMs * static_cast<uint64_t>(i + 1);
+        uint64_t expect = begin + delay;
+        WatchdogInner::GetInstance().RunOneShotTask("ReportLateness_001_" + std::to_string(i), [state, expect] {
+            uint64_t now = GetCurrentTickMillseconds();
+            uint64_t lateness = (now > expect) ? now - expect : 0;
+            uint64_t maxLateness = state->maxLateness.load();
+            while (lateness > maxLateness && !state->maxLateness.compare_exchange_weak(maxLateness, lateness)) {
+            }
+            state->fired++;
+        }, delay);
+    }
+
+    uint64_t deadline = begin + timerStepMs * timerNum + reportNum * reportCostMs;
+    while (state->fired.load() < timerNum && GetCurrentTickMillseconds() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    ASSERT_EQ(state->fired.load(), timerNum);
+    printf("max timer lateness with %d reports in flight: %" PRIu64 " ms\n", reportNum, state->maxLateness.load());
+    ASSERT_LT(state->maxLateness.load(), reportCostMs);
+    ASSERT_TRUE(WatchdogInner::GetInstance().reportQueue_.Flush(reportNum * reportCostMs));
+}
+
+/**
+ * @tc.name: WatchdogInner exit job
+ * @tc.desc: Verify an exit job runs after the reports posted before it and does not hold up the ones after it
+ * @tc.type: FUNC
+ */
+HWTEST_F(WatchdogInnerTaskTest, WatchdogInnerTaskTest_ExitJob_001, TestSize.Level1)
+{
+    constexpr uint64_t reportCostMs = 100;
+    constexpr uint64_t exitCostMs = 1000;
+    struct ExitState {
+        std::atomic<bool> reported {false};
+        std::atomic<bool> reportedBeforeExit {false};
+        std::atomic<bool> exitDone {false};
+        std::atomic<bool> laterReported {false};
+    };
+    auto state = std::make_shared<ExitState>();
+    WatchdogInner& inner = WatchdogInner::GetInstance();
+    inner.PostReport([state] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(reportCostMs));
+        state->reported = true;
+    });
+    inner.PostExitJob([state] {
+        state->reportedBeforeExit = state->reported.load();
+        std::this_thread::sleep_for(std::chrono::milliseconds(exitCostMs));
+        state->exitDone = true;
+    });
+    inner.PostReport([state] {
+        state->laterReported = true;
+    });
+    ASSERT_TRUE(inner.reportQueue_.Flush(exitCostMs / 2)); // 2: well before the exit job is done
+    ASSERT_TRUE(state->laterReported.load());
+    ASSERT_FALSE(state->exitDone.load());
+    while (!state->exitDone.load()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    ASSERT_TRUE(state->reportedBeforeExit.load());
+}
+
+/**
+ * @tc.name: WatchdogReportQueue overflow and restart
+ * @tc.desc: Verify posts past the capacity and after Stop still run in order on a report thread
+ * @tc.type: FUNC
+ */
+HWTEST_F(WatchdogInnerTaskTest, WatchdogInnerTaskTest_ReportQueue_001, TestSize.Level1)
+{
+    constexpr size_t capacity = 2;
+    constexpr int jobNum = 6;
+    constexpr uint64_t flushTimeoutMs = 1000;
+    struct QueueState {
+        std::mutex lock;
+        std::vector<int> order;
+        std::atomic<bool> released {false};
+        std::atomic<bool> onCaller {false};
+    };
+    auto state = std::make_shared<QueueState>();
+    std::thread::id caller = std::this_thread::get_id();
+    WatchdogReportQueue queue(capacity);
+    queue.Post([state] {
+        while (!state->released.load()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    });
+    for (int i = 0; i < jobNum; i++) {
+        queue.Post([state, caller, i] {
+            state->onCaller = state->onCaller.load() || std::this_thread::get_id() == caller;
+            std::lock_guard<std::mutex> lock(state->lock);
+            state->order.push_back(i);
+        });
+    }
+    ASSERT_GT(queue.OverflowCount(), 0);
+    state->released = true;
+    ASSERT_TRUE(queue.Flush(flushTimeoutMs));
+    queue.Stop();
+    queue.Post([state, caller] {
+        state->onCaller = state->onCaller.load() || std::this_thread::get_id() == caller;
+        std::lock_guard<std::mutex> lock(state->lock);
+        state->order.push_back(jobNum);
+    });
+    ASSERT_TRUE(queue.Flush(flushTimeoutMs));
+    queue.Stop();
+    ASSERT_FALSE(state->onCaller.load());
+    ASSERT_EQ(state->order.size(), static_cast<size_t>(jobNum + 1));
+    for (int i = 0; i <= jobNum; i++) {
+        ASSERT_EQ(state->order[i], i);
+    }
+}
+
+/**
+ * @tc.name: WatchdogInner batched dispatch
+ * @tc.desc: Compare lock acquisitions and dispatch latency of per task and batched dispatch for 100 due tasks
+ * @tc.type: PERF
+ */
+HWTEST_F(WatchdogInnerTaskTest, WatchdogInnerTaskTest_BatchDispatch_001, TestSize.Level1)
+{
+    constexpr int taskNum = 100;
+    constexpr uint64_t dueDelay = 200;
+    struct DispatchState {
+        std::atomic<int> done {0};
+        std::atomic<int64_t> runUs[taskNum] {};
+    };
+    struct DispatchResult {
+        uint64_t lockCount;
+        int64_t spreadUs;
+    };
+    auto measure = [](bool isBatch) {
+        WatchdogInner& inner = WatchdogInner::GetInstance();
+        inner.isBatchDispatch_.store(isBatch);
+        auto state = std::make_shared<DispatchState>();
+        uint64_t due = GetCurrentTickMillseconds() + dueDelay;
+        {
+            std::unique_lock<std::mutex> lock(inner.lock_);
+            for (int i = 0; i < taskNum; i++) {
+                std::string name = "BatchDispatch_001_" + std::to_string(i);
+                WatchdogTask task(name, [state, i] {
+                    state->runUs[i] = std::chrono::duration_cast<std::chrono::microseconds>(
+                        std::chrono::steady_clock::now().time_since_epoch()).count();
+                    state->done++;
+                }, 0, 0, true);
+                task.nextTickTime = due;
+                inner.InsertWatchdogTaskLocked(name, std::move(task));
+            }
+        }
+        while (GetCurrentTickMillseconds() + dueDelay / 4 < due) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        uint64_t lockBefore = inner.dispatchLockCount_.load();
+        uint64_t deadline = due + dueDelay * 10;
+        while (state->done.load() < taskNum && GetCurrentTickMillseconds() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        DispatchResult result {inner.dispatchLockCount_.load() - lockBefore, 0};
+        int64_t first = INT64_MAX;
+        int64_t last = 0;
+        for (int i = 0; i < taskNum; i++) {
+            first = std::min(first, state->runUs[i].load());
+            last = std::max(last, state->runUs[i].load());
+        }
+        result.spreadUs = last - first;
+        EXPECT_EQ(state->done.load(), taskNum);
+        return result;
+    };
+    DispatchResult single = measure(false);
+    DispatchResult batch = measure(true);
+    printf("100 due tasks, per task dispatch: %" PRIu64 " lock acquisitions, %" PRId64 " us first to last\n",
+        single.lockCount, single.spreadUs);
+    printf("100 due tasks, batched dispatch: %" PRIu64 " lock acquisitions, %" PRId64 " us first to last\n",
+        batch.lockCount, batch.spreadUs);
+    ASSERT_TRUE(WatchdogInner::GetInstance().isBatchDispatch_.load());
+    ASSERT_GE(single.lockCount, static_cast<uint64_t>(taskNum * 2));
+    ASSERT_LT(batch.lockCount, single.lockCount);
+}
+
+/**
+ * @tc.name: WatchdogInner concurrent timer submission
+ * @tc.desc: Verify SetTimer/CancelTimer from many threads yield unique ids and leave no armed timer
+ * @tc.type: FUNC
+ */
+HWTEST_F(WatchdogInnerTaskTest, WatchdogInnerTaskTest_SubmitQueue_001, TestSize.Level1)
+{
+    constexpr int threadNum = 32;
+    constexpr int loopCount = 200;
+    constexpr uint64_t longTimeout = 3600000;
+    std::vector<std::vector<int64_t>> threadIds(threadNum);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < threadNum; i++) {
+        threads.emplace_back([&ids = threadIds[i]]() {
+            for (int j = 0; j < loopCount; j++) {
+                int64_t id = WatchdogInner::GetInstance().RunXCollieTask("SubmitQueue_001",
+                    longTimeout, nullptr, nullptr, XCOLLIE_FLAG_NOOP);
+                ids.push_back(id);
+                WatchdogInner::GetInstance().RemoveXCollieTask(id);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    std::set<int64_t> allIds;
+    for (const auto& ids : threadIds) {
+        for (int64_t id : ids) {
+            ASSERT_GT(id, 0);
+            allIds.insert(id);
+        }
+    }
+    ASSERT_EQ(allIds.size(), static_cast<size_t>(threadNum * loopCount));
+    std::unique_lock<std::mutex> lock(WatchdogInner::GetInstance().lock_);
+    WatchdogInner::GetInstance().DrainSubmitQueueLocked();
+    ASSERT_TRUE(WatchdogInner::GetInstance().submitQueue_.Empty());
+    ASSERT_EQ(WatchdogInner::GetInstance().timerWheel_.Size(), 0);
+}
+
+/**
+ * @tc.name: WatchdogSubmitQueue claim order
+ * @tc.desc: Verify a cancel published behind a claimed but unpublished arm is never popped first
+ * @tc.type: FUNC
+ */
+HWTEST_F(WatchdogInnerTaskTest, WatchdogInnerTaskTest_SubmitQueue_002, TestSize.Level1)
+{
+    constexpr int64_t timerId = 42;
+    WatchdogSubmitQueue queue(4);
+    // claim the first cell the way Push does, but hold back its publication
+    uint64_t claimed = queue.enqueuePos_.fetch_add(1);
+    SubmitCommand cancel;
+    cancel.type = SubmitType::CANCEL_TIMER;
+    cancel.id = timerId;
+    ASSERT_TRUE(queue.Push(std::move(cancel)));
+    std::thread publisher([&queue, claimed]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        auto& cell = queue.cells_[claimed & queue.mask_];
+        cell.command.type = SubmitType::ARM_TIMER;
+        cell.command.id = timerId;
+        cell.sequence.store(claimed + 1, std::memory_order_release);
+    });
+    SubmitCommand first;
+    SubmitCommand second;
+    bool popFirst = queue.Pop(first);
+    bool popSecond = queue.Pop(second);
+    publisher.join();
+    ASSERT_TRUE(popFirst);
+    ASSERT_EQ(first.type, SubmitType::ARM_TIMER);
+    ASSERT_TRUE(popSecond);
+    ASSERT_EQ(second.type, SubmitType::CANCEL_TIMER);
+    ASSERT_EQ(second.id, timerId);
+    ASSERT_TRUE(queue.Empty());
+}
+
+/**
+ * @tc.name: WatchdogTaskQueue steady state allocation
+ * @tc.desc: Verify acquiring, running and requeueing periodic tasks allocates nothing
+ * @tc.type: FUNC
+ */
+HWTEST_F(WatchdogInnerTaskTest, WatchdogInnerTaskTest_SteadyStateAllocation_001, TestSize.Level1)
+{
+    constexpr int taskNum = 16;
+    constexpr int tickCount = 1000;
+    constexpr uint64_t interval = 3000;
+    WatchdogTaskQueue queue;
+    int runCount = 0;
+    for (int i = 0; i < taskNum; i++) {
+        queue.push(WatchdogTask("SteadyState_" + std::to_string(i), [&runCount]() { runCount++; },
+            0, interval, false));
+    }
+    g_allocationCount = 0;
+    g_countAllocation = true;
+    for (int i = 0; i < tickCount; i++) {
+        WatchdogTask* task = queue.Acquire();
+        if (task == nullptr) {
+            break;
+        }
+        task->Run(task->nextTickTime);
+        task->nextTickTime += task->checkInterval;
+        queue.Requeue(task);
+    }
+    g_countAllocation = false;
+    ASSERT_EQ(runCount, tickCount);
+    ASSERT_EQ(queue.size(), static_cast<size_t>(taskNum));
+    ASSERT_EQ(g_allocationCount.load(), 0);
+}
+/**
+ * @tc.name: LatencyHistogram percentiles
+ * @tc.desc: Verify bucket bounds and percentiles stay within the relative error of the layout
+ * @tc.type: FUNC
+ */
+HWTEST_F(WatchdogInnerTaskTest, WatchdogInnerTaskTest_SchedulerStats_001, TestSize.Level1)
+{
+    for (uint64_t value = 0; value < (1ULL << LatencyHistogram::MAX_VALUE_BITS); value = value * 2 + 1) {
+        uint32_t index = LatencyHistogram::BucketIndex(value);
+        ASSERT_LT(index, LatencyHistogram::BUCKET_NUM);
+        ASSERT_GE(LatencyHistogram::BucketUpperBound(index), value);
+        if (index > 0) {
+            ASSERT_LT(LatencyHistogram::BucketUpperBound(index - 1), value);
+        }
+    }
+    ASSERT_EQ(LatencyHistogram::BucketIndex(UINT64_MAX), LatencyHistogram::BUCKET_NUM - 1);
+
+    constexpr uint64_t valueNum = 10000;
+    auto histogram = std::make_unique<LatencyHistogram>();
+    ASSERT_EQ(histogram->Percentile(0.99), 0);
+    for (uint64_t value = 1; value <= valueNum; value++) {
+        histogram->Record(value);
+    }
+    LatencyHistogram::Summary summary = histogram->GetSummary();
+    ASSERT_EQ(summary.count, valueNum);
+    ASSERT_EQ(summary.max, valueNum);
+    uint64_t maxError = valueNum / LatencyHistogram::SUB_BUCKET_NUM;
+    ASSERT_GE(summary.p50, valueNum / 2);
+    ASSERT_LE(summary.p50, valueNum / 2 + maxError);
+    ASSERT_GE(summary.p99, valueNum * 99 / 100);
+    ASSERT_LE(summary.p99, valueNum);
+
+    auto stats = std::make_unique<WatchdogSchedulerStats>();
+    stats->Record(WatchdogTaskClass::GENERAL_TASK, "SchedulerStats_\"001", 100, 2000);
+    LatencyHistogram::Summary lateness;
+    LatencyHistogram::Summary runTime;
+    ASSERT_TRUE(stats->GetNamedSummary("SchedulerStats_\"001", lateness, runTime));
+    ASSERT_EQ(lateness.max, 100);
+    ASSERT_EQ(runTime.max, 2000);
+    std::string json = stats->Dump(true, {{"wakeups", 1}});
+    ASSERT_NE(json.find("\"name\":\"SchedulerStats_\\\"001\""), std::string::npos);
+    ASSERT_NE(json.find("\"wakeups\":1"), std::string::npos);
+    ASSERT_EQ(json.back(), '}');
+}
+
+/**
+ * @tc.name: WatchdogInner scheduler stats dump
+ * @tc.desc: Verify tasks run by the watchdog thread are recorded and show up in both dump forms
+ * @tc.type: FUNC
+ */
+HWTEST_F(WatchdogInnerTaskTest, WatchdogInnerTaskTest_SchedulerStats_002, TestSize.Level1)
+{
+    constexpr uint64_t runCostMs = 5;
+    const TaskLatencyStats& classStats =
+        WatchdogInner::GetInstance().schedulerStats_.GetClassStats(WatchdogTaskClass::GENERAL_TASK);
+    uint64_t countBefore = classStats.runTime.GetSummary().count;
+    std::atomic<bool> isRun {false};
+    WatchdogInner::GetInstance().RunOneShotTask("SchedulerStats_002", [&isRun] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(runCostMs));
+        isRun = true;
+    }, 0);
+    uint64_t deadline = GetCurrentTickMillseconds() + 1000; // 1000: wait at most one second
+    while (!isRun.load() && GetCurrentTickMillseconds() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    ASSERT_TRUE(isRun.load());
+    LatencyHistogram::Summary runTime = classStats.runTime.GetSummary();
+    ASSERT_GT(runTime.count, countBefore);
+    ASSERT_GE(runTime.max, runCostMs * TO_MILLISECOND_MULTPLE);
+
+    std::string text = WatchdogInner::GetInstance().DumpSchedulerStats(false);
+    printf("%s", text.c_str());
+    ASSERT_NE(text.find("class GENERAL_TASK"), std::string::npos);
+    ASSERT_NE(text.find("wakeupsPerMinute:"), std::string::npos);
+    std::string json = WatchdogInner::GetInstance().DumpSchedulerStats(true);
+    ASSERT_EQ(json.front(), '{');
+    ASSERT_NE(json.find("\"GENERAL_TASK\":{\"lateness\":{\"count\":"), std::string::npos);
+}
+
+/**
+ * @tc.name: WatchdogInner shared region
+ * @tc.desc: Verify a supervisor fires due timers once, skips released ones and reports a stuck heartbeat
+ * @tc.type: FUNC
+ */
+HWTEST_F(WatchdogInnerTaskTest, WatchdogInnerTaskTest_SharedRegion_001, TestSize.Level1)
+{
+    WatchdogSharedRegion region;
+    ASSERT_TRUE(region.Create(8)); // 8: slot count
+    uint64_t heartbeatGen = 0;
+    int32_t heartbeatSlot = region.Reserve(heartbeatGen);
+    ASSERT_GE(heartbeatSlot, 0);
+    uint64_t firedGen = 0;
+    int32_t firedSlot = region.Arm(SharedSlotKind::TIMER, "SharedRegion_fired", 100, 0, firedGen);
+    uint64_t releasedGen = 0;
+    int32_t releasedSlot = region.Arm(SharedSlotKind::TIMER, "SharedRegion_released", 100, 0, releasedGen);
+    ASSERT_GE(firedSlot, 0);
+    ASSERT_GE(releasedSlot, 0);
+    region.Publish(heartbeatSlot, heartbeatGen, SharedSlotKind::HEARTBEAT, "SharedRegion_main", 0, 1000);
+
+    WatchdogSupervisor supervisor;
+    ASSERT_EQ(supervisor.AddProcess(region.GetFd()), getpid());
+    ASSERT_TRUE(region.Release(releasedSlot, releasedGen));
+    std::vector<SupervisorFault> faults;
+    supervisor.Scan(99, faults);
+    ASSERT_TRUE(faults.empty());
+    supervisor.Scan(150, faults);
+    supervisor.Scan(200, faults);
+    ASSERT_EQ(faults.size(), 1);
+    ASSERT_EQ(faults[0].name, "SharedRegion_fired");
+    ASSERT_EQ(faults[0].overdue, 50);
+    // the owner handles the fault, a late release of the same timer does nothing
+    ASSERT_TRUE(region.Transit(firedSlot, firedGen, SLOT_FIRED, SLOT_HANDLING));
+    ASSERT_FALSE(region.Release(firedSlot, firedGen));
+    ASSERT_TRUE(region.Finish(firedSlot, firedGen));
+
+    faults.clear();
+    region.GetHeartbeat(heartbeatSlot)->BeginEvent();
+    supervisor.Scan(1000, faults);
+    supervisor.Scan(1499, faults);
+    ASSERT_TRUE(faults.empty());
+    supervisor.Scan(1500, faults);
+    supervisor.Scan(2000, faults);
+    supervisor.Scan(3000, faults);
+    ASSERT_EQ(faults.size(), 2);
+    ASSERT_EQ(faults[0].waitState, CheckStatus::WAITED_HALF);
+    ASSERT_EQ(faults[1].waitState, CheckStatus::WAITING);
+    region.GetHeartbeat(heartbeatSlot)->EndEvent();
+    supervisor.Scan(4000, faults);
+    supervisor.Scan(9000, faults);
+    ASSERT_EQ(faults.size(), 2);
+}
+
+/**
+ * @tc.name: WatchdogInner shared region
+ * @tc.desc: Verify slots armed by another process are seen through the same fd, and reuse bumps the generation
+ * @tc.type: FUNC
+ */
+HWTEST_F(WatchdogInnerTaskTest, WatchdogInnerTaskTest_SharedRegion_002, TestSize.Level1)
+{
+    WatchdogSharedRegion region;
+    ASSERT_TRUE(region.Create(2)); // 2: slot count
+    WatchdogSupervisor supervisor;
+    ASSERT_EQ(supervisor.AddProcess(region.GetFd()), getpid());
+    pid_t pid = fork();
+    if (pid == 0) {
+        uint64_t generation = 0;
+        _exit(region.Arm(SharedSlotKind::TIMER, "SharedRegion_child", 10, 0, generation) >= 0 ? 0 : 1);
+    }
+    ASSERT_GT(pid, 0);
+    int status = 0;
+    ASSERT_EQ(waitpid(pid, &status, 0), pid);
+    ASSERT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    std::vector<SupervisorFault> faults;
+    supervisor.Scan(20, faults);
+    ASSERT_EQ(faults.size(), 1);
+    ASSERT_EQ(faults[0].name, "SharedRegion_child");
+    ASSERT_EQ(faults[0].generation, 1);
+
+    WatchdogSharedRegion owner;
+    ASSERT_TRUE(owner.Create(1));
+    uint64_t generation = 0;
+    int32_t slot = owner.Arm(SharedSlotKind::TIMER, "SharedRegion_reuse", 10, 0, generation);
+    ASSERT_EQ(slot, 0);
+    ASSERT_EQ(owner.Arm(SharedSlotKind::TIMER, "SharedRegion_full", 10, 0, generation), -1);
+    ASSERT_TRUE(owner.Release(slot, 1));
+    ASSERT_EQ(owner.Arm(SharedSlotKind::TIMER, "SharedRegion_reuse", 10, 0, generation), 0);
+    ASSERT_EQ(generation, 2);
+    ASSERT_FALSE(owner.Release(slot, 1));
+
+    WatchdogSharedRegion unknown;
+    ASSERT_FALSE(unknown.Attach(-1));
+}
+
+/**
+ * @tc.name: WatchdogInner supervised mode
+ * @tc.desc: Verify supervised mode is refused once the watchdog thread runs, and stale faults are ignored
+ * @tc.type: FUNC
+ */
+HWTEST_F(WatchdogInnerTaskTest, WatchdogInnerTaskTest_SupervisedMode_001, TestSize.Level1)
+{
+    WatchdogInner::GetInstance().RunOneShotTask("SupervisedMode_001", [] {}, 0);
+    if (WatchdogInner::GetInstance().sharedRegion_ == nullptr) {
+        ASSERT_EQ(WatchdogInner::GetInstance().EnableSupervisedMode(8), -1); // 8: slot count
+        ASSERT_FALSE(WatchdogInner::GetInstance().HandleSupervisorFault(0, 1, CheckStatus::WAITING));
+        // a refused switch leaves the main looper beating into its own slot
+        WatchdogInner& inner = WatchdogInner::GetInstance();
+        ASSERT_EQ(inner.mainBeat_.load(), inner.localHeartbeat_.get());
+        ASSERT_EQ(std::atomic_load(&inner.mainHeartbeat_), inner.localHeartbeat_);
+    }
+}
+
+/**
+ * @tc.name: WatchdogInner probe latency dump
+ * @tc.desc: Verify the probes of a watched handler show up in both dump forms
+ * @tc.type: FUNC
+ */
+HWTEST_F(WatchdogInnerTaskTest, WatchdogInnerTaskTest_ProbeLatency_001, TestSize.Level1)
+{
+    auto runner = EventRunner::Create("ProbeLatency_001");
+    auto handler = std::make_shared<EventHandler>(runner);
+    ASSERT_EQ(WatchdogInner::GetInstance().AddThread("ProbeLatency_001", handler, nullptr, 100), 0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(350));
+    std::string text = WatchdogInner::GetInstance().DumpProbeLatency(false);
+    printf("%s", text.c_str());
+    ASSERT_NE(text.find("handler ProbeLatency_001 pending(us):"), std::string::npos);
+    std::string json = WatchdogInner::GetInstance().DumpProbeLatency(true);
+    ASSERT_NE(json.find("{\"name\":\"ProbeLatency_001\",\"pending\":"), std::string::npos);
+    ASSERT_EQ(json.back(), '}');
+    ASSERT_TRUE(WatchdogInner::GetInstance().RemoveInnerTask("ProbeLatency_001"));
 }
 } // namespace HiviewDFX
 } // namespace OHOS
@@ -15,10 +15,12 @@
 
 #include <gtest/gtest.h>
 #include <string>
+#include <vector>
 #include <thread>
 #include <fstream>
 #include <fcntl.h>
 #include <sys/prctl.h>
+#include <sys/wait.h>
 #include <unistd.h>
 #include <dlfcn.h>
 #include <chrono>
@@ -116,15 +118,48 @@ HWTEST_F(WatchdogInnerTest, WatchdogInnerTest_TriggerTimerCountTask_001, TestSiz
 
 /**
  * @tc.name: WatchdogInner is exceedMaxTaskLocked;
- * @tc.desc: Verify whether checkerQueue_ is over MAX_WATCH_NUM;
+ * @tc.desc: Verify whether handler checks in checkerQueue_ are over MAX_WATCH_NUM;
  * @tc.type: FUNC
  */
 HWTEST_F(WatchdogInnerTest, WatchdogInnerTest_IsExceedMaxTaskLocked_001, TestSize.Level1)
 {
-    bool ret = WatchdogInner::GetInstance().IsExceedMaxTaskLocked();
+    bool ret = WatchdogInner::GetInstance().IsExceedMaxTaskLocked(WatchdogTaskClass::HANDLER_CHECK);
     ASSERT_EQ(ret, false);
 }
 
+/**
+ * @tc.name: WatchdogInner task class quota;
+ * @tc.desc: Verify XCollie timers are limited by their own quota and do not consume the handler check quota;
+ * @tc.type: FUNC
+ */
+HWTEST_F(WatchdogInnerTest, WatchdogInnerTest_TaskClassQuota_001, TestSize.Level1)
+{
+    constexpr uint64_t longTimeout = 3600000;
+    auto& inner = WatchdogInner::GetInstance();
+    uint64_t rejectedBefore = inner.GetRejectedTaskCount(WatchdogTaskClass::XCOLLIE_TIMER);
+    size_t timerNumBefore = inner.xcollieTimerNum_.load();
+    std::vector<int64_t> ids;
+    for (unsigned int i = 0; i < MAX_XCOLLIE_TIMER_NUM + 1; i++) {
+        int64_t id = inner.RunXCollieTask("TaskClassQuota_001", longTimeout, nullptr, nullptr, XCOLLIE_FLAG_NOOP);
+        if (id > 0) {
+            ids.push_back(id);
+        }
+    }
+    ASSERT_LE(ids.size(), static_cast<size_t>(MAX_XCOLLIE_TIMER_NUM));
+    ASSERT_GT(inner.GetRejectedTaskCount(WatchdogTaskClass::XCOLLIE_TIMER), rejectedBefore);
+    {
+        std::unique_lock<std::mutex> lock(inner.lock_);
+        inner.DrainSubmitQueueLocked();
+        ASSERT_FALSE(inner.IsExceedMaxTaskLocked(WatchdogTaskClass::HANDLER_CHECK));
+    }
+    for (int64_t id : ids) {
+        inner.RemoveXCollieTask(id);
+    }
+    std::unique_lock<std::mutex> lock(inner.lock_);
+    inner.DrainSubmitQueueLocked();
+    ASSERT_EQ(inner.xcollieTimerNum_.load(), timerNumBefore);
+}
+
 /**
  * @tc.name: WatchdogInner FfrtCallback Test;
  * @tc.desc: add teatcase
@@ -430,6 +465,61 @@ HWTEST_F(WatchdogInnerTest, WatchdogInnerTest_GetProcNameFromProcCmdline_001, Te
     EXPECT_TRUE(procName1 == procName3);
 }
 
+/**
+ * @tc.name: WatchdogInner process identity cache;
+ * @tc.desc: Verify SetTimer reads nothing from /proc once the identity is cached, and a forked child reads it again;
+ * @tc.type: PERF
+ */
+HWTEST_F(WatchdogInnerTest, WatchdogInnerTest_ProcessIdentity_001, TestSize.Level1)
+{
+    constexpr int loopNum = 1000;
+    constexpr unsigned int timeout = 3600;
+    auto& inner = WatchdogInner::GetInstance();
+    ProcessIdentity identity = GetProcessIdentity();
+    EXPECT_EQ(identity.uid, getuid());
+    EXPECT_EQ(identity.name, GetSelfProcName());
+    EXPECT_FALSE(identity.isSpawner);
+
+    uint64_t refreshBefore = GetProcessIdentityRefreshCount();
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < loopNum; i++) {
+        int64_t id = inner.RunXCollieTask("ProcessIdentity_001", timeout, nullptr, nullptr, XCOLLIE_FLAG_NOOP);
+        inner.RemoveXCollieTask(id);
+    }
+    auto cachedCost = std::chrono::steady_clock::now() - begin;
+    uint64_t cachedRefresh = GetProcessIdentityRefreshCount() - refreshBefore;
+    EXPECT_EQ(cachedRefresh, 0);
+
+    // the same loop reading the identity on every call, as it was done before the cache
+    refreshBefore = GetProcessIdentityRefreshCount();
+    begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < loopNum; i++) {
+        InvalidateProcessIdentity();
+        int64_t id = inner.RunXCollieTask("ProcessIdentity_001", timeout, nullptr, nullptr, XCOLLIE_FLAG_NOOP);
+        inner.RemoveXCollieTask(id);
+    }
+    auto uncachedCost = std::chrono::steady_clock::now() - begin;
+    uint64_t uncachedRefresh = GetProcessIdentityRefreshCount() - refreshBefore;
+    EXPECT_EQ(uncachedRefresh, loopNum);
+    printf("SetTimer+CancelTimer x%d, cached: %lld us %llu proc reads, uncached: %lld us %llu proc reads\n", loopNum,
+        static_cast<long long>(std::chrono::duration_cast<std::chrono::microseconds>(cachedCost).count()),
+        static_cast<unsigned long long>(cachedRefresh),
+        static_cast<long long>(std::chrono::duration_cast<std::chrono::microseconds>(uncachedCost).count()),
+        static_cast<unsigned long long>(uncachedRefresh));
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        uint64_t childBefore = GetProcessIdentityRefreshCount();
+        bool isSpawner = IsSpawnerProcess();
+        _exit((!isSpawner && GetProcessIdentityRefreshCount() == childBefore + 1) ? 0 : 1);
+    }
+    ASSERT_GT(pid, 0);
+    int status = 0;
+    ASSERT_EQ(waitpid(pid, &status, 0), pid);
+    EXPECT_TRUE(WIFEXITED(status));
+    EXPECT_EQ(WEXITSTATUS(status), 0);
+}
+
 /**
  * @tc.name: WatchdogInner SendFfrtEvent test;
  * @tc.desc: add testcase
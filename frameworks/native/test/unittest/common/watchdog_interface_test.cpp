@@ -16,6 +16,7 @@
 #include "watchdog_interface_test.h"
 
 #include <gtest/gtest.h>
+#include <atomic>
 #include <string>
 #include <thread>
 
@@ -116,6 +117,39 @@ HWTEST_F(WatchdogInterfaceTest, WatchdogHandlerCheckerTest_001, TestSize.Level1)
     Sleep(blockTime);
 }
 
+/**
+ * @tc.name: Watchdog heartbeat checker
+ * @tc.desc: Verify a looper stuck in one event is reported through its heartbeat
+ * @tc.type: FUNC
+ */
+HWTEST_F(WatchdogInterfaceTest, WatchdogHeartbeatCheckerTest_001, TestSize.Level1)
+{
+    constexpr uint64_t interval = 1000;
+    constexpr int blockTime = 4;
+    auto runner = EventRunner::Create(true);
+    auto handler = std::make_shared<TestEventHandler>(runner);
+    ASSERT_EQ(Watchdog::GetInstance().AddHeartbeatThread("HeartbeatNoSlot", handler, nullptr), -1);
+
+    auto heartbeat = std::make_shared<HeartbeatSlot>();
+    auto blockFunc = [heartbeat]() {
+        heartbeat->BeginEvent();
+        Sleep(blockTime);
+        heartbeat->EndEvent();
+    };
+    auto isTimeout = std::make_shared<std::atomic<bool>>(false);
+    auto timeOutCallback = [isTimeout](const std::string &name, int waitState) {
+        printf("%s time out, waitState is %d\n", name.c_str(), waitState);
+        *isTimeout = true;
+    };
+    int result = Watchdog::GetInstance().AddHeartbeatThread("TestHeartbeatBlock", handler, heartbeat,
+        timeOutCallback, interval);
+    ASSERT_EQ(result, 0);
+    ASSERT_TRUE(handler->PostTask(blockFunc, "HeartbeatBlock", 0, EventQueue::Priority::IMMEDIATE));
+    Sleep(blockTime);
+    Watchdog::GetInstance().RemoveThread("TestHeartbeatBlock");
+    ASSERT_TRUE(isTimeout->load());
+}
+
 /**
  * @tc.name: Watchdog handler checker with customized timeout
  * @tc.desc: Verify customized timeout in handler checker interface
@@ -443,6 +477,21 @@ HWTEST_F(WatchdogInterfaceTest, Watchdog_GetReservedTimeForLogging_001, TestSize
     EXPECT_TRUE(ret >= 3500);
 }
 
+/**
+ * @tc.name: Watchdog DumpSchedulerStats Test;
+ * @tc.desc: Verify the text and json dumps of the scheduler stats
+ * @tc.type: FUNC
+ */
+HWTEST_F(WatchdogInterfaceTest, Watchdog_DumpSchedulerStats_001, TestSize.Level1)
+{
+    std::string text = Watchdog::GetInstance().DumpSchedulerStats();
+    EXPECT_NE(text.find("class XCOLLIE_TIMER"), std::string::npos);
+    std::string json = Watchdog::GetInstance().DumpSchedulerStats(true);
+    EXPECT_EQ(json.front(), '{');
+    EXPECT_EQ(json.back(), '}');
+    EXPECT_NE(json.find("\"classes\":{"), std::string::npos);
+}
+
 /**
  * @tc.name: Watchdog AddThread Test
  * @tc.desc: Verify
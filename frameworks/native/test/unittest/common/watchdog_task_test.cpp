@@ -17,6 +17,7 @@
 #include <gtest/gtest.h>
 #include <string>
 #include <thread>
+#include <vector>
 
 #include "watchdog_task.h"
 #include "xcollie_utils.h"
@@ -109,9 +110,9 @@ HWTEST_F(WatchdogTaskTest, WatchdogTaskTest_004, TestSize.Level1)
 {
     WatchdogTask task("WatchdogTaskTest_004", 0, 1);
     uint64_t now = GetCurrentTickMillseconds();
-    task.triggerTimes.push_back(now);
-    task.triggerTimes.push_back(now + 1000);
-    task.triggerTimes.push_back(now + 2000);
+    task.timerCounter->Trigger(now, "test");
+    task.timerCounter->Trigger(now + 1000, "test");
+    task.timerCounter->Trigger(now + 2000, "test");
     task.TimerCountTask();
     EXPECT_TRUE(task.countLimit != 0);
 }
@@ -447,5 +448,56 @@ HWTEST_F(WatchdogTaskTest, WatchdogTaskTest_InsertSampleStackTask_001, TestSize.
     task.SendEvent("test msg with Thread ID = 12345) is running", "SERVICE_BLOCK", "");
     EXPECT_TRUE(!name.empty());
 }
+
+/**
+ * @tc.name: WatchdogTaskTest adaptive check
+ * @tc.desc: Verify an adaptive check reports by pending probe time, re-checks fast and backs off when idle
+ * @tc.type: FUNC
+ */
+HWTEST_F(WatchdogTaskTest, WatchdogTaskTest_AdaptiveCheck_001, TestSize.Level1)
+{
+    constexpr uint64_t interval = 200;
+    std::vector<int> waitStates;
+    auto callback = [&waitStates](const std::string& name, int waitState) {
+        waitStates.push_back(waitState);
+    };
+    auto runner = EventRunner::Create("AdaptiveCheck_001");
+    auto handler = std::make_shared<EventHandler>(runner);
+    WatchdogTask task("AdaptiveCheck_001", handler, callback, interval, AppExecFwk::EventQueue::Priority::IMMEDIATE);
+    task.isAdaptive = true;
+    ASSERT_TRUE(handler->PostTask([] { std::this_thread::sleep_for(std::chrono::milliseconds(600)); }, "Block600"));
+    task.RunHandlerCheckerTask();
+    ASSERT_EQ(task.GetNextDelay(), interval);
+    std::this_thread::sleep_for(std::chrono::milliseconds(250));
+    task.RunHandlerCheckerTask();
+    ASSERT_EQ(waitStates.size(), 1);
+    ASSERT_EQ(waitStates[0], CheckStatus::WAITED_HALF);
+    ASSERT_GE(task.blockedTime, interval);
+    ASSERT_LT(task.GetNextDelay(), interval);
+    task.RunHandlerCheckerTask();
+    ASSERT_EQ(waitStates.size(), 1);
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    task.RunHandlerCheckerTask();
+    ASSERT_EQ(waitStates.size(), 2);
+    ASSERT_EQ(waitStates[1], CheckStatus::WAITING);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    for (int i = 0; i < 4; i++) { // 4: enough idle rounds to back off
+        task.RunHandlerCheckerTask();
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    ASSERT_EQ(task.blockedTime, 0);
+    ASSERT_EQ(task.GetNextDelay(), interval * 2); // 2: the longest backoff
+    ASSERT_EQ(waitStates.size(), 2);
+
+    // the block may have started right after the last probe, the backed off check warns at once
+    ASSERT_TRUE(handler->PostTask([] { std::this_thread::sleep_for(std::chrono::milliseconds(300)); }, "Block300"));
+    task.RunHandlerCheckerTask();
+    ASSERT_EQ(task.backoffWindow, interval);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    task.RunHandlerCheckerTask();
+    ASSERT_EQ(waitStates.size(), 3);
+    ASSERT_EQ(waitStates[2], CheckStatus::WAITED_HALF);
+}
 } // namespace HiviewDFX
 } // namespace OHOS
@@ -0,0 +1,49 @@
+/*
+ * Copyright (c) 2026 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef RELIABILITY_SAMPLE_PROFILE_H
+#define RELIABILITY_SAMPLE_PROFILE_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+#include "sample_record.h"
+
+namespace OHOS {
+namespace HiviewDFX {
+/*
+ * Export of the samples of a SampleRecord for profile viewers:
+ *   collapsed: one "root;...;leaf count" line per distinct stack, for flamegraph.pl, speedscope and the like
+ *   pprof: an uncompressed perftools.profiles.Profile protobuf, every sample weighted 1 sample and the average
+ *       sample interval in ns, labeled with its snapshot_time
+ * A submitter stack goes above the stack of its sample, joined by an [async] frame.
+ */
+enum SampleProfileFormat : int {
+    SAMPLE_PROFILE_COLLAPSED = 0,
+    SAMPLE_PROFILE_PPROF = 1,
+};
+
+// Function names by pc, a pc without a name is shown as its mapping name plus the relative pc.
+using SampleFunctionNames = std::unordered_map<uint64_t, std::string>;
+
+void EncodeCollapsedStacks(const SampleRecord& record, const SampleFunctionNames& names, std::string& data);
+void EncodePprofProfile(const SampleRecord& record, const SampleFunctionNames& names, std::string& data);
+// Return false for an unknown format.
+bool EncodeSampleProfile(int format, const SampleRecord& record, const SampleFunctionNames& names,
+    std::string& data);
+} // end of namespace HiviewDFX
+} // end of namespace OHOS
+#endif
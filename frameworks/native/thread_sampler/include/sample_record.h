@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2026 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef RELIABILITY_SAMPLE_RECORD_H
+#define RELIABILITY_SAMPLE_RECORD_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace OHOS {
+namespace HiviewDFX {
+/*
+ * Unsymbolized samples of one thread, to be symbolized later and elsewhere by sample_symbolizer.
+ *
+ * Layout, every number is an unsigned LEB128 varint, a delta is zigzag encoded first:
+ *   magic "TSR1"
+ *   pid, tid
+ *   build id count, then per build id: length, bytes
+ *   mapping count, then per mapping: begin, size, file offset, build id index + 1 or 0, name length, name
+ *   sample count, then per sample: time delta to the previous sample, pc count, pcs,
+ *       submitter pc count, submitter pcs
+ * Every pc is a delta to the pc written before it, the first of the record to 0.
+ */
+constexpr char SAMPLE_RECORD_MAGIC[] = "TSR1";
+constexpr size_t SAMPLE_RECORD_MAGIC_LEN = sizeof(SAMPLE_RECORD_MAGIC) - 1;
+constexpr uint32_t SAMPLE_RECORD_NO_BUILD_ID = 0;
+
+struct SampleRecordMapping {
+    uint64_t begin = 0;
+    uint64_t end = 0;
+    uint64_t offset = 0;
+    uint32_t buildIdIndex = SAMPLE_RECORD_NO_BUILD_ID; // index into buildIds plus 1
+    std::string name;
+};
+
+struct SampleRecordSample {
+    uint64_t snapshotTime = 0;
+    std::vector<uint64_t> pcs;
+    std::vector<uint64_t> submitterPcs;
+};
+
+struct SampleRecord {
+    int32_t pid = 0;
+    int32_t tid = 0;
+    std::vector<std::string> buildIds; // raw bytes
+    std::vector<SampleRecordMapping> mappings;
+    std::vector<SampleRecordSample> samples;
+};
+
+void EncodeSampleRecord(const SampleRecord& record, std::string& data);
+// Return false when data is not a whole record.
+bool DecodeSampleRecord(const uint8_t* data, size_t size, SampleRecord& record);
+} // end of namespace HiviewDFX
+} // end of namespace OHOS
+#endif
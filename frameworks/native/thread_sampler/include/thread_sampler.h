@@ -18,14 +18,20 @@
 
 #include <atomic>
 #include <condition_variable>
+#include <functional>
 #include <memory>
 #include <mutex>
+#include <set>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 #include <sys/mman.h>
 
 #include "dfx_accessors.h"
 #include "dfx_maps.h"
+#include "sample_profile.h"
+#include "sample_record.h"
 #include "singleton.h"
 #include "stack_printer.h"
 #include "unwind_context.h"
@@ -35,6 +41,13 @@ namespace OHOS {
 namespace HiviewDFX {
 constexpr int STACK_BUFFER_SIZE = 16 * 1024;
 constexpr uint32_t DEFAULT_UNIQUE_STACK_TABLE_SIZE = 128 * 1024;
+constexpr int32_t MAX_SAMPLED_THREAD_NUM = 8;
+constexpr uint32_t ADAPTIVE_COPY_WINDOW = 8;
+constexpr size_t MAX_FRAME_CACHE_SIZE = 8 * 1024;
+constexpr uint32_t FLIGHT_MAX_FRAME_NUM = 64;
+
+using FrameCache = std::unordered_map<uintptr_t, DfxFrame>; // symbolized frames by pc
+using StackWriter = std::function<bool(const std::string&)>;
 
 struct ThreadUnwindContext {
     uintptr_t pc {0};
@@ -44,7 +57,12 @@ struct ThreadUnwindContext {
     std::atomic<uint64_t> requestTime {0};   // begin sample
     std::atomic<uint64_t> snapshotTime {0};  // end of stack copy in signal handler
     std::atomic<uint64_t> processTime {0};   // end of unwind and unique stack
-    uint8_t buffer[STACK_BUFFER_SIZE] {0};   // 16K stack buffer
+    uint64_t residencyTime {0};              // time spent in the signal handler
+    uint32_t stackSize {0};                  // stack above sp, at most STACK_BUFFER_SIZE
+    uint32_t copySize {0};                   // stack copied to buffer, less than stackSize when adaptive
+    uint32_t usedSize {0};                   // deepest buffer offset read by the unwinder
+    bool truncated {false};                  // the unwinder needed stack beyond copySize
+    alignas(16) uint8_t buffer[STACK_BUFFER_SIZE] {0};  // 16K stack buffer, aligned as sp
 };
 
 struct SamplerResult {
@@ -53,54 +71,165 @@ struct SamplerResult {
     int32_t samplerCount;
 };
 
+struct FlightRecorderStats {
+    uint64_t startTime;     // ns
+    uint64_t sampleCount;   // samples put in the ring
+    uint64_t skippedCount;  // samples skipped over the cpu budget
+    uint64_t costTime;      // ns, on the sampling thread plus in the signal handler
+    uint64_t maxCostTime;   // ns, of one sample
+    uint64_t memorySize;    // bytes of the sample ring and the capture ring
+};
+
+// A main thread sample kept by the flight recorder, symbolized only when collected.
+struct FlightSample {
+    uint64_t snapshotTime {0};
+    uint32_t pcNum {0};
+    uintptr_t pcs[FLIGHT_MAX_FRAME_NUM] {0};
+};
+
+// Head of the raw samples copied out of the flight recorder ring, followed by sampleNum FlightSamples each cut
+// after its pcNum pcs.
+struct FlightSampleHeader {
+    uint64_t copyTime {0}; // ns
+    FlightRecorderStats stats {};
+    uint32_t sampleNum {0};
+};
+
 struct UnwindInfo {
     ThreadUnwindContext* context;
     DfxMaps* maps;
 };
 
+// A thread registered to the sampler, its capture ring is only written by the signal handler running on it.
+// The ring is single producer single consumer: the handler publishes at head, the unwinder consumes at tail.
+struct SampledThread {
+    std::atomic<int32_t> tid {0};  // published last, 0 for a free entry
+    std::atomic<uintptr_t> stackBegin {0}; // only moves down, when the stack mapping grew
+    uintptr_t stackEnd {0};
+    std::atomic<uintptr_t> straySp {0};     // sp of the last sample off the stack range, 0 once looked up
+    uintptr_t strayBegin {0};               // mapping of a stray sp that is not the stack of the thread
+    uintptr_t strayEnd {0};
+    std::atomic<uint64_t> head {0};
+    std::atomic<uint64_t> tail {0};
+    std::atomic<uint64_t> requestTime {0};  // of the last sample request
+    std::atomic<uint64_t> droppedCount {0}; // samples lost to a full ring or taken off the stack range
+    uint32_t depth {0};
+    void* mmapStart {MAP_FAILED};
+    size_t bufferSize {0};
+    std::vector<TimeStampedPcs> timeStampedPcsList;
+    std::unique_ptr<uint64_t[]> submitterStackIds {nullptr};
+    size_t submitterStackIdIndex {0};
+    std::vector<uint64_t> residencyTimes; // of the samples in timeStampedPcsList
+    uint64_t residencyTotal {0};
+    uint64_t residencyMax {0};
+    std::atomic<uint32_t> copyLimit {STACK_BUFFER_SIZE}; // adaptive copy size, read by the signal handler
+    uint32_t usedSizes[ADAPTIVE_COPY_WINDOW] {0};       // of the recent unwinds
+    uint32_t usedSizeIndex {0};
+};
+
 class ThreadSampler : public Singleton<ThreadSampler> {
     DECLARE_SINGLETON(ThreadSampler);
 
 public:
-    static const int32_t SAMPLER_MAX_BUFFER_SZ = 2;
+    static const uint32_t SAMPLER_DEFAULT_RING_DEPTH = 2;
+    static const uint32_t SAMPLER_MAX_RING_DEPTH = 64;
     static void ThreadSamplerSignalHandler(int sig, siginfo_t* si, void* context);
 
-    // Initial sampler, include uwinder, recorde buffer etc.
-    bool Init(size_t collectStackCount, bool recordSubmitterStack);
-    int32_t Sample();  // Interface of sample, to send sample request.
+    // Initial sampler, include uwinder, recorde buffer etc. and add the thread tid, 0 for the main thread.
+    // Threads are only removed by Deinit, at most MAX_SAMPLED_THREAD_NUM of them can be added.
+    bool Init(size_t collectStackCount, bool recordSubmitterStack, int32_t tid = 0);
+    int32_t Sample();  // Interface of sample, to send sample request to the main thread.
+    int32_t Sample(int32_t tid);
     // Collect stack info, can be formed into tree format or not. Unsafe in multi-thread environments
     bool CollectStack(std::string& stack, bool treeFormat = true);
+    bool CollectStack(int32_t tid, std::string& stack, bool treeFormat = true);
+    // Same as CollectStack, the text is handed to writer in pieces as it is formatted, a false return stops it.
+    bool StreamStack(const StackWriter& writer, bool treeFormat = true);
+    bool StreamStack(int32_t tid, const StackWriter& writer, bool treeFormat = true);
+    // Collect the raw pcs in the SampleRecord encoding with the mappings they fall in, unsymbolized.
+    bool CollectRecord(std::string& record);
+    bool CollectRecord(int32_t tid, std::string& record);
+    // Collect the samples symbolized as collapsed stacks or a pprof profile, see SampleProfileFormat.
+    bool CollectProfile(int format, std::string& data);
+    bool CollectProfile(int32_t tid, int format, std::string& data);
+    // Capture ring depth of the threads added later, each slot holds STACK_BUFFER_SIZE of stack.
+    bool SetRingDepth(uint32_t depth);
+    uint64_t GetDroppedCount(int32_t tid);
+    // Copy only the stack the recent unwinds have read plus some headroom, instead of STACK_BUFFER_SIZE.
+    void SetAdaptiveCopy(bool enable);
+    // Walk the frame records in the copied stack, the DWARF unwinder only runs when the chain looks corrupt.
+    void SetFpUnwind(bool enable);
+    // Keep the unwinder, maps with their parsed ELFs and symbolized frames after Deinit for the next Init,
+    // the maps are reloaded there only when a library was loaded or unloaded meanwhile.
+    void SetWarmCache(bool enable);
     bool Deinit();  // Release sampler
-    std::string GetHeaviestStack() const;
+    // Keep the main thread sampled between sessions, FlightRecorderSample puts a sample in a ring covering window
+    // ms at one per interval ms, at most memoryBudget bytes, and skips samples over cpuBudget permille of the time.
+    bool StartFlightRecorder(uint32_t interval, uint32_t window, size_t memoryBudget, uint32_t cpuBudget);
+    bool StopFlightRecorder();
+    bool FlightRecorderSample();
+    // The ring samples of the last window ms, headed by the recorder statistics.
+    bool CollectFlightStack(uint32_t window, std::string& stack);
+    // CollectFlightStack in two steps, a cheap copy of the raw samples and their symbolization later on,
+    // the symbolization may run on another thread than the sampling.
+    bool CopyFlightSamples(uint32_t window, std::string& samples);
+    bool SymbolizeFlightSamples(const std::string& samples, std::string& stack);
+    FlightRecorderStats GetFlightRecorderStats();
+    const std::string& GetHeaviestStack() const;
     SamplerResult ThreadSamplerGetResult();
 
 private:
-    bool InitRecordBuffer();
-    void ReleaseRecordBuffer();
+    bool InitSampler();
+    bool InitSession(size_t collectStackCount, bool recordSubmitterStack);
+    void DeinitSession();
+    void ReleaseSampler();
+    void PutFlightSample(const std::vector<uintptr_t>& pcs, uint64_t snapshotTime, uint64_t residencyTime);
+    bool AddThread(int32_t tid);
+    bool GetThreadStackRange(int32_t tid, uintptr_t& stackBegin, uintptr_t& stackEnd);
+    // Extend the stack range of thread down to the mapping holding sp when that mapping is its grown stack.
+    void UpdateStackRange(SampledThread& thread, uintptr_t sp);
+    SampledThread* FindThread(int32_t tid);
+    bool InitRecordBuffer(SampledThread& thread);
+    void ReleaseRecordBuffer(SampledThread& thread);
     bool InitUnwinder();
+    bool RefreshMaps();
     void DestroyUnwinder();
+    FrameCache* GetFrameCache();
+    bool InitSymbolizer();
+    bool BuildRecord(int32_t tid, SampleRecord& sampleRecord);
+    void AddRecordMappings(const std::vector<uint64_t>& pcs, SampleRecord& record, std::set<uint64_t>& added);
     bool InitStackPrinter();
-    void SendSampleRequest();
+    void SendSampleRequest(SampledThread& thread);
     void ProcessStackBuffer();
+    void ProcessStackBuffer(SampledThread& thread);
     int AccessElfMem(uintptr_t addr, uintptr_t* val);
 
     static int FindUnwindTable(uintptr_t pc, UnwindTableInfo& outTableInfo, void* arg);
     static int AccessMem(uintptr_t addr, uintptr_t* val, void* arg);
     static int GetMapByPc(uintptr_t pc, std::shared_ptr<DfxMap>& map, void* arg);
 
-    ThreadUnwindContext* GetReadContext();
-    ThreadUnwindContext* GetWriteContext();
+    ThreadUnwindContext* GetReadContext(SampledThread& thread);
+    void ReleaseReadContext(SampledThread& thread);
+    ThreadUnwindContext* GetWriteContext(SampledThread& thread);
     void WriteContext(void* context);
+    void WriteContext(SampledThread& thread, void* context);
+    void UpdateCopyLimit(SampledThread& thread, const ThreadUnwindContext& context);
     MAYBE_UNUSED void ResetConsumeInfo();
 
-    bool init_ {false};
-    uintptr_t stackBegin_ {0};
-    uintptr_t stackEnd_ {0};
+    bool init_ {false};  // the unwinder is loaded
+    std::atomic<bool> session_ {false};  // between the Init and Deinit of a collect session
     int32_t pid_ {0};
-    std::atomic<int32_t> writeIndex_ {0};
-    std::atomic<int32_t> readIndex_ {0};
-    void* mmapStart_ {MAP_FAILED};
-    int32_t bufferSize_ {0};
+    SampledThread threads_[MAX_SAMPLED_THREAD_NUM];
+    uint32_t ringDepth_ {SAMPLER_DEFAULT_RING_DEPTH};
+    bool adaptiveCopy_ {false};
+    bool fpUnwind_ {false};
+    uint64_t fpUnwindCount_ {0};
+    uint64_t fpFallbackCount_ {0};
+    std::atomic<bool> warmCache_ {false};
+    FrameCache frameCache_;
+    bool loadCountsValid_ {false};
+    uint64_t loadAdds_ {0};
+    uint64_t loadSubs_ {0};
     std::shared_ptr<Unwinder> unwinder_ {nullptr};
     std::shared_ptr<UnwindAccessors> accessors_ {nullptr};
     std::shared_ptr<DfxMaps> maps_ {nullptr};
@@ -111,6 +240,23 @@ private:
     std::string uniTableMMapName_ {"hicollie_buf"};
     std::string heaviestStack_ {0};
     bool recordSubmitterStack_ {false};
+    std::atomic<bool> flightRecorder_ {false};
+    std::mutex flightMutex_;  // of the ring and the stats, they are collected on other threads
+    std::vector<FlightSample> flightSamples_;
+    uint64_t flightHead_ {0};
+    uint32_t flightCpuBudget_ {0};
+    int64_t flightCredit_ {0};     // ns of cpu the recorder may still spend
+    uint64_t flightLastTime_ {0};
+    uint64_t flightResidency_ {0}; // signal handler time of the samples not charged yet
+    FlightRecorderStats flightStats_ {};
+    // flight samples are symbolized on the report thread, away from the unwinder and maps of the sessions
+    std::mutex symbolizerMutex_;
+    std::shared_ptr<Unwinder> symbolizerUnwinder_ {nullptr};
+    std::shared_ptr<DfxMaps> symbolizerMaps_ {nullptr};
+    FrameCache symbolizerCache_;
+    bool symbolizerCountsValid_ {false};
+    uint64_t symbolizerAdds_ {0};
+    uint64_t symbolizerSubs_ {0};
 
     MAYBE_UNUSED uint64_t copyStackCount_ {0};
     MAYBE_UNUSED uint64_t copyStackTimeCost_ {0};
@@ -124,9 +270,6 @@ private:
     MAYBE_UNUSED uint64_t processStartTime_ {0};
     MAYBE_UNUSED uint64_t processFinishTime_ {0};
 
-    std::vector<TimeStampedPcs> timeStampedPcsList_;
-    std::unique_ptr<uint64_t[]> submitterStackIds_ {nullptr};
-    size_t submitterStackIdIndex_ {0};
     size_t submitterStackIdsMaxSize_ {0};
 };
 }  // end of namespace HiviewDFX
@@ -40,6 +40,96 @@ int32_t ThreadSamplerSample();
  */
 int ThreadSamplerCollect(char* stack, char* heaviestStack, size_t stackSize, size_t heaviestSize, int treeFormat);
 
+/* The writer ThreadSamplerCollectStream and the other writer based collections hand the collected data to.
+ * context: the context passed along with the writer.
+ * part: 0 for the stack and 1 for the heaviest stack, the pieces of a part come in order.
+ * data: a piece of size bytes, not null terminated and only valid during the call.
+ * return 0 to go on and nonzero to stop the collection.
+ */
+typedef int (*ThreadSamplerWriter)(void* context, int part, const char* data, size_t size);
+
+/* To collect the stack infomation of the thread tid, 0 for the main thread, through writer as it is formatted,
+ * without the copies and the size limit of ThreadSamplerCollect. The heaviest stack follows the stack in tree
+ * format, treeFormat is the same as ThreadSamplerCollect.
+ * return 0 for success and -1 for fail or stopped by writer, the wchan of tid may have been written on fail.
+ */
+int ThreadSamplerCollectStream(int tid, int treeFormat, ThreadSamplerWriter writer, void* context);
+
+/* To collect the raw pcs sampled from the thread tid, 0 for the main thread, as a SampleRecord, see
+ * sample_record.h, to be symbolized offline by sample_symbolizer. The record is built once and handed to
+ * writer as part 0.
+ * return 0 for success and -1 for fail or stopped by writer.
+ */
+int ThreadSamplerCollectRecord(int tid, ThreadSamplerWriter writer, void* context);
+
+/* To collect the stacks sampled from the thread tid, 0 for the main thread, symbolized for profile viewers.
+ * format: 0 for collapsed stacks, one "root;...;leaf count" line per distinct stack, 1 for a pprof profile.
+ * The profile is symbolized and encoded once and handed to writer as part 0.
+ * return 0 for success and -1 for fail or stopped by writer.
+ */
+int ThreadSamplerCollectProfile(int tid, int format, ThreadSamplerWriter writer, void* context);
+
+/* To initialize thread sampler if needed and add the thread tid to it, return 0 for success.
+ * The stack range of tid is taken from the pthread attributes when called on tid itself, otherwise
+ * from the name of its stack mapping.
+ */
+int ThreadSamplerInitThread(int tid, size_t collectStackCount, int recordSubmitterStack);
+
+/* To start sample stack of the thread tid added by ThreadSamplerInitThread. */
+int32_t ThreadSamplerSampleThread(int tid);
+
+/* To collect the stack infomation of the thread tid, the parameters are the same as ThreadSamplerCollect. */
+int ThreadSamplerCollectThread(int tid, char* stack, char* heaviestStack, size_t stackSize, size_t heaviestSize,
+    int treeFormat);
+
+/* To set the capture ring depth of the threads added later, 1 to 64 samples, return 0 for success. */
+int ThreadSamplerSetRingDepth(uint32_t depth);
+
+/* The number of samples of the thread tid lost to a full capture ring, 0 for the main thread. */
+uint64_t ThreadSamplerGetDroppedCount(int tid);
+
+/* To copy only the stack recent unwinds needed plus headroom in the signal handler, 1 to enable, 0 to copy
+ * STACK_BUFFER_SIZE of stack as by default.
+ */
+void ThreadSamplerSetAdaptiveCopy(int enable);
+
+/* To unwind samples by frame pointers with the DWARF unwinder as fallback, 1 to enable, 0 for DWARF only. */
+void ThreadSamplerSetFpUnwind(int enable);
+
+/* To keep the unwinder, maps and symbolized frames loaded after ThreadSamplerDeinit for the next session while
+ * the library stays loaded, 1 to enable, 0 to release them with the next ThreadSamplerDeinit.
+ */
+void ThreadSamplerSetWarmCache(int enable);
+
+/* To keep sampling the main thread between sessions into a ring of raw pcs, the ring covers window ms at one
+ * sample per interval ms within memoryBudget bytes, samples are skipped while the sampling took more than
+ * cpuBudget permille of the time. Sessions keep working meanwhile and their main thread samples go to the ring
+ * too, ThreadSamplerDeinit keeps the resources until ThreadSamplerStopFlightRecorder. Return 0 for success.
+ */
+int ThreadSamplerStartFlightRecorder(uint32_t interval, uint32_t window, size_t memoryBudget, uint32_t cpuBudget);
+
+/* To stop the flight recorder and release the resources when no session is running, return 0 for success. */
+int ThreadSamplerStopFlightRecorder();
+
+/* To take a flight recorder sample, called once per interval, return 0 unless the sample was skipped. */
+int ThreadSamplerFlightSample();
+
+/* To copy the raw flight recorder samples of the last window ms with the recorder statistics, cheap enough for
+ * the watchdog thread, through writer as part 0.
+ * return 0 for success and -1 for fail or stopped by writer.
+ */
+int ThreadSamplerCopyFlightSamples(uint32_t window, ThreadSamplerWriter writer, void* context);
+
+/* To symbolize samples copied by ThreadSamplerCopyFlightSamples, headed by the recorder statistics, through
+ * writer as part 0. It may run on another thread than the sampling, once per copy.
+ * return 0 for success and -1 for fail, stopped by writer or when there is no sample.
+ */
+int ThreadSamplerSymbolizeFlightSamples(const char* samples, size_t samplesSize, ThreadSamplerWriter writer,
+    void* context);
+
+/* The flight recorder statistics, its cpu cost and memory. */
+FlightRecorderStats ThreadSamplerGetFlightRecorderStats();
+
 /* To deinitial thread sampler and unload the resources. */
 int ThreadSamplerDeinit();
 
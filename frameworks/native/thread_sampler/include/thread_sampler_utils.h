@@ -38,11 +38,23 @@ namespace HiviewDFX {
 #define XCOLLIE_LOGD(...) HILOG_DEBUG(LOG_CORE, ##__VA_ARGS__)
 
 uint64_t GetCurrentTimeNanoseconds();
+uint64_t GetThreadCpuTimeNanoseconds();
 std::string TimeFormat(uint64_t time);
 void DoUnwind(const std::shared_ptr<Unwinder>& unwinder, UnwindInfo& unwindInfo);
+// Walk the fp/lr frame records inside context.buffer, return false when the chain looks corrupt.
+// lr is never used, it is stale once the interrupted function has called anything, so the caller
+// of a leaf function without a frame record is not reported.
+bool DoFpUnwind(ThreadUnwindContext& context, const std::shared_ptr<DfxMaps>& maps, std::vector<uintptr_t>& pcs);
 std::vector<uintptr_t> GetAsyncStackPcsByStackId(uint64_t stackId);
+// Read the dl_iterate_phdr load and unload counters, false when the loader does not provide them.
+bool GetLoadCounts(uint64_t& adds, uint64_t& subs);
+// Raw GNU build id of the loaded object covering addr, empty when there is none.
+std::string GetBuildIdByAddr(uintptr_t addr);
+DfxFrame GetFrameByPc(uintptr_t pc, const std::shared_ptr<Unwinder>& unwinder, const std::shared_ptr<DfxMaps>& maps,
+                      FrameCache* frameCache = nullptr);
 std::string GetStackByPcs(const std::vector<uintptr_t>& pcVec, const std::shared_ptr<Unwinder>& unwinder,
-                          const std::shared_ptr<DfxMaps>& maps, uint64_t snapshotTime);
+                          const std::shared_ptr<DfxMaps>& maps, uint64_t snapshotTime,
+                          FrameCache* frameCache = nullptr);
 }  // end of namespace HiviewDFX
 }  // end of namespace OHOS
 #endif
@@ -0,0 +1,364 @@
+/*
+ * Copyright (c) 2026 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "sample_profile.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <map>
+#include <vector>
+
+namespace OHOS {
+namespace HiviewDFX {
+namespace {
+constexpr size_t NAME_BUF_LEN = 64;
+constexpr char ASYNC_FRAME[] = "[async]";
+constexpr char HEX_DIGITS[] = "0123456789abcdef";
+constexpr uint32_t HEX_SHIFT = 4;
+constexpr uint8_t HEX_MASK = 0xf;
+
+constexpr uint32_t VARINT_BITS = 7;
+constexpr uint8_t VARINT_MASK = 0x7f;
+constexpr uint8_t VARINT_MORE = 0x80;
+constexpr uint32_t WIRE_TYPE_BITS = 3;
+constexpr uint32_t WIRE_VARINT = 0;
+constexpr uint32_t WIRE_LEN = 2;
+
+// field numbers of perftools.profiles, profile.proto
+constexpr uint32_t PROFILE_SAMPLE_TYPE = 1;
+constexpr uint32_t PROFILE_SAMPLE = 2;
+constexpr uint32_t PROFILE_MAPPING = 3;
+constexpr uint32_t PROFILE_LOCATION = 4;
+constexpr uint32_t PROFILE_FUNCTION = 5;
+constexpr uint32_t PROFILE_STRING_TABLE = 6;
+constexpr uint32_t PROFILE_TIME_NANOS = 9;
+constexpr uint32_t PROFILE_DURATION_NANOS = 10;
+constexpr uint32_t PROFILE_PERIOD_TYPE = 11;
+constexpr uint32_t PROFILE_PERIOD = 12;
+constexpr uint32_t VALUE_TYPE_TYPE = 1;
+constexpr uint32_t VALUE_TYPE_UNIT = 2;
+constexpr uint32_t SAMPLE_LOCATION_ID = 1;
+constexpr uint32_t SAMPLE_VALUE = 2;
+constexpr uint32_t SAMPLE_LABEL = 3;
+constexpr uint32_t LABEL_KEY = 1;
+constexpr uint32_t LABEL_NUM = 3;
+constexpr uint32_t LABEL_NUM_UNIT = 4;
+constexpr uint32_t MAPPING_ID = 1;
+constexpr uint32_t MAPPING_MEMORY_START = 2;
+constexpr uint32_t MAPPING_MEMORY_LIMIT = 3;
+constexpr uint32_t MAPPING_FILE_OFFSET = 4;
+constexpr uint32_t MAPPING_FILENAME = 5;
+constexpr uint32_t MAPPING_BUILD_ID = 6;
+constexpr uint32_t MAPPING_HAS_FUNCTIONS = 7;
+constexpr uint32_t LOCATION_ID = 1;
+constexpr uint32_t LOCATION_MAPPING_ID = 2;
+constexpr uint32_t LOCATION_ADDRESS = 3;
+constexpr uint32_t LOCATION_LINE = 4;
+constexpr uint32_t LINE_FUNCTION_ID = 1;
+constexpr uint32_t FUNCTION_ID = 1;
+constexpr uint32_t FUNCTION_NAME = 2;
+constexpr uint32_t FUNCTION_SYSTEM_NAME = 3;
+constexpr uint32_t FUNCTION_FILENAME = 4;
+
+// Protobuf wire format, a field at its default value is left out as proto3 does.
+class ProtoWriter {
+public:
+    void Varint(uint32_t field, uint64_t value)
+    {
+        if (value == 0) {
+            return;
+        }
+        PutVarint((static_cast<uint64_t>(field) << WIRE_TYPE_BITS) | WIRE_VARINT);
+        PutVarint(value);
+    }
+
+    void Bytes(uint32_t field, const std::string& bytes)
+    {
+        PutVarint((static_cast<uint64_t>(field) << WIRE_TYPE_BITS) | WIRE_LEN);
+        PutVarint(bytes.size());
+        data_ += bytes;
+    }
+
+    void Message(uint32_t field, const ProtoWriter& message)
+    {
+        Bytes(field, message.data_);
+    }
+
+    void Packed(uint32_t field, const std::vector<uint64_t>& values)
+    {
+        ProtoWriter packed;
+        for (auto value : values) {
+            packed.PutVarint(value);
+        }
+        Bytes(field, packed.data_);
+    }
+
+    std::string& Data()
+    {
+        return data_;
+    }
+
+private:
+    void PutVarint(uint64_t value)
+    {
+        while (value > VARINT_MASK) {
+            data_.push_back(static_cast<char>((value & VARINT_MASK) | VARINT_MORE));
+            value >>= VARINT_BITS;
+        }
+        data_.push_back(static_cast<char>(value));
+    }
+
+    std::string data_;
+};
+
+const SampleRecordMapping* FindMapping(const SampleRecord& record, uint64_t pc)
+{
+    auto iter = std::find_if(record.mappings.begin(), record.mappings.end(),
+        [pc](const SampleRecordMapping& mapping) { return pc >= mapping.begin && pc < mapping.end; });
+    return (iter == record.mappings.end()) ? nullptr : &(*iter);
+}
+
+std::string FrameName(const SampleRecord& record, const SampleFunctionNames& names, uint64_t pc)
+{
+    auto iter = names.find(pc);
+    if (iter != names.end() && !iter->second.empty()) {
+        return iter->second;
+    }
+    char buf[NAME_BUF_LEN] = {0};
+    const SampleRecordMapping* mapping = FindMapping(record, pc);
+    if (mapping == nullptr) {
+        snprintf(buf, sizeof(buf), "0x%" PRIx64, pc);
+        return buf;
+    }
+    snprintf(buf, sizeof(buf), "+0x%" PRIx64, pc - mapping->begin + mapping->offset);
+    return mapping->name.substr(mapping->name.rfind('/') + 1) + buf;
+}
+
+std::string ToHex(const std::string& bytes)
+{
+    std::string hex;
+    for (auto c : bytes) {
+        auto byte = static_cast<uint8_t>(c);
+        hex.push_back(HEX_DIGITS[byte >> HEX_SHIFT]);
+        hex.push_back(HEX_DIGITS[byte & HEX_MASK]);
+    }
+    return hex;
+}
+
+class PprofBuilder {
+public:
+    PprofBuilder(const SampleRecord& record, const SampleFunctionNames& names) : record_(record), names_(names)
+    {
+        StringId("");
+    }
+
+    void Build(std::string& data)
+    {
+        uint64_t begin = UINT64_MAX;
+        uint64_t end = 0;
+        for (const auto& sample : record_.samples) {
+            begin = std::min(begin, sample.snapshotTime);
+            end = std::max(end, sample.snapshotTime);
+        }
+        // every sample stands for the time to the next one
+        uint64_t period = (record_.samples.size() > 1) ? (end - begin) / (record_.samples.size() - 1) : 0;
+        ProtoWriter profile;
+        profile.Message(PROFILE_SAMPLE_TYPE, ValueType("samples", "count"));
+        profile.Message(PROFILE_SAMPLE_TYPE, ValueType("wall", "nanoseconds"));
+        for (const auto& sample : record_.samples) {
+            profile.Message(PROFILE_SAMPLE, Sample(sample, period));
+        }
+        for (size_t i = 0; i < record_.mappings.size(); i++) {
+            profile.Message(PROFILE_MAPPING, Mapping(i));
+        }
+        profile.Data() += locations_.Data();
+        profile.Data() += functions_.Data();
+        for (const auto& str : strings_) {
+            profile.Bytes(PROFILE_STRING_TABLE, str);
+        }
+        profile.Varint(PROFILE_TIME_NANOS, record_.samples.empty() ? 0 : begin);
+        profile.Varint(PROFILE_DURATION_NANOS, end - std::min(begin, end));
+        profile.Message(PROFILE_PERIOD_TYPE, ValueType("wall", "nanoseconds"));
+        profile.Varint(PROFILE_PERIOD, period);
+        data = std::move(profile.Data());
+    }
+
+private:
+    uint64_t StringId(const std::string& str)
+    {
+        auto iter = stringIds_.find(str);
+        if (iter != stringIds_.end()) {
+            return iter->second;
+        }
+        strings_.push_back(str);
+        return stringIds_[str] = strings_.size() - 1;
+    }
+
+    ProtoWriter ValueType(const std::string& type, const std::string& unit)
+    {
+        ProtoWriter valueType;
+        valueType.Varint(VALUE_TYPE_TYPE, StringId(type));
+        valueType.Varint(VALUE_TYPE_UNIT, StringId(unit));
+        return valueType;
+    }
+
+    ProtoWriter Sample(const SampleRecordSample& sample, uint64_t period)
+    {
+        // leaf first, the submitter stack is the caller of the async frame
+        std::vector<uint64_t> locationIds;
+        for (auto pc : sample.pcs) {
+            locationIds.push_back(LocationId(pc));
+        }
+        if (!sample.submitterPcs.empty()) {
+            locationIds.push_back(LocationId(0));
+            for (auto pc : sample.submitterPcs) {
+                locationIds.push_back(LocationId(pc));
+            }
+        }
+        ProtoWriter message;
+        message.Packed(SAMPLE_LOCATION_ID, locationIds);
+        message.Packed(SAMPLE_VALUE, {1, period});
+        ProtoWriter label;
+        label.Varint(LABEL_KEY, StringId("snapshot_time"));
+        label.Varint(LABEL_NUM, sample.snapshotTime);
+        label.Varint(LABEL_NUM_UNIT, StringId("nanoseconds"));
+        message.Message(SAMPLE_LABEL, label);
+        return message;
+    }
+
+    ProtoWriter Mapping(size_t index)
+    {
+        const auto& mapping = record_.mappings[index];
+        ProtoWriter message;
+        message.Varint(MAPPING_ID, index + 1);
+        message.Varint(MAPPING_MEMORY_START, mapping.begin);
+        message.Varint(MAPPING_MEMORY_LIMIT, mapping.end);
+        message.Varint(MAPPING_FILE_OFFSET, mapping.offset);
+        message.Varint(MAPPING_FILENAME, StringId(mapping.name));
+        if (mapping.buildIdIndex != SAMPLE_RECORD_NO_BUILD_ID) {
+            message.Varint(MAPPING_BUILD_ID, StringId(ToHex(record_.buildIds[mapping.buildIdIndex - 1])));
+        }
+        message.Varint(MAPPING_HAS_FUNCTIONS, names_.empty() ? 0 : 1);
+        return message;
+    }
+
+    // pc 0 for the async frame
+    uint64_t LocationId(uint64_t pc)
+    {
+        auto iter = locationIds_.find(pc);
+        if (iter != locationIds_.end()) {
+            return iter->second;
+        }
+        uint64_t id = locationIds_.size() + 1;
+        locationIds_[pc] = id;
+        ProtoWriter location;
+        location.Varint(LOCATION_ID, id);
+        const SampleRecordMapping* mapping = (pc == 0) ? nullptr : FindMapping(record_, pc);
+        if (mapping != nullptr) {
+            location.Varint(LOCATION_MAPPING_ID, static_cast<uint64_t>(mapping - record_.mappings.data()) + 1);
+        }
+        location.Varint(LOCATION_ADDRESS, pc);
+        auto name = names_.find(pc);
+        if (pc == 0 || (name != names_.end() && !name->second.empty())) {
+            ProtoWriter line;
+            line.Varint(LINE_FUNCTION_ID, FunctionId((pc == 0) ? ASYNC_FRAME : name->second,
+                (mapping == nullptr) ? "" : mapping->name));
+            location.Message(LOCATION_LINE, line);
+        }
+        locations_.Message(PROFILE_LOCATION, location);
+        return id;
+    }
+
+    uint64_t FunctionId(const std::string& name, const std::string& fileName)
+    {
+        auto key = std::make_pair(name, fileName);
+        auto iter = functionIds_.find(key);
+        if (iter != functionIds_.end()) {
+            return iter->second;
+        }
+        uint64_t id = functionIds_.size() + 1;
+        functionIds_[key] = id;
+        ProtoWriter function;
+        function.Varint(FUNCTION_ID, id);
+        function.Varint(FUNCTION_NAME, StringId(name));
+        function.Varint(FUNCTION_SYSTEM_NAME, StringId(name));
+        function.Varint(FUNCTION_FILENAME, StringId(fileName));
+        functions_.Message(PROFILE_FUNCTION, function);
+        return id;
+    }
+
+    const SampleRecord& record_;
+    const SampleFunctionNames& names_;
+    std::vector<std::string> strings_;
+    std::unordered_map<std::string, uint64_t> stringIds_;
+    std::unordered_map<uint64_t, uint64_t> locationIds_;
+    std::map<std::pair<std::string, std::string>, uint64_t> functionIds_;
+    ProtoWriter locations_;
+    ProtoWriter functions_;
+};
+}
+
+void EncodeCollapsedStacks(const SampleRecord& record, const SampleFunctionNames& names, std::string& data)
+{
+    std::map<std::string, uint64_t> stackCounts;
+    for (const auto& sample : record.samples) {
+        std::string stack;
+        // root first, the separators of the format must not show up in a name
+        auto addFrames = [&record, &names, &stack](const std::vector<uint64_t>& pcs) {
+            for (auto pc = pcs.rbegin(); pc != pcs.rend(); ++pc) {
+                std::string name = FrameName(record, names, *pc);
+                std::replace(name.begin(), name.end(), ';', ':');
+                std::replace(name.begin(), name.end(), '\n', ' ');
+                stack += (stack.empty() ? "" : ";") + name;
+            }
+        };
+        if (!sample.submitterPcs.empty()) {
+            addFrames(sample.submitterPcs);
+            stack += std::string(";") + ASYNC_FRAME;
+        }
+        addFrames(sample.pcs);
+        if (!stack.empty()) {
+            stackCounts[stack]++;
+        }
+    }
+    data.clear();
+    for (const auto& [stack, count] : stackCounts) {
+        data += stack + " " + std::to_string(count) + "\n";
+    }
+}
+
+void EncodePprofProfile(const SampleRecord& record, const SampleFunctionNames& names, std::string& data)
+{
+    PprofBuilder(record, names).Build(data);
+}
+
+bool EncodeSampleProfile(int format, const SampleRecord& record, const SampleFunctionNames& names,
+    std::string& data)
+{
+    switch (format) {
+        case SAMPLE_PROFILE_COLLAPSED:
+            EncodeCollapsedStacks(record, names, data);
+            return true;
+        case SAMPLE_PROFILE_PPROF:
+            EncodePprofProfile(record, names, data);
+            return true;
+        default:
+            data.clear();
+            return false;
+    }
+}
+} // end of namespace HiviewDFX
+} // end of namespace OHOS
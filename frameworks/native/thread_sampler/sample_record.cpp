@@ -0,0 +1,230 @@
+/*
+ * Copyright (c) 2026 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "sample_record.h"
+
+namespace OHOS {
+namespace HiviewDFX {
+namespace {
+constexpr uint32_t VARINT_BITS = 7;
+constexpr uint8_t VARINT_MASK = 0x7f;
+constexpr uint8_t VARINT_MORE = 0x80;
+constexpr uint32_t VARINT_MAX_SHIFT = 63;
+
+void PutVarint(std::string& data, uint64_t value)
+{
+    while (value > VARINT_MASK) {
+        data.push_back(static_cast<char>((value & VARINT_MASK) | VARINT_MORE));
+        value >>= VARINT_BITS;
+    }
+    data.push_back(static_cast<char>(value));
+}
+
+void PutDelta(std::string& data, uint64_t value, uint64_t& last)
+{
+    auto delta = static_cast<int64_t>(value - last);
+    last = value;
+    PutVarint(data, (static_cast<uint64_t>(delta) << 1) ^ static_cast<uint64_t>(delta >> VARINT_MAX_SHIFT));
+}
+
+void PutBytes(std::string& data, const std::string& bytes)
+{
+    PutVarint(data, bytes.size());
+    data += bytes;
+}
+
+void PutPcs(std::string& data, const std::vector<uint64_t>& pcs, uint64_t& lastPc)
+{
+    PutVarint(data, pcs.size());
+    for (auto pc : pcs) {
+        PutDelta(data, pc, lastPc);
+    }
+}
+
+class RecordReader {
+public:
+    RecordReader(const uint8_t* data, size_t size) : data_(data), size_(size) {}
+
+    bool GetVarint(uint64_t& value)
+    {
+        value = 0;
+        for (uint32_t shift = 0; shift <= VARINT_MAX_SHIFT; shift += VARINT_BITS) {
+            if (pos_ >= size_) {
+                return false;
+            }
+            uint8_t byte = data_[pos_++];
+            value |= static_cast<uint64_t>(byte & VARINT_MASK) << shift;
+            if ((byte & VARINT_MORE) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool GetDelta(uint64_t& value, uint64_t& last)
+    {
+        uint64_t zigzag = 0;
+        if (!GetVarint(zigzag)) {
+            return false;
+        }
+        last += (zigzag >> 1) ^ (~(zigzag & 1) + 1);
+        value = last;
+        return true;
+    }
+
+    // counts are checked against the bytes left so a corrupt record cannot make us allocate much
+    bool GetCount(uint64_t& count)
+    {
+        return GetVarint(count) && count <= size_ - pos_;
+    }
+
+    bool GetBytes(std::string& bytes)
+    {
+        uint64_t len = 0;
+        if (!GetCount(len)) {
+            return false;
+        }
+        bytes.assign(reinterpret_cast<const char*>(data_ + pos_), len);
+        pos_ += len;
+        return true;
+    }
+
+    bool GetPcs(std::vector<uint64_t>& pcs, uint64_t& lastPc)
+    {
+        uint64_t count = 0;
+        if (!GetCount(count)) {
+            return false;
+        }
+        pcs.resize(count);
+        for (auto& pc : pcs) {
+            if (!GetDelta(pc, lastPc)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool GetMagic()
+    {
+        if (size_ < SAMPLE_RECORD_MAGIC_LEN ||
+            std::string(reinterpret_cast<const char*>(data_), SAMPLE_RECORD_MAGIC_LEN) != SAMPLE_RECORD_MAGIC) {
+            return false;
+        }
+        pos_ = SAMPLE_RECORD_MAGIC_LEN;
+        return true;
+    }
+
+    bool AtEnd() const
+    {
+        return pos_ == size_;
+    }
+
+private:
+    const uint8_t* data_;
+    size_t size_;
+    size_t pos_ {0};
+};
+
+bool DecodeMappings(RecordReader& reader, SampleRecord& record)
+{
+    uint64_t count = 0;
+    if (!reader.GetCount(count)) {
+        return false;
+    }
+    record.mappings.resize(count);
+    for (auto& mapping : record.mappings) {
+        uint64_t size = 0;
+        uint64_t buildIdIndex = 0;
+        if (!reader.GetVarint(mapping.begin) || !reader.GetVarint(size) || !reader.GetVarint(mapping.offset) ||
+            !reader.GetVarint(buildIdIndex) || buildIdIndex > record.buildIds.size() ||
+            !reader.GetBytes(mapping.name)) {
+            return false;
+        }
+        mapping.end = mapping.begin + size;
+        mapping.buildIdIndex = static_cast<uint32_t>(buildIdIndex);
+    }
+    return true;
+}
+
+bool DecodeSamples(RecordReader& reader, SampleRecord& record)
+{
+    uint64_t count = 0;
+    if (!reader.GetCount(count)) {
+        return false;
+    }
+    record.samples.resize(count);
+    uint64_t lastTime = 0;
+    uint64_t lastPc = 0;
+    for (auto& sample : record.samples) {
+        if (!reader.GetDelta(sample.snapshotTime, lastTime) || !reader.GetPcs(sample.pcs, lastPc) ||
+            !reader.GetPcs(sample.submitterPcs, lastPc)) {
+            return false;
+        }
+    }
+    return true;
+}
+}
+
+void EncodeSampleRecord(const SampleRecord& record, std::string& data)
+{
+    data.assign(SAMPLE_RECORD_MAGIC, SAMPLE_RECORD_MAGIC_LEN);
+    PutVarint(data, static_cast<uint32_t>(record.pid));
+    PutVarint(data, static_cast<uint32_t>(record.tid));
+    PutVarint(data, record.buildIds.size());
+    for (const auto& buildId : record.buildIds) {
+        PutBytes(data, buildId);
+    }
+    PutVarint(data, record.mappings.size());
+    for (const auto& mapping : record.mappings) {
+        PutVarint(data, mapping.begin);
+        PutVarint(data, mapping.end - mapping.begin);
+        PutVarint(data, mapping.offset);
+        PutVarint(data, mapping.buildIdIndex);
+        PutBytes(data, mapping.name);
+    }
+    PutVarint(data, record.samples.size());
+    uint64_t lastTime = 0;
+    uint64_t lastPc = 0;
+    for (const auto& sample : record.samples) {
+        PutDelta(data, sample.snapshotTime, lastTime);
+        PutPcs(data, sample.pcs, lastPc);
+        PutPcs(data, sample.submitterPcs, lastPc);
+    }
+}
+
+bool DecodeSampleRecord(const uint8_t* data, size_t size, SampleRecord& record)
+{
+    if (data == nullptr) {
+        return false;
+    }
+    RecordReader reader(data, size);
+    uint64_t pid = 0;
+    uint64_t tid = 0;
+    uint64_t buildIdCount = 0;
+    if (!reader.GetMagic() || !reader.GetVarint(pid) || !reader.GetVarint(tid) || !reader.GetCount(buildIdCount)) {
+        return false;
+    }
+    record.pid = static_cast<int32_t>(pid);
+    record.tid = static_cast<int32_t>(tid);
+    record.buildIds.resize(buildIdCount);
+    for (auto& buildId : record.buildIds) {
+        if (!reader.GetBytes(buildId)) {
+            return false;
+        }
+    }
+    return DecodeMappings(reader, record) && DecodeSamples(reader, record) && reader.AtEnd();
+}
+} // end of namespace HiviewDFX
+} // end of namespace OHOS
@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2026 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef RELIABILITY_SAMPLE_SYMBOLIZER_H
+#define RELIABILITY_SAMPLE_SYMBOLIZER_H
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "sample_profile.h"
+#include "sample_record.h"
+
+namespace OHOS {
+namespace HiviewDFX {
+/*
+ * Symbolizer of a SampleRecord away from the sampled process, on the host or by another process on
+ * the device. Symbols are read from the .symtab and .dynsym of 64-bit ELF files, looked up by build id
+ * in the symbol directories first and then by the mapping name below them.
+ */
+class SampleSymbolizer {
+public:
+    // Searched in the order added, for <dir>/.build-id/xx/yyyy.debug, <dir>/<build id> and <dir>/<mapping name>.
+    void AddSymbolDir(const std::string& dir);
+    // Print the samples in the flat format of ThreadSamplerCollect.
+    bool Symbolize(const SampleRecord& record, std::string& stack);
+    bool Symbolize(const std::string& data, std::string& stack);
+    // The function names of the sampled pcs, to export the record by EncodeSampleProfile.
+    void GetFunctionNames(const SampleRecord& record, SampleFunctionNames& names);
+
+    static std::string ToHex(const std::string& bytes);
+
+private:
+    struct ElfSymbol {
+        uint64_t addr = 0;
+        uint64_t size = 0;
+        std::string name;
+    };
+
+    struct ElfSegment {
+        uint64_t offset = 0;
+        uint64_t vaddr = 0;
+        uint64_t fileSize = 0;
+    };
+
+    struct ElfFile {
+        std::string buildId;
+        std::vector<ElfSegment> segments;
+        std::vector<ElfSymbol> symbols; // sorted by addr
+    };
+
+    const ElfSymbol* FindSymbol(uint64_t pc, const SampleRecord& record, const SampleRecordMapping& mapping,
+        uint64_t& relPc);
+    ElfFile* FindElf(const SampleRecord& record, const SampleRecordMapping& mapping);
+    std::unique_ptr<ElfFile> LoadElf(const std::string& path);
+    std::string FormatFrame(size_t index, uint64_t pc, const SampleRecord& record);
+    void FormatStack(const std::vector<uint64_t>& pcs, const SampleRecord& record, std::string& stack);
+
+    std::vector<std::string> symbolDirs_;
+    std::map<std::string, std::unique_ptr<ElfFile>> elfs_; // by build id or mapping name, null when not found
+};
+} // end of namespace HiviewDFX
+} // end of namespace OHOS
+#endif
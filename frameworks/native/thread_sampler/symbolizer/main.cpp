@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2026 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+
+#include "sample_symbolizer.h"
+
+using namespace OHOS::HiviewDFX;
+
+namespace {
+constexpr int TEXT_FORMAT = -1;
+constexpr int INVALID_FORMAT = -2;
+
+void PrintUsage(const char* name)
+{
+    printf("usage: %s [-s symbol_dir]... [-f text|collapsed|pprof] record_file [output_file]\n"
+        "  symbolize a freeze sample record saved by ThreadSamplerCollectRecord,\n"
+        "  ELF files are looked up by build id and mapping name below every symbol_dir.\n"
+        "  -f: text stacks by default, collapsed stacks for flamegraphs or a pprof profile.\n", name);
+}
+
+bool ExportProfile(SampleSymbolizer& symbolizer, const std::string& data, int format, std::string& output)
+{
+    SampleRecord record;
+    if (!DecodeSampleRecord(reinterpret_cast<const uint8_t*>(data.data()), data.size(), record) ||
+        record.samples.empty()) {
+        return false;
+    }
+    SampleFunctionNames names;
+    symbolizer.GetFunctionNames(record, names);
+    return EncodeSampleProfile(format, record, names, output);
+}
+}
+
+int main(int argc, char* argv[])
+{
+    SampleSymbolizer symbolizer;
+    std::string recordFile;
+    std::string outputFile;
+    int format = TEXT_FORMAT;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            symbolizer.AddSymbolDir(argv[++i]);
+        } else if (strcmp(argv[i], "-f") == 0 && i + 1 < argc) {
+            std::string name = argv[++i];
+            format = (name == "collapsed") ? SAMPLE_PROFILE_COLLAPSED : (name == "pprof") ? SAMPLE_PROFILE_PPROF :
+                (name == "text") ? TEXT_FORMAT : INVALID_FORMAT;
+        } else if (recordFile.empty()) {
+            recordFile = argv[i];
+        } else if (outputFile.empty()) {
+            outputFile = argv[i];
+        } else {
+            PrintUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (recordFile.empty() || format == INVALID_FORMAT) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+    std::ifstream input(recordFile, std::ios::binary);
+    if (!input) {
+        fprintf(stderr, "open %s failed\n", recordFile.c_str());
+        return 1;
+    }
+    std::string data((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+    std::string stack;
+    bool symbolized = (format == TEXT_FORMAT) ? symbolizer.Symbolize(data, stack) :
+        ExportProfile(symbolizer, data, format, stack);
+    if (!symbolized) {
+        fprintf(stderr, "%s is not a sample record or has no sample\n", recordFile.c_str());
+        return 1;
+    }
+    if (outputFile.empty()) {
+        std::cout << stack;
+        return 0;
+    }
+    std::ofstream output(outputFile, std::ios::binary);
+    output << stack;
+    return output ? 0 : 1;
+}
@@ -0,0 +1,296 @@
+/*
+ * Copyright (c) 2026 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "sample_symbolizer.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <elf.h>
+#include <fstream>
+#include <iterator>
+
+namespace OHOS {
+namespace HiviewDFX {
+namespace {
+constexpr uint64_t NANOSEC_PER_SEC = 1000 * 1000 * 1000;
+constexpr uint64_t NANOSEC_PER_MICROSEC = 1000;
+constexpr size_t FORMAT_BUF_LEN = 64;
+constexpr size_t BUILD_ID_DIR_LEN = 2;
+constexpr uint64_t NOTE_ALIGN = 4;
+constexpr char GNU_NOTE_NAME[] = "GNU";
+constexpr char HEX_DIGITS[] = "0123456789abcdef";
+constexpr uint32_t HEX_SHIFT = 4;
+constexpr uint8_t HEX_MASK = 0xf;
+
+bool InFile(const std::string& file, uint64_t offset, uint64_t size)
+{
+    return offset <= file.size() && size <= file.size() - offset;
+}
+
+template<typename T>
+const T* FileAt(const std::string& file, uint64_t offset)
+{
+    return InFile(file, offset, sizeof(T)) ? reinterpret_cast<const T*>(file.data() + offset) : nullptr;
+}
+
+uint64_t AlignNote(uint64_t size)
+{
+    return (size + NOTE_ALIGN - 1) & ~(NOTE_ALIGN - 1);
+}
+
+std::string ReadBuildId(const std::string& file, const Elf64_Phdr& phdr)
+{
+    uint64_t pos = phdr.p_offset;
+    uint64_t end = phdr.p_offset + phdr.p_filesz;
+    while (pos + sizeof(Elf64_Nhdr) <= end) {
+        const auto* nhdr = FileAt<Elf64_Nhdr>(file, pos);
+        if (nhdr == nullptr) {
+            break;
+        }
+        uint64_t nameOffset = pos + sizeof(Elf64_Nhdr);
+        uint64_t descOffset = nameOffset + AlignNote(nhdr->n_namesz);
+        pos = descOffset + AlignNote(nhdr->n_descsz);
+        if (pos > end || !InFile(file, descOffset, nhdr->n_descsz)) {
+            break;
+        }
+        if (nhdr->n_type == NT_GNU_BUILD_ID && nhdr->n_namesz == sizeof(GNU_NOTE_NAME) &&
+            memcmp(file.data() + nameOffset, GNU_NOTE_NAME, sizeof(GNU_NOTE_NAME)) == 0) {
+            return file.substr(descOffset, nhdr->n_descsz);
+        }
+    }
+    return "";
+}
+
+std::string FormatTime(uint64_t time)
+{
+    time_t sec = static_cast<time_t>(time / NANOSEC_PER_SEC);
+    struct tm localTime = {};
+    localtime_r(&sec, &localTime);
+    char buf[FORMAT_BUF_LEN] = {0};
+    size_t len = strftime(buf, sizeof(buf), "%Y-%m-%d-%H-%M-%S", &localTime);
+    snprintf(buf + len, sizeof(buf) - len, ".%06" PRIu64, (time % NANOSEC_PER_SEC) / NANOSEC_PER_MICROSEC);
+    return buf;
+}
+}
+
+void SampleSymbolizer::AddSymbolDir(const std::string& dir)
+{
+    symbolDirs_.push_back(dir);
+}
+
+std::string SampleSymbolizer::ToHex(const std::string& bytes)
+{
+    std::string hex;
+    for (auto c : bytes) {
+        auto byte = static_cast<uint8_t>(c);
+        hex.push_back(HEX_DIGITS[byte >> HEX_SHIFT]);
+        hex.push_back(HEX_DIGITS[byte & HEX_MASK]);
+    }
+    return hex;
+}
+
+std::unique_ptr<SampleSymbolizer::ElfFile> SampleSymbolizer::LoadElf(const std::string& path)
+{
+    std::ifstream stream(path, std::ios::binary);
+    if (!stream) {
+        return nullptr;
+    }
+    std::string file((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+    const auto* ehdr = FileAt<Elf64_Ehdr>(file, 0);
+    if (ehdr == nullptr || memcmp(ehdr->e_ident, ELFMAG, SELFMAG) != 0 || ehdr->e_ident[EI_CLASS] != ELFCLASS64 ||
+        ehdr->e_phentsize != sizeof(Elf64_Phdr) || ehdr->e_shentsize != sizeof(Elf64_Shdr)) {
+        return nullptr;
+    }
+    auto elf = std::make_unique<ElfFile>();
+    for (uint16_t i = 0; i < ehdr->e_phnum; i++) {
+        const auto* phdr = FileAt<Elf64_Phdr>(file, ehdr->e_phoff + i * sizeof(Elf64_Phdr));
+        if (phdr == nullptr) {
+            return nullptr;
+        }
+        if (phdr->p_type == PT_LOAD) {
+            elf->segments.push_back({phdr->p_offset, phdr->p_vaddr, phdr->p_filesz});
+        } else if (phdr->p_type == PT_NOTE && elf->buildId.empty()) {
+            elf->buildId = ReadBuildId(file, *phdr);
+        }
+    }
+    for (uint16_t i = 0; i < ehdr->e_shnum; i++) {
+        const auto* shdr = FileAt<Elf64_Shdr>(file, ehdr->e_shoff + i * sizeof(Elf64_Shdr));
+        if (shdr == nullptr || (shdr->sh_type != SHT_SYMTAB && shdr->sh_type != SHT_DYNSYM) ||
+            shdr->sh_entsize != sizeof(Elf64_Sym)) {
+            continue;
+        }
+        const auto* strtab = FileAt<Elf64_Shdr>(file, ehdr->e_shoff + shdr->sh_link * sizeof(Elf64_Shdr));
+        if (strtab == nullptr || !InFile(file, shdr->sh_offset, shdr->sh_size) ||
+            !InFile(file, strtab->sh_offset, strtab->sh_size)) {
+            continue;
+        }
+        for (uint64_t pos = 0; pos + sizeof(Elf64_Sym) <= shdr->sh_size; pos += sizeof(Elf64_Sym)) {
+            const auto* sym = FileAt<Elf64_Sym>(file, shdr->sh_offset + pos);
+            if (ELF64_ST_TYPE(sym->st_info) != STT_FUNC || sym->st_value == 0 || sym->st_name >= strtab->sh_size) {
+                continue;
+            }
+            const char* name = file.data() + strtab->sh_offset + sym->st_name;
+            elf->symbols.push_back({sym->st_value, sym->st_size, std::string(name,
+                strnlen(name, strtab->sh_size - sym->st_name))});
+        }
+    }
+    // .symtab and .dynsym share most functions, keep one of each address
+    std::sort(elf->symbols.begin(), elf->symbols.end(), [](const ElfSymbol& a, const ElfSymbol& b) {
+        return a.addr < b.addr;
+    });
+    elf->symbols.erase(std::unique(elf->symbols.begin(), elf->symbols.end(),
+        [](const ElfSymbol& a, const ElfSymbol& b) { return a.addr == b.addr; }), elf->symbols.end());
+    return elf;
+}
+
+SampleSymbolizer::ElfFile* SampleSymbolizer::FindElf(const SampleRecord& record, const SampleRecordMapping& mapping)
+{
+    std::string buildId = (mapping.buildIdIndex != SAMPLE_RECORD_NO_BUILD_ID) ?
+        record.buildIds[mapping.buildIdIndex - 1] : "";
+    std::string key = buildId.empty() ? mapping.name : buildId;
+    auto iter = elfs_.find(key);
+    if (iter != elfs_.end()) {
+        return iter->second.get();
+    }
+    std::vector<std::string> paths;
+    std::string hex = ToHex(buildId);
+    for (const auto& dir : symbolDirs_) {
+        if (hex.size() > BUILD_ID_DIR_LEN) {
+            paths.push_back(dir + "/.build-id/" + hex.substr(0, BUILD_ID_DIR_LEN) + "/" +
+                hex.substr(BUILD_ID_DIR_LEN) + ".debug");
+            paths.push_back(dir + "/" + hex);
+        }
+        paths.push_back(dir + mapping.name);
+    }
+    paths.push_back(mapping.name);
+    std::unique_ptr<ElfFile> found;
+    for (const auto& path : paths) {
+        auto elf = LoadElf(path);
+        // a file found by name may be another build than the one sampled
+        if (elf != nullptr && (buildId.empty() || elf->buildId == buildId)) {
+            found = std::move(elf);
+            break;
+        }
+    }
+    auto& elf = elfs_[key];
+    elf = std::move(found);
+    return elf.get();
+}
+
+const SampleSymbolizer::ElfSymbol* SampleSymbolizer::FindSymbol(uint64_t pc, const SampleRecord& record,
+    const SampleRecordMapping& mapping, uint64_t& relPc)
+{
+    relPc = pc - mapping.begin + mapping.offset;
+    ElfFile* elf = FindElf(record, mapping);
+    if (elf == nullptr) {
+        return nullptr;
+    }
+    // file offset to the address the symbols are given in
+    for (const auto& segment : elf->segments) {
+        if (relPc >= segment.offset && relPc < segment.offset + segment.fileSize) {
+            relPc = relPc - segment.offset + segment.vaddr;
+            break;
+        }
+    }
+    auto symbol = std::upper_bound(elf->symbols.begin(), elf->symbols.end(), relPc,
+        [](uint64_t addr, const ElfSymbol& sym) { return addr < sym.addr; });
+    if (symbol != elf->symbols.begin() && relPc < (--symbol)->addr + std::max<uint64_t>(symbol->size, 1)) {
+        return &(*symbol);
+    }
+    return nullptr;
+}
+
+std::string SampleSymbolizer::FormatFrame(size_t index, uint64_t pc, const SampleRecord& record)
+{
+    char head[FORMAT_BUF_LEN] = {0};
+    auto mapping = std::find_if(record.mappings.begin(), record.mappings.end(),
+        [pc](const SampleRecordMapping& map) { return pc >= map.begin && pc < map.end; });
+    if (mapping == record.mappings.end()) {
+        snprintf(head, sizeof(head), "#%02zu pc %016" PRIx64 " [Unknown]\n", index, pc);
+        return head;
+    }
+    uint64_t relPc = 0;
+    std::string func;
+    const ElfSymbol* symbol = FindSymbol(pc, record, *mapping, relPc);
+    if (symbol != nullptr) {
+        func = "(" + symbol->name + "+" + std::to_string(relPc - symbol->addr) + ")";
+    }
+    snprintf(head, sizeof(head), "#%02zu pc %016" PRIx64 " ", index, relPc);
+    std::string frame = head + mapping->name + func;
+    if (mapping->buildIdIndex != SAMPLE_RECORD_NO_BUILD_ID) {
+        frame += "(" + ToHex(record.buildIds[mapping->buildIdIndex - 1]) + ")";
+    }
+    return frame + "\n";
+}
+
+void SampleSymbolizer::FormatStack(const std::vector<uint64_t>& pcs, const SampleRecord& record, std::string& stack)
+{
+    for (size_t i = 0; i < pcs.size(); i++) {
+        stack += FormatFrame(i, pcs[i], record);
+    }
+}
+
+bool SampleSymbolizer::Symbolize(const SampleRecord& record, std::string& stack)
+{
+    stack.clear();
+    for (const auto& sample : record.samples) {
+        if (sample.snapshotTime != 0) {
+            stack += "SnapshotTime:" + FormatTime(sample.snapshotTime) + "\n";
+        }
+        FormatStack(sample.pcs, record, stack);
+        if (!sample.submitterPcs.empty()) {
+            stack += "========SubmitterStacktrace========\n";
+            FormatStack(sample.submitterPcs, record, stack);
+        }
+        stack += "\n";
+    }
+    return !record.samples.empty();
+}
+
+void SampleSymbolizer::GetFunctionNames(const SampleRecord& record, SampleFunctionNames& names)
+{
+    auto addNames = [this, &record, &names](const std::vector<uint64_t>& pcs) {
+        for (auto pc : pcs) {
+            if (names.find(pc) != names.end()) {
+                continue;
+            }
+            auto mapping = std::find_if(record.mappings.begin(), record.mappings.end(),
+                [pc](const SampleRecordMapping& map) { return pc >= map.begin && pc < map.end; });
+            uint64_t relPc = 0;
+            const ElfSymbol* symbol = (mapping == record.mappings.end()) ? nullptr :
+                FindSymbol(pc, record, *mapping, relPc);
+            names[pc] = (symbol == nullptr) ? "" : symbol->name;
+        }
+    };
+    for (const auto& sample : record.samples) {
+        addNames(sample.pcs);
+        addNames(sample.submitterPcs);
+    }
+}
+
+bool SampleSymbolizer::Symbolize(const std::string& data, std::string& stack)
+{
+    SampleRecord record;
+    if (!DecodeSampleRecord(reinterpret_cast<const uint8_t*>(data.data()), data.size(), record)) {
+        stack.clear();
+        return false;
+    }
+    return Symbolize(record, stack);
+}
+} // end of namespace HiviewDFX
+} // end of namespace OHOS
@@ -15,14 +15,21 @@
 
 #include "thread_sampler.h"
 
+#include <algorithm>
 #include <atomic>
 #include <condition_variable>
 #include <csignal>
+#include <cstddef>
 #include <memory>
 #include <queue>
 #include <set>
 #include <string>
+#include <unordered_map>
 
+#include <pthread.h>
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
 #include <sys/mman.h>
 #include <sys/prctl.h>
 #include <syscall.h>
@@ -39,6 +46,32 @@
 
 namespace OHOS {
 namespace HiviewDFX {
+namespace {
+constexpr uint32_t ADAPTIVE_COPY_HEADROOM = 2 * 1024;
+constexpr uint32_t STACK_COPY_ALIGN = 16;
+constexpr uint64_t NANOSEC_PER_MILLISEC = 1000 * 1000;
+constexpr uint64_t NANOSEC_PER_SEC = 1000 * 1000 * 1000;
+constexpr uint64_t PERMILLE = 1000;
+constexpr uint64_t PERMILLE_DECIMAL = 10;
+
+// Only plain loads and stores are allowed in the signal handler, the loop must not become a memcpy call.
+// sp is 16 bytes aligned and size a multiple of 16.
+NO_SANITIZER __attribute__((no_builtin("memcpy"))) void CopyStack(uint8_t* dst, uintptr_t src, size_t size)
+{
+    size_t pos = 0;
+#if defined(__ARM_NEON) && defined(__aarch64__)
+    constexpr size_t blockSize = 64;
+    for (; pos + blockSize <= size; pos += blockSize) {
+        uint64x2x4_t block = vld1q_u64_x4(reinterpret_cast<const uint64_t*>(src + pos));
+        vst1q_u64_x4(reinterpret_cast<uint64_t*>(dst + pos), block);
+    }
+#endif
+    for (; pos + sizeof(uintptr_t) <= size; pos += sizeof(uintptr_t)) {
+        *reinterpret_cast<uintptr_t*>(dst + pos) = *reinterpret_cast<const uintptr_t*>(src + pos);
+    }
+}
+}
+
 void ThreadSampler::ThreadSamplerSignalHandler(int sig, siginfo_t* si, void* context)
 {
 #if defined(__aarch64__) || defined(__loongarch_lp64)
@@ -89,15 +122,22 @@ int ThreadSampler::AccessMem(uintptr_t addr, uintptr_t* val, void* arg)
     }
 
     *val = 0;
-    if (addr < unwindInfo->context->sp || addr + sizeof(uintptr_t) >= unwindInfo->context->sp + STACK_BUFFER_SIZE) {
+    ThreadUnwindContext* context = unwindInfo->context;
+    if (addr < context->sp || addr + sizeof(uintptr_t) >= context->sp + STACK_BUFFER_SIZE) {
         return ThreadSampler::GetInstance().AccessElfMem(addr, val);
     } else {
-        size_t stackOffset = addr - unwindInfo->context->sp;
+        size_t stackOffset = addr - context->sp;
         if (stackOffset >= STACK_BUFFER_SIZE) {
             XCOLLIE_LOGE("limit stack\n");
             return -1;
         }
-        *val = *(reinterpret_cast<uintptr_t*>(&unwindInfo->context->buffer[stackOffset]));
+        if (stackOffset + sizeof(uintptr_t) > context->copySize) {
+            // the buffer holds the previous sample there
+            context->truncated = (context->copySize < context->stackSize);
+            return -1;
+        }
+        context->usedSize = std::max(context->usedSize, static_cast<uint32_t>(stackOffset + sizeof(uintptr_t)));
+        *val = *(reinterpret_cast<uintptr_t*>(&context->buffer[stackOffset]));
     }
     return 0;
 }
@@ -113,18 +153,30 @@ int ThreadSampler::GetMapByPc(uintptr_t pc, std::shared_ptr<DfxMap>& map, void*
     return unwindInfo->maps->FindMapByAddr(pc, map) ? 0 : -1;
 }
 
-bool ThreadSampler::Init(size_t collectStackCount, bool recordSubmitterStack)
+bool ThreadSampler::Init(size_t collectStackCount, bool recordSubmitterStack, int32_t tid)
 {
-    if (init_) {
-        return true;
+    bool firstInit = !init_;
+    if (firstInit && !InitSampler()) {
+        return false;
     }
-
-    if (!InitRecordBuffer()) {
-        XCOLLIE_LOGE("Failed to InitRecordBuffer\n");
+    // the flight recorder kept the unwinder and the main thread since the last session
+    bool firstSession = !session_;
+    if (firstSession && ((!firstInit && !RefreshMaps()) || !InitSession(collectStackCount, recordSubmitterStack))) {
         Deinit();
         return false;
     }
+    if (!AddThread((tid == 0) ? pid_ : tid)) {
+        XCOLLIE_LOGE("Failed to add thread %{public}d\n", tid);
+        if (firstSession) {
+            Deinit();
+        }
+        return false;
+    }
+    return true;
+}
 
+bool ThreadSampler::InitSampler()
+{
     if (!InitUnwinder()) {
         XCOLLIE_LOGE("Failed to InitUnwinder\n");
         Deinit();
@@ -132,60 +184,207 @@ bool ThreadSampler::Init(size_t collectStackCount, bool recordSubmitterStack)
     }
 
     pid_ = getprocpid();
+    init_ = true;
+    return true;
+}
+
+bool ThreadSampler::InitSession(size_t collectStackCount, bool recordSubmitterStack)
+{
     if (!InitStackPrinter()) {
         XCOLLIE_LOGE("Failed to InitUniqueStackTable\n");
-        Deinit();
         return false;
     }
 
     if (collectStackCount == 0) {
         XCOLLIE_LOGE("Invalid collectStackCount\n");
-        Deinit();
         return false;
     }
     processStartTime_ = GetCurrentTimeNanoseconds();
-    timeStampedPcsList_.reserve(collectStackCount);
-    submitterStackIds_ = std::make_unique<uint64_t[]>(collectStackCount);
-    submitterStackIdIndex_ = 0;
+    // the main thread kept by the flight recorder records this session too
+    for (auto& thread : threads_) {
+        if (thread.tid.load(std::memory_order_acquire) != 0) {
+            thread.timeStampedPcsList.reserve(collectStackCount);
+            thread.submitterStackIds = std::make_unique<uint64_t[]>(collectStackCount);
+            thread.submitterStackIdIndex = 0;
+        }
+    }
     submitterStackIdsMaxSize_ = collectStackCount;
     recordSubmitterStack_ = recordSubmitterStack;
+    session_ = true;
+    return true;
+}
 
-    init_ = true;
+bool ThreadSampler::AddThread(int32_t tid)
+{
+    if (tid <= 0) {
+        return false;
+    }
+    if (FindThread(tid) != nullptr) {
+        return true;
+    }
+    SampledThread* thread = nullptr;
+    for (auto& entry : threads_) {
+        if (entry.tid.load(std::memory_order_relaxed) == 0) {
+            thread = &entry;
+            break;
+        }
+    }
+    if (thread == nullptr) {
+        XCOLLIE_LOGE("Too many sampled threads, max:%{public}d\n", MAX_SAMPLED_THREAD_NUM);
+        return false;
+    }
+    uintptr_t stackBegin = 0;
+    if (!GetThreadStackRange(tid, stackBegin, thread->stackEnd)) {
+        XCOLLIE_LOGE("Failed to get stack range of %{public}d\n", tid);
+        return false;
+    }
+    thread->stackBegin = stackBegin;
+    thread->straySp = 0;
+    thread->strayBegin = 0;
+    thread->strayEnd = 0;
+    thread->depth = ringDepth_;
+    if (!InitRecordBuffer(*thread)) {
+        XCOLLIE_LOGE("Failed to InitRecordBuffer\n");
+        return false;
+    }
+    thread->head = 0;
+    thread->tail = 0;
+    thread->requestTime = 0;
+    thread->droppedCount = 0;
+    thread->residencyTimes.clear();
+    thread->residencyTotal = 0;
+    thread->residencyMax = 0;
+    thread->copyLimit = STACK_BUFFER_SIZE;
+    std::fill(std::begin(thread->usedSizes), std::end(thread->usedSizes), STACK_BUFFER_SIZE);
+    thread->usedSizeIndex = 0;
+    thread->timeStampedPcsList.reserve(submitterStackIdsMaxSize_);
+    thread->submitterStackIds = std::make_unique<uint64_t[]>(submitterStackIdsMaxSize_);
+    thread->submitterStackIdIndex = 0;
+    // the signal handler may look the thread up from now on
+    thread->tid.store(tid, std::memory_order_release);
     return true;
 }
 
-bool ThreadSampler::InitRecordBuffer()
+bool ThreadSampler::GetThreadStackRange(int32_t tid, uintptr_t& stackBegin, uintptr_t& stackEnd)
 {
-    if (mmapStart_ != MAP_FAILED) {
+    if (tid == pid_) {
+        return maps_->GetStackRange(stackBegin, stackEnd);
+    }
+    if (tid == gettid()) {
+        pthread_attr_t attr;
+        if (pthread_getattr_np(pthread_self(), &attr) != 0) {
+            return false;
+        }
+        void* stackAddr = nullptr;
+        size_t stackSize = 0;
+        int ret = pthread_attr_getstack(&attr, &stackAddr, &stackSize);
+        pthread_attr_destroy(&attr);
+        if (ret != 0 || stackAddr == nullptr) {
+            return false;
+        }
+        stackBegin = reinterpret_cast<uintptr_t>(stackAddr);
+        stackEnd = stackBegin + stackSize;
+        return true;
+    }
+    // the stack of another thread is only known by the name of its mapping, the maps are reloaded
+    // when it was created after the sampler
+    const std::string names[] = {
+        "stack_and_tls:" + std::to_string(tid) + "]",
+        "[stack:" + std::to_string(tid) + "]",
+    };
+    std::shared_ptr<DfxMaps> maps = maps_;
+    for (int retry = 0; retry < 2 && maps != nullptr; retry++) {
+        for (const auto& map : maps->GetMaps()) {
+            if (map == nullptr) {
+                continue;
+            }
+            for (const auto& name : names) {
+                if (map->name.find(name) != std::string::npos) {
+                    stackBegin = map->begin;
+                    stackEnd = map->end;
+                    return true;
+                }
+            }
+        }
+        maps = DfxMaps::Create();
+    }
+    return false;
+}
+
+void ThreadSampler::UpdateStackRange(SampledThread& thread, uintptr_t sp)
+{
+    if (sp >= thread.strayBegin && sp < thread.strayEnd) {
+        return;
+    }
+    // a grown stack mapping is only seen in fresh maps
+    std::shared_ptr<DfxMaps> maps = DfxMaps::Create();
+    if (maps == nullptr) {
+        return;
+    }
+    for (const auto& map : maps->GetMaps()) {
+        if (map == nullptr || sp < map->begin || sp >= map->end) {
+            continue;
+        }
+        // the stack grows down, its mapping then holds sp below the known range and the range itself
+        if (sp < thread.stackBegin.load(std::memory_order_relaxed) && map->end >= thread.stackEnd) {
+            thread.stackBegin.store(map->begin, std::memory_order_relaxed);
+            XCOLLIE_LOGI("Stack of %{public}d grew down to %{public}llx.\n", thread.tid.load(),
+                static_cast<unsigned long long>(map->begin));
+            return;
+        }
+        // an alternate signal stack or a coroutine stack, not looked up again while sp stays in it
+        thread.strayBegin = map->begin;
+        thread.strayEnd = map->end;
+        return;
+    }
+}
+
+SampledThread* ThreadSampler::FindThread(int32_t tid)
+{
+    for (auto& thread : threads_) {
+        if (thread.tid.load(std::memory_order_acquire) == tid) {
+            return &thread;
+        }
+    }
+    return nullptr;
+}
+
+bool ThreadSampler::InitRecordBuffer(SampledThread& thread)
+{
+    if (thread.mmapStart != MAP_FAILED) {
         return true;
     }
     // create buffer
-    bufferSize_ = SAMPLER_MAX_BUFFER_SZ * sizeof(struct ThreadUnwindContext);
-    mmapStart_ = mmap(nullptr, bufferSize_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
-    if (mmapStart_ == MAP_FAILED) {
+    thread.bufferSize = thread.depth * sizeof(struct ThreadUnwindContext);
+    thread.mmapStart = mmap(nullptr, thread.bufferSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (thread.mmapStart == MAP_FAILED) {
         XCOLLIE_LOGE("Failed to create buffer for thread sampler!(%{public}d)\n", errno);
         return false;
     }
 
-    prctl(PR_SET_VMA, PR_SET_VMA_ANON_NAME, mmapStart_, bufferSize_, "sampler_buf");
+    prctl(PR_SET_VMA, PR_SET_VMA_ANON_NAME, thread.mmapStart, thread.bufferSize, "sampler_buf");
     return true;
 }
 
-void ThreadSampler::ReleaseRecordBuffer()
+void ThreadSampler::ReleaseRecordBuffer(SampledThread& thread)
 {
-    if (mmapStart_ == MAP_FAILED) {
+    if (thread.mmapStart == MAP_FAILED) {
         return;
     }
     // release buffer
-    if (munmap(mmapStart_, bufferSize_) != 0) {
+    if (munmap(thread.mmapStart, thread.bufferSize) != 0) {
         XCOLLIE_LOGE("Failed to release buffer!(%{public}d)\n", errno);
         return;
     }
-    mmapStart_ = MAP_FAILED;
+    thread.mmapStart = MAP_FAILED;
 }
 
 bool ThreadSampler::InitUnwinder()
 {
+    if (unwinder_ != nullptr && maps_ != nullptr) {
+        // warm from the last session
+        return RefreshMaps();
+    }
     accessors_ = std::make_shared<OHOS::HiviewDFX::UnwindAccessors>();
     accessors_->AccessReg = nullptr;
     accessors_->AccessMem = &ThreadSampler::AccessMem;
@@ -194,18 +393,65 @@ bool ThreadSampler::InitUnwinder()
     unwinder_ = std::make_shared<Unwinder>(accessors_, true);
     unwinder_->EnableFillFrames(true);
 
+    loadCountsValid_ = GetLoadCounts(loadAdds_, loadSubs_);
     maps_ = DfxMaps::Create();
     if (maps_ == nullptr) {
         XCOLLIE_LOGE("maps is nullptr\n");
         return false;
     }
-    if (!maps_->GetStackRange(stackBegin_, stackEnd_)) {
-        XCOLLIE_LOGE("Failed to get stack range\n");
+    return true;
+}
+
+bool ThreadSampler::RefreshMaps()
+{
+    uint64_t adds = 0;
+    uint64_t subs = 0;
+    bool countsValid = GetLoadCounts(adds, subs);
+    if (countsValid && loadCountsValid_ && adds == loadAdds_ && subs == loadSubs_) {
+        return true;
+    }
+    auto maps = DfxMaps::Create();
+    if (maps == nullptr) {
+        XCOLLIE_LOGE("maps is nullptr\n");
         return false;
     }
+    // a mapping still in place keeps its parsed ELF and unwind tables
+    std::unordered_map<uint64_t, std::shared_ptr<DfxMap>> oldMaps;
+    for (const auto& map : maps_->GetMaps()) {
+        if (map != nullptr && map->elf != nullptr) {
+            oldMaps[map->begin] = map;
+        }
+    }
+    size_t reused = 0;
+    for (const auto& map : maps->GetMaps()) {
+        auto iter = (map != nullptr) ? oldMaps.find(map->begin) : oldMaps.end();
+        if (iter == oldMaps.end()) {
+            continue;
+        }
+        const auto& old = iter->second;
+        if (old->end == map->end && old->offset == map->offset && old->inode == map->inode && old->name == map->name) {
+            map->elf = old->elf;
+            reused++;
+        }
+    }
+    // a pc cached as a frame may now belong to another library
+    if (!countsValid || !loadCountsValid_ || subs != loadSubs_) {
+        frameCache_.clear();
+    }
+    XCOLLIE_LOGI("Refresh maps, reused elf:%{public}zu\n", reused);
+    maps_ = maps;
+    loadAdds_ = adds;
+    loadSubs_ = subs;
+    loadCountsValid_ = countsValid;
     return true;
 }
 
+void ThreadSampler::SetWarmCache(bool enable)
+{
+    // a cache kept from the last session goes with the next Deinit or with the library
+    warmCache_ = enable;
+}
+
 bool ThreadSampler::InitStackPrinter()
 {
     if (stackPrinter_ != nullptr) {
@@ -220,11 +466,43 @@ bool ThreadSampler::InitStackPrinter()
     return true;
 }
 
+bool ThreadSampler::InitSymbolizer()
+{
+    uint64_t adds = 0;
+    uint64_t subs = 0;
+    bool countsValid = GetLoadCounts(adds, subs);
+    if (symbolizerMaps_ != nullptr && countsValid && symbolizerCountsValid_ &&
+        adds == symbolizerAdds_ && subs == symbolizerSubs_) {
+        return true;
+    }
+    // own maps and ELF, the sessions refresh and unwind theirs on the sampling thread meanwhile
+    auto maps = DfxMaps::Create();
+    if (maps == nullptr) {
+        XCOLLIE_LOGE("maps is nullptr\n");
+        return false;
+    }
+    if (symbolizerUnwinder_ == nullptr) {
+        auto accessors = std::make_shared<OHOS::HiviewDFX::UnwindAccessors>();
+        accessors->AccessReg = nullptr;
+        accessors->AccessMem = &ThreadSampler::AccessMem;
+        accessors->GetMapByPc = &ThreadSampler::GetMapByPc;
+        accessors->FindUnwindTable = &ThreadSampler::FindUnwindTable;
+        symbolizerUnwinder_ = std::make_shared<Unwinder>(accessors, true);
+    }
+    symbolizerCache_.clear();
+    symbolizerMaps_ = maps;
+    symbolizerAdds_ = adds;
+    symbolizerSubs_ = subs;
+    symbolizerCountsValid_ = countsValid;
+    return true;
+}
+
 void ThreadSampler::DestroyUnwinder()
 {
     maps_.reset();
     unwinder_.reset();
     accessors_.reset();
+    frameCache_.clear();
 }
 
 int ThreadSampler::AccessElfMem(uintptr_t addr, uintptr_t* val)
@@ -246,80 +524,100 @@ int ThreadSampler::AccessElfMem(uintptr_t addr, uintptr_t* val)
     return -1;
 }
 
-ThreadUnwindContext* ThreadSampler::GetReadContext()
+ThreadUnwindContext* ThreadSampler::GetReadContext(SampledThread& thread)
 {
-    if (mmapStart_ == MAP_FAILED) {
+    if (thread.mmapStart == MAP_FAILED) {
         return nullptr;
     }
-    ThreadUnwindContext* contextArray = static_cast<ThreadUnwindContext*>(mmapStart_);
-    int32_t index = readIndex_;
-    if (contextArray[index].requestTime == 0 || contextArray[index].snapshotTime == 0) {
+    uint64_t tail = thread.tail.load(std::memory_order_relaxed);
+    if (tail == thread.head.load(std::memory_order_acquire)) {
         return nullptr;
     }
+    ThreadUnwindContext* contextArray = static_cast<ThreadUnwindContext*>(thread.mmapStart);
+    return &contextArray[tail % thread.depth];
+}
 
-    ThreadUnwindContext* ret = &contextArray[index];
-    readIndex_ = (index + 1) % SAMPLER_MAX_BUFFER_SZ;
-    return ret;
+void ThreadSampler::ReleaseReadContext(SampledThread& thread)
+{
+    // hand the slot back to the signal handler once it has been unwound
+    thread.tail.store(thread.tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
 }
 
-ThreadUnwindContext* ThreadSampler::GetWriteContext()
+ThreadUnwindContext* ThreadSampler::GetWriteContext(SampledThread& thread)
 {
-    if (mmapStart_ == MAP_FAILED) {
+    if (thread.mmapStart == MAP_FAILED) {
         return nullptr;
     }
-    ThreadUnwindContext* contextArray = static_cast<ThreadUnwindContext*>(mmapStart_);
-    int32_t index = writeIndex_;
-    if (contextArray[index].requestTime > 0 &&
-        (contextArray[index].snapshotTime == 0 || contextArray[index].processTime == 0)) {
+    uint64_t head = thread.head.load(std::memory_order_relaxed);
+    if (head - thread.tail.load(std::memory_order_acquire) >= thread.depth) {
         return nullptr;
     }
-    return &contextArray[index];
+    ThreadUnwindContext* contextArray = static_cast<ThreadUnwindContext*>(thread.mmapStart);
+    return &contextArray[head % thread.depth];
 }
 
-NO_SANITIZER void ThreadSampler::WriteContext(void* context)
+void ThreadSampler::WriteContext(void* context)
+{
+    if (!init_) {
+        return;
+    }
+    SampledThread* thread = FindThread(static_cast<int32_t>(syscall(SYS_gettid)));
+    if (thread == nullptr) {
+        return;
+    }
+    WriteContext(*thread, context);
+}
+
+NO_SANITIZER void ThreadSampler::WriteContext(SampledThread& thread, void* context)
 {
 #if defined(__aarch64__) || defined(__loongarch_lp64)
-    if (!init_ || mmapStart_ == MAP_FAILED) {
+    if (!init_) {
         return;
     }
-    ThreadUnwindContext* contextArray = static_cast<ThreadUnwindContext*>(mmapStart_);
-    int32_t index = writeIndex_;
-#if defined(CONSUME_STATISTICS)
     uint64_t begin = GetCurrentTimeNanoseconds();
-    signalTimeCost_ += begin - contextArray[index].requestTime;
-#endif
-    if (contextArray[index].snapshotTime > 0 && contextArray[index].processTime == 0) {
+    ThreadUnwindContext* writeContext = GetWriteContext(thread);
+    if (writeContext == nullptr) {
+        thread.droppedCount.fetch_add(1, std::memory_order_relaxed);
         return;
     }
+#if defined(CONSUME_STATISTICS)
+    signalTimeCost_ += begin - thread.requestTime;
+#endif
 #if defined(__aarch64__)
-    contextArray[index].fp = static_cast<ucontext_t*>(context)->uc_mcontext.regs[RegsEnumArm64::REG_FP];
-    contextArray[index].lr = static_cast<ucontext_t*>(context)->uc_mcontext.regs[RegsEnumArm64::REG_LR];
-    contextArray[index].sp = static_cast<ucontext_t*>(context)->uc_mcontext.sp;
-    contextArray[index].pc = static_cast<ucontext_t*>(context)->uc_mcontext.pc;
+    writeContext->fp = static_cast<ucontext_t*>(context)->uc_mcontext.regs[RegsEnumArm64::REG_FP];
+    writeContext->lr = static_cast<ucontext_t*>(context)->uc_mcontext.regs[RegsEnumArm64::REG_LR];
+    writeContext->sp = static_cast<ucontext_t*>(context)->uc_mcontext.sp;
+    writeContext->pc = static_cast<ucontext_t*>(context)->uc_mcontext.pc;
 #elif defined(__loongarch_lp64)
-    contextArray[index].fp = static_cast<ucontext_t*>(context)->uc_mcontext.__gregs[RegsEnumLoongArch64::REG_FP];
-    contextArray[index].lr =
+    writeContext->fp = static_cast<ucontext_t*>(context)->uc_mcontext.__gregs[RegsEnumLoongArch64::REG_FP];
+    writeContext->lr =
         static_cast<ucontext_t*>(context)->uc_mcontext.__gregs[RegsEnumLoongArch64::REG_LOONGARCH64_R1];
-    contextArray[index].sp = static_cast<ucontext_t*>(context)->uc_mcontext.__gregs[RegsEnumLoongArch64::REG_SP];
-    contextArray[index].pc = static_cast<ucontext_t*>(context)->uc_mcontext.__pc;
+    writeContext->sp = static_cast<ucontext_t*>(context)->uc_mcontext.__gregs[RegsEnumLoongArch64::REG_SP];
+    writeContext->pc = static_cast<ucontext_t*>(context)->uc_mcontext.__pc;
 #endif
-    if (contextArray[index].sp < stackBegin_ || contextArray[index].sp >= stackEnd_) {
+    if (writeContext->sp < thread.stackBegin.load(std::memory_order_relaxed) || writeContext->sp >= thread.stackEnd) {
+        // the maps cannot be read here, the unwinder looks the sp up before the next sample
+        thread.straySp.store(writeContext->sp, std::memory_order_relaxed);
+        thread.droppedCount.fetch_add(1, std::memory_order_relaxed);
         return;
     }
-    uintptr_t curStackSz = stackEnd_ - contextArray[index].sp;
-    uintptr_t cpySz = curStackSz > STACK_BUFFER_SIZE ? STACK_BUFFER_SIZE : curStackSz;
-    for (uintptr_t pos = 0; pos < cpySz; pos++) {
-        reinterpret_cast<char*>(contextArray[index].buffer)[pos] =
-            reinterpret_cast<const char*>(contextArray[index].sp)[pos];
-    }
-    if (recordSubmitterStack_ && submitterStackIdIndex_ < submitterStackIdsMaxSize_) {
-        submitterStackIds_[submitterStackIdIndex_] = DfxGetSubmitterStackId();
-        submitterStackIdIndex_++;
+    uintptr_t curStackSz = thread.stackEnd - writeContext->sp;
+    uint32_t stackSz = static_cast<uint32_t>(curStackSz > STACK_BUFFER_SIZE ? STACK_BUFFER_SIZE : curStackSz);
+    uint32_t cpySz = std::min(stackSz, thread.copyLimit.load(std::memory_order_relaxed));
+    cpySz -= cpySz % STACK_COPY_ALIGN;
+    CopyStack(writeContext->buffer, writeContext->sp, cpySz);
+    writeContext->stackSize = stackSz;
+    writeContext->copySize = cpySz;
+    if (recordSubmitterStack_ && thread.submitterStackIdIndex < submitterStackIdsMaxSize_) {
+        thread.submitterStackIds[thread.submitterStackIdIndex] = DfxGetSubmitterStackId();
+        thread.submitterStackIdIndex++;
     }
-    writeIndex_ = (index + 1) % SAMPLER_MAX_BUFFER_SZ;
     uint64_t end = GetCurrentTimeNanoseconds();
-    contextArray[index].processTime.store(0, std::memory_order_relaxed);
-    contextArray[index].snapshotTime.store(end, std::memory_order_release);
+    writeContext->residencyTime = end - begin;
+    writeContext->requestTime.store(thread.requestTime.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    writeContext->processTime.store(0, std::memory_order_relaxed);
+    writeContext->snapshotTime.store(end, std::memory_order_relaxed);
+    thread.head.store(thread.head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
 #if defined(CONSUME_STATISTICS)
     copyStackCount_++;
     copyStackTimeCost_ += end - begin;
@@ -327,22 +625,22 @@ NO_SANITIZER void ThreadSampler::WriteContext(void* context)
 #endif  // #if defined(__aarch64__) || defined(__loongarch_lp64)
 }
 
-void ThreadSampler::SendSampleRequest()
+void ThreadSampler::SendSampleRequest(SampledThread& thread)
 {
-    ThreadUnwindContext* ptr = GetWriteContext();
-    if (ptr == nullptr) {
+    // the handler would find no free slot either, do not interrupt the thread for nothing
+    if (GetWriteContext(thread) == nullptr) {
+        thread.droppedCount.fetch_add(1, std::memory_order_relaxed);
         return;
     }
 
-    uint64_t ts = GetCurrentTimeNanoseconds();
-
-    ptr->requestTime = ts;
+    thread.requestTime = GetCurrentTimeNanoseconds();
     siginfo_t si {0};
     si.si_signo = MUSL_SIGNAL_SAMPLE_STACK;
     si.si_errno = 0;
     si.si_code = -1;
-    if (syscall(SYS_rt_tgsigqueueinfo, pid_, pid_, si.si_signo, &si) != 0) {
-        XCOLLIE_LOGE("Failed to queue signal(%{public}d) to %{public}d, errno(%{public}d).\n", si.si_signo, pid_,
+    int32_t tid = thread.tid;
+    if (syscall(SYS_rt_tgsigqueueinfo, pid_, tid, si.si_signo, &si) != 0) {
+        XCOLLIE_LOGE("Failed to queue signal(%{public}d) to %{public}d, errno(%{public}d).\n", si.si_signo, tid,
                      errno);
         return;
     }
@@ -353,13 +651,27 @@ void ThreadSampler::SendSampleRequest()
 
 void ThreadSampler::ProcessStackBuffer()
 {
-#if defined(__aarch64__) || defined(__loongarch_lp64)
     if (!init_) {
         XCOLLIE_LOGE("sampler has not initialized.\n");
         return;
     }
+    for (auto& thread : threads_) {
+        if (thread.tid.load(std::memory_order_acquire) != 0) {
+            ProcessStackBuffer(thread);
+        }
+    }
+}
+
+void ThreadSampler::ProcessStackBuffer(SampledThread& thread)
+{
+#if defined(__aarch64__) || defined(__loongarch_lp64)
+    uintptr_t straySp = thread.straySp.exchange(0, std::memory_order_relaxed);
+    if (straySp != 0) {
+        UpdateStackRange(thread, straySp);
+    }
+    int32_t tid = thread.tid;
     while (true) {
-        ThreadUnwindContext* context = GetReadContext();
+        ThreadUnwindContext* context = GetReadContext(thread);
         if (context == nullptr) {
             break;
         }
@@ -375,16 +687,35 @@ void ThreadSampler::ProcessStackBuffer()
 #if defined(CONSUME_STATISTICS)
         uint64_t unwindStart = GetCurrentTimeNanoseconds();
 #endif
-        DoUnwind(unwinder_, unwindInfo);
+        context->usedSize = 0;
+        context->truncated = false;
+        std::vector<uintptr_t> pcs;
+        if (fpUnwind_ && DoFpUnwind(*context, maps_, pcs)) {
+            fpUnwindCount_++;
+        } else {
+            fpFallbackCount_ += fpUnwind_ ? 1 : 0;
+            context->usedSize = 0;
+            context->truncated = false;
+            DoUnwind(unwinder_, unwindInfo);
+            pcs = unwinder_->GetPcs();
+        }
+        UpdateCopyLimit(thread, *context);
 #if defined(CONSUME_STATISTICS)
         uint64_t unwindEnd = GetCurrentTimeNanoseconds();
 #endif
-        auto pcs = unwinder_->GetPcs();
-        /* for print full stack */
-        p.pcVec = pcs;
-        timeStampedPcsList_.emplace_back(p);
-        /* for print tree format stack */
-        stackPrinter_->PutPcsInTable(pcs, pid_, unwindInfo.context->snapshotTime);
+        if (flightRecorder_ && tid == pid_) {
+            PutFlightSample(pcs, p.snapshotTime, context->residencyTime);
+        }
+        if (session_) {
+            /* for print full stack */
+            p.pcVec = pcs;
+            thread.timeStampedPcsList.emplace_back(p);
+            thread.residencyTimes.emplace_back(context->residencyTime);
+            thread.residencyTotal += context->residencyTime;
+            thread.residencyMax = std::max(thread.residencyMax, context->residencyTime);
+            /* for print tree format stack */
+            stackPrinter_->PutPcsInTable(pcs, tid, unwindInfo.context->snapshotTime);
+        }
 
         uint64_t ts = GetCurrentTimeNanoseconds();
 
@@ -394,23 +725,53 @@ void ThreadSampler::ProcessStackBuffer()
         unwindCount_++;
         unwindTimeCost_ += unwindEnd - unwindStart;
 #endif  //#if defined(CONSUME_STATISTICS)
-        context->requestTime.store(0, std::memory_order_release);
-        context->snapshotTime.store(0, std::memory_order_release);
-        context->processTime.store(ts, std::memory_order_release);
+        context->requestTime.store(0, std::memory_order_relaxed);
+        context->snapshotTime.store(0, std::memory_order_relaxed);
+        context->processTime.store(ts, std::memory_order_relaxed);
+        ReleaseReadContext(thread);
     }
 #endif  // #if defined(__aarch64__) || defined(__loongarch_lp64)
 }
 
+void ThreadSampler::UpdateCopyLimit(SampledThread& thread, const ThreadUnwindContext& context)
+{
+    if (!adaptiveCopy_) {
+        return;
+    }
+    if (context.truncated) {
+        // copy everything again until the window forgets this sample
+        std::fill(std::begin(thread.usedSizes), std::end(thread.usedSizes), STACK_BUFFER_SIZE);
+        thread.copyLimit.store(STACK_BUFFER_SIZE, std::memory_order_relaxed);
+        return;
+    }
+    thread.usedSizes[thread.usedSizeIndex] = context.usedSize;
+    thread.usedSizeIndex = (thread.usedSizeIndex + 1) % ADAPTIVE_COPY_WINDOW;
+    uint32_t deepest = *std::max_element(std::begin(thread.usedSizes), std::end(thread.usedSizes));
+    uint32_t limit = deepest + ADAPTIVE_COPY_HEADROOM + STACK_COPY_ALIGN - 1;
+    limit -= limit % STACK_COPY_ALIGN;
+    thread.copyLimit.store(std::min(limit, static_cast<uint32_t>(STACK_BUFFER_SIZE)), std::memory_order_relaxed);
+}
+
 int32_t ThreadSampler::Sample()
+{
+    return Sample(pid_);
+}
+
+int32_t ThreadSampler::Sample(int32_t tid)
 {
     if (!init_) {
         XCOLLIE_LOGE("sampler has not initialized.\n");
         return -1;
     }
+    SampledThread* thread = FindThread(tid);
+    if (thread == nullptr) {
+        XCOLLIE_LOGE("thread %{public}d has not been added.\n", tid);
+        return -1;
+    }
 #if defined(CONSUME_STATISTICS)
     sampleCount_++;
 #endif
-    SendSampleRequest();
+    SendSampleRequest(*thread);
     ProcessStackBuffer();
     processFinishTime_ = GetCurrentTimeNanoseconds();
     return 0;
@@ -432,6 +793,25 @@ void ThreadSampler::ResetConsumeInfo()
 }
 
 bool ThreadSampler::CollectStack(std::string& stack, bool treeFormat)
+{
+    return CollectStack(pid_, stack, treeFormat);
+}
+
+bool ThreadSampler::StreamStack(const StackWriter& writer, bool treeFormat)
+{
+    return StreamStack(pid_, writer, treeFormat);
+}
+
+bool ThreadSampler::CollectStack(int32_t tid, std::string& stack, bool treeFormat)
+{
+    stack.clear();
+    return StreamStack(tid, [&stack](const std::string& piece) {
+        stack += piece;
+        return true;
+    }, treeFormat);
+}
+
+bool ThreadSampler::StreamStack(int32_t tid, const StackWriter& writer, bool treeFormat)
 {
     ProcessStackBuffer();
 
@@ -439,15 +819,29 @@ bool ThreadSampler::CollectStack(std::string& stack, bool treeFormat)
         XCOLLIE_LOGE("sampler has not initialized.\n");
     }
 
-    stack.clear();
     heaviestStack_.clear();
-    if (timeStampedPcsList_.empty()) {
-        stack += "/proc/self/wchan: \n";
+    SampledThread* thread = FindThread(tid);
+    if (thread != nullptr && thread->droppedCount > 0) {
+        XCOLLIE_LOGW("%{public}llu samples of %{public}d dropped, ring depth:%{public}u\n",
+            static_cast<unsigned long long>(thread->droppedCount.load()), tid, thread->depth);
+    }
+    if (fpUnwind_) {
+        XCOLLIE_LOGI("fp unwind:%{public}llu, dwarf fallback:%{public}llu\n",
+            static_cast<unsigned long long>(fpUnwindCount_), static_cast<unsigned long long>(fpFallbackCount_));
+    }
+    if (thread != nullptr && !thread->residencyTimes.empty()) {
+        XCOLLIE_LOGI("signal handler time of %{public}d, avg:%{public}llu ns, max:%{public}llu ns\n", tid,
+            static_cast<unsigned long long>(thread->residencyTotal / thread->residencyTimes.size()),
+            static_cast<unsigned long long>(thread->residencyMax));
+    }
+    if (thread == nullptr || thread->timeStampedPcsList.empty()) {
+        std::string wchanPath =
+            (tid == pid_) ? "/proc/self/wchan" : "/proc/self/task/" + std::to_string(tid) + "/wchan";
         std::string fileStr = "";
-        if (!LoadStringFromFile("/proc/self/wchan", fileStr)) {
+        if (!LoadStringFromFile(wchanPath, fileStr)) {
             XCOLLIE_LOGE("read file failed.\n");
         }
-        stack += (fileStr + "\n");
+        writer(wchanPath + ": \n" + fileStr + "\n");
         return false;
     }
 
@@ -455,18 +849,29 @@ bool ThreadSampler::CollectStack(std::string& stack, bool treeFormat)
     uint64_t collectStart = GetCurrentTimeNanoseconds();
 #endif
     if (!treeFormat) {
-        for (size_t i = 0; i < timeStampedPcsList_.size(); i++) {
-            stack += GetStackByPcs(timeStampedPcsList_[i].pcVec, unwinder_, maps_, timeStampedPcsList_[i].snapshotTime);
-            if (recordSubmitterStack_ && i < submitterStackIdsMaxSize_ && submitterStackIds_[i] != 0) {
-                stack += "========SubmitterStacktrace========\n";
-                std::vector<uintptr_t> submitterPcs = GetAsyncStackPcsByStackId(submitterStackIds_[i]);
-                stack += GetStackByPcs(submitterPcs, unwinder_, maps_, 0);
+        // one piece per sample, the whole text is never held here
+        const auto& pcsList = thread->timeStampedPcsList;
+        for (size_t i = 0; i < pcsList.size(); i++) {
+            std::string piece =
+                GetStackByPcs(pcsList[i].pcVec, unwinder_, maps_, pcsList[i].snapshotTime, GetFrameCache());
+            if (i < thread->residencyTimes.size()) {
+                piece += "SignalHandlerTime:" + std::to_string(thread->residencyTimes[i]) + "ns\n";
+            }
+            if (recordSubmitterStack_ && i < submitterStackIdsMaxSize_ && thread->submitterStackIds[i] != 0) {
+                piece += "========SubmitterStacktrace========\n";
+                std::vector<uintptr_t> submitterPcs = GetAsyncStackPcsByStackId(thread->submitterStackIds[i]);
+                piece += GetStackByPcs(submitterPcs, unwinder_, maps_, 0, GetFrameCache());
+            }
+            piece += "\n";
+            if (!writer(piece)) {
+                return false;
             }
-            stack += "\n";
         }
     } else {
-        stack = stackPrinter_->GetTreeStack(pid_);
-        heaviestStack_ = stackPrinter_->GetHeaviestStack(pid_);
+        if (!writer(stackPrinter_->GetTreeStack(tid))) {
+            return false;
+        }
+        heaviestStack_ = stackPrinter_->GetHeaviestStack(tid);
     }
 
 #if defined(CONSUME_STATISTICS)
@@ -484,27 +889,405 @@ bool ThreadSampler::CollectStack(std::string& stack, bool treeFormat)
     return true;
 }
 
-std::string ThreadSampler::GetHeaviestStack() const
+bool ThreadSampler::CollectRecord(std::string& record)
+{
+    return CollectRecord(pid_, record);
+}
+
+bool ThreadSampler::CollectProfile(int format, std::string& data)
+{
+    return CollectProfile(pid_, format, data);
+}
+
+bool ThreadSampler::CollectRecord(int32_t tid, std::string& record)
+{
+    record.clear();
+    SampleRecord sampleRecord;
+    if (!BuildRecord(tid, sampleRecord)) {
+        return false;
+    }
+    EncodeSampleRecord(sampleRecord, record);
+    return true;
+}
+
+bool ThreadSampler::CollectProfile(int32_t tid, int format, std::string& data)
+{
+    data.clear();
+    SampleRecord sampleRecord;
+    if (!BuildRecord(tid, sampleRecord)) {
+        return false;
+    }
+    SampleFunctionNames names;
+    FrameCache* frameCache = GetFrameCache();
+    auto addNames = [this, &names, frameCache](const std::vector<uint64_t>& pcs) {
+        for (auto pc : pcs) {
+            if (names.find(pc) == names.end()) {
+                names[pc] = GetFrameByPc(static_cast<uintptr_t>(pc), unwinder_, maps_, frameCache).funcName;
+            }
+        }
+    };
+    for (const auto& sample : sampleRecord.samples) {
+        addNames(sample.pcs);
+        addNames(sample.submitterPcs);
+    }
+    return EncodeSampleProfile(format, sampleRecord, names, data);
+}
+
+bool ThreadSampler::BuildRecord(int32_t tid, SampleRecord& sampleRecord)
+{
+    ProcessStackBuffer();
+
+    SampledThread* thread = FindThread(tid);
+    if (!init_ || thread == nullptr || maps_ == nullptr) {
+        XCOLLIE_LOGE("sampler of %{public}d has not initialized.\n", tid);
+        return false;
+    }
+    sampleRecord.pid = pid_;
+    sampleRecord.tid = tid;
+    std::set<uint64_t> added;
+    const auto& pcsList = thread->timeStampedPcsList;
+    sampleRecord.samples.resize(pcsList.size());
+    for (size_t i = 0; i < pcsList.size(); i++) {
+        auto& sample = sampleRecord.samples[i];
+        sample.snapshotTime = pcsList[i].snapshotTime;
+        sample.pcs.assign(pcsList[i].pcVec.begin(), pcsList[i].pcVec.end());
+        AddRecordMappings(sample.pcs, sampleRecord, added);
+        if (recordSubmitterStack_ && i < submitterStackIdsMaxSize_ && thread->submitterStackIds[i] != 0) {
+            std::vector<uintptr_t> submitterPcs = GetAsyncStackPcsByStackId(thread->submitterStackIds[i]);
+            sample.submitterPcs.assign(submitterPcs.begin(), submitterPcs.end());
+            AddRecordMappings(sample.submitterPcs, sampleRecord, added);
+        }
+    }
+    return true;
+}
+
+void ThreadSampler::AddRecordMappings(const std::vector<uint64_t>& pcs, SampleRecord& record,
+    std::set<uint64_t>& added)
+{
+    for (auto pc : pcs) {
+        std::shared_ptr<DfxMap> map;
+        if (!maps_->FindMapByAddr(static_cast<uintptr_t>(pc), map) || map == nullptr ||
+            !added.insert(map->begin).second) {
+            continue;
+        }
+        SampleRecordMapping mapping;
+        mapping.begin = map->begin;
+        mapping.end = map->end;
+        mapping.offset = map->offset;
+        mapping.name = map->name;
+        // read from the loaded note, the symbolizer finds the unstripped file by it
+        std::string buildId = GetBuildIdByAddr(static_cast<uintptr_t>(map->begin));
+        if (!buildId.empty()) {
+            auto iter = std::find(record.buildIds.begin(), record.buildIds.end(), buildId);
+            mapping.buildIdIndex = static_cast<uint32_t>(iter - record.buildIds.begin()) + 1;
+            if (iter == record.buildIds.end()) {
+                record.buildIds.push_back(std::move(buildId));
+            }
+        }
+        record.mappings.push_back(std::move(mapping));
+    }
+}
+
+bool ThreadSampler::SetRingDepth(uint32_t depth)
+{
+    if (depth == 0 || depth > SAMPLER_MAX_RING_DEPTH) {
+        XCOLLIE_LOGE("Invalid ring depth %{public}u\n", depth);
+        return false;
+    }
+    ringDepth_ = depth;
+    return true;
+}
+
+void ThreadSampler::SetAdaptiveCopy(bool enable)
+{
+    adaptiveCopy_ = enable;
+    if (enable) {
+        return;
+    }
+    for (auto& thread : threads_) {
+        thread.copyLimit.store(STACK_BUFFER_SIZE, std::memory_order_relaxed);
+    }
+}
+
+void ThreadSampler::SetFpUnwind(bool enable)
+{
+    fpUnwind_ = enable;
+}
+
+uint64_t ThreadSampler::GetDroppedCount(int32_t tid)
+{
+    SampledThread* thread = FindThread((tid == 0) ? pid_ : tid);
+    return (thread != nullptr) ? thread->droppedCount.load(std::memory_order_relaxed) : 0;
+}
+
+FrameCache* ThreadSampler::GetFrameCache()
+{
+    if (!warmCache_) {
+        return nullptr;
+    }
+    if (frameCache_.size() >= MAX_FRAME_CACHE_SIZE) {
+        frameCache_.clear();
+    }
+    return &frameCache_;
+}
+
+const std::string& ThreadSampler::GetHeaviestStack() const
 {
     return heaviestStack_;
 }
 
 bool ThreadSampler::Deinit()
 {
+    DeinitSession();
+    if (flightRecorder_) {
+        // the unwinder and the main thread stay for the flight recorder
+        return true;
+    }
+    ReleaseSampler();
+    return !init_;
+}
+
+void ThreadSampler::DeinitSession()
+{
+    recordSubmitterStack_ = false;
+    session_ = false;
+    for (auto& thread : threads_) {
+        if (!flightRecorder_ || thread.tid.load(std::memory_order_acquire) != pid_) {
+            thread.tid.store(0, std::memory_order_release);
+            ReleaseRecordBuffer(thread);
+        }
+        thread.timeStampedPcsList.clear();
+        thread.residencyTimes.clear();
+        thread.residencyTotal = 0;
+        thread.residencyMax = 0;
+        thread.submitterStackIds.reset();
+        thread.submitterStackIdIndex = 0;
+    }
     stackPrinter_.reset();
-    DestroyUnwinder();
-    ReleaseRecordBuffer();
     processFinishTime_ = GetCurrentTimeNanoseconds();
-    recordSubmitterStack_ = false;
-    timeStampedPcsList_.clear();
-    submitterStackIds_.reset();
-    submitterStackIdIndex_ = 0;
     submitterStackIdsMaxSize_ = 0;
-    init_ = false;
+    fpUnwindCount_ = 0;
+    fpFallbackCount_ = 0;
 #if defined(CONSUME_STATISTICS)
     ResetConsumeInfo();
 #endif
-    return !init_;
+}
+
+void ThreadSampler::ReleaseSampler()
+{
+    for (auto& thread : threads_) {
+        thread.tid.store(0, std::memory_order_release);
+        ReleaseRecordBuffer(thread);
+    }
+    if (!warmCache_) {
+        DestroyUnwinder();
+    }
+    init_ = false;
+}
+
+bool ThreadSampler::StartFlightRecorder(uint32_t interval, uint32_t window, size_t memoryBudget, uint32_t cpuBudget)
+{
+    if (flightRecorder_) {
+        return true;
+    }
+    size_t slotNum = (interval == 0) ? 0 : std::min<size_t>(window / interval, memoryBudget / sizeof(FlightSample));
+    if (slotNum == 0 || cpuBudget == 0 || cpuBudget > PERMILLE) {
+        XCOLLIE_LOGE("Invalid flight recorder, interval:%{public}u, window:%{public}u, memory:%{public}zu, "
+            "cpu:%{public}u\n", interval, window, memoryBudget, cpuBudget);
+        return false;
+    }
+    bool firstInit = !init_;
+    if (firstInit && !InitSampler()) {
+        return false;
+    }
+    if (!AddThread(pid_)) {
+        XCOLLIE_LOGE("Failed to add the main thread to the flight recorder\n");
+        if (firstInit) {
+            Deinit();
+        }
+        return false;
+    }
+    SampledThread* thread = FindThread(pid_);
+    {
+        std::lock_guard<std::mutex> lock(flightMutex_);
+        flightSamples_.assign(slotNum, FlightSample {});
+        flightHead_ = 0;
+        flightStats_ = {};
+        flightStats_.startTime = GetCurrentTimeNanoseconds();
+        flightStats_.memorySize = slotNum * sizeof(FlightSample) + thread->bufferSize;
+    }
+    flightCpuBudget_ = cpuBudget;
+    flightCredit_ = 0;
+    flightLastTime_ = 0;
+    flightResidency_ = 0;
+    flightRecorder_ = true;
+    XCOLLIE_LOGI("Start flight recorder, slots:%{public}zu, memory:%{public}llu, cpu:%{public}u permille\n",
+        slotNum, static_cast<unsigned long long>(flightStats_.memorySize), cpuBudget);
+    return true;
+}
+
+bool ThreadSampler::StopFlightRecorder()
+{
+    if (!flightRecorder_) {
+        return true;
+    }
+    flightRecorder_ = false;
+    {
+        std::lock_guard<std::mutex> lock(flightMutex_);
+        std::vector<FlightSample>().swap(flightSamples_);
+        flightHead_ = 0;
+    }
+    {
+        std::lock_guard<std::mutex> lock(symbolizerMutex_);
+        symbolizerMaps_.reset();
+        symbolizerUnwinder_.reset();
+        symbolizerCache_.clear();
+    }
+    // a running session keeps the main thread until its Deinit
+    if (!session_ && init_) {
+        ReleaseSampler();
+    }
+    return true;
+}
+
+bool ThreadSampler::FlightRecorderSample()
+{
+    if (!flightRecorder_) {
+        return false;
+    }
+    // the samples of a running session go to the ring meanwhile
+    if (session_) {
+        return true;
+    }
+    // token bucket: cpuBudget permille of the time passed is earned, at most a second's worth is saved up
+    uint64_t now = GetCurrentTimeNanoseconds();
+    int64_t maxCredit = static_cast<int64_t>(NANOSEC_PER_SEC * flightCpuBudget_ / PERMILLE);
+    if (flightLastTime_ != 0 && now > flightLastTime_) {
+        flightCredit_ += static_cast<int64_t>((now - flightLastTime_) * flightCpuBudget_ / PERMILLE);
+        flightCredit_ = std::min(flightCredit_, maxCredit);
+    }
+    flightLastTime_ = now;
+    if (flightCredit_ < 0) {
+        std::lock_guard<std::mutex> lock(flightMutex_);
+        flightStats_.skippedCount++;
+        return false;
+    }
+    SampledThread* thread = FindThread(pid_);
+    if (thread == nullptr) {
+        return false;
+    }
+    uint64_t cpuStart = GetThreadCpuTimeNanoseconds();
+    RefreshMaps();
+    // unwind the sample requested last time, the main thread is never waited for
+    ProcessStackBuffer(*thread);
+    SendSampleRequest(*thread);
+    uint64_t cost = GetThreadCpuTimeNanoseconds() - cpuStart + flightResidency_;
+    flightResidency_ = 0;
+    flightCredit_ -= static_cast<int64_t>(cost);
+    std::lock_guard<std::mutex> lock(flightMutex_);
+    flightStats_.costTime += cost;
+    flightStats_.maxCostTime = std::max(flightStats_.maxCostTime, cost);
+    return true;
+}
+
+void ThreadSampler::PutFlightSample(const std::vector<uintptr_t>& pcs, uint64_t snapshotTime, uint64_t residencyTime)
+{
+    std::lock_guard<std::mutex> lock(flightMutex_);
+    if (flightSamples_.empty()) {
+        return;
+    }
+    FlightSample& sample = flightSamples_[flightHead_ % flightSamples_.size()];
+    sample.snapshotTime = snapshotTime;
+    sample.pcNum = static_cast<uint32_t>(std::min<size_t>(pcs.size(), FLIGHT_MAX_FRAME_NUM));
+    std::copy_n(pcs.begin(), sample.pcNum, sample.pcs);
+    flightHead_++;
+    flightStats_.sampleCount++;
+    // the handler time of a session sample is not the flight recorder's
+    if (!session_) {
+        flightResidency_ += residencyTime;
+    }
+}
+
+bool ThreadSampler::CollectFlightStack(uint32_t window, std::string& stack)
+{
+    std::string samples;
+    return CopyFlightSamples(window, samples) && SymbolizeFlightSamples(samples, stack);
+}
+
+bool ThreadSampler::CopyFlightSamples(uint32_t window, std::string& samples)
+{
+    samples.clear();
+    if (!flightRecorder_) {
+        return false;
+    }
+    uint64_t now = GetCurrentTimeNanoseconds();
+    uint64_t since = now - std::min<uint64_t>(now, window * NANOSEC_PER_MILLISEC);
+    std::lock_guard<std::mutex> lock(flightMutex_);
+    FlightSampleHeader header {now, flightStats_, 0};
+    samples.append(reinterpret_cast<const char*>(&header), sizeof(header));
+    size_t count = std::min<uint64_t>(flightHead_, flightSamples_.size());
+    for (uint64_t i = flightHead_ - count; i < flightHead_; i++) {
+        const auto& sample = flightSamples_[i % flightSamples_.size()];
+        if (sample.snapshotTime < since) {
+            continue;
+        }
+        // only the pcs in use, the symbolizer reads the samples back in the same layout
+        samples.append(reinterpret_cast<const char*>(&sample),
+            offsetof(FlightSample, pcs) + sample.pcNum * sizeof(uintptr_t));
+        header.sampleNum++;
+    }
+    std::copy_n(reinterpret_cast<const char*>(&header), sizeof(header), &samples[0]);
+    return true;
+}
+
+bool ThreadSampler::SymbolizeFlightSamples(const std::string& samples, std::string& stack)
+{
+    stack.clear();
+    FlightSampleHeader header;
+    if (!flightRecorder_ || samples.size() < sizeof(header)) {
+        return false;
+    }
+    std::copy_n(samples.data(), sizeof(header), reinterpret_cast<char*>(&header));
+    const FlightRecorderStats& stats = header.stats;
+    uint64_t elapsed = std::max<uint64_t>(header.copyTime - std::min(header.copyTime, stats.startTime), 1);
+    uint64_t cpuPermille = stats.costTime * PERMILLE * PERMILLE_DECIMAL / elapsed;
+    stack = "FlightRecorder samples:" + std::to_string(header.sampleNum) + "/" + std::to_string(stats.sampleCount) +
+        " skipped:" + std::to_string(stats.skippedCount) + " cpu:" + std::to_string(cpuPermille / PERMILLE_DECIMAL) +
+        "." + std::to_string(cpuPermille % PERMILLE_DECIMAL) + " permille memory:" +
+        std::to_string(stats.memorySize) + "\n";
+    std::lock_guard<std::mutex> lock(symbolizerMutex_);
+    // a recorder stopped meanwhile has already dropped the symbolizer
+    if (!flightRecorder_ || !InitSymbolizer()) {
+        return false;
+    }
+    size_t offset = sizeof(header);
+    for (uint32_t i = 0; i < header.sampleNum; i++) {
+        FlightSample sample;
+        if (samples.size() - offset < offsetof(FlightSample, pcs)) {
+            return false;
+        }
+        std::copy_n(samples.data() + offset, offsetof(FlightSample, pcs), reinterpret_cast<char*>(&sample));
+        size_t pcsSize = sample.pcNum * sizeof(uintptr_t);
+        offset += offsetof(FlightSample, pcs);
+        if (sample.pcNum > FLIGHT_MAX_FRAME_NUM || samples.size() - offset < pcsSize) {
+            return false;
+        }
+        std::copy_n(samples.data() + offset, pcsSize, reinterpret_cast<char*>(sample.pcs));
+        offset += pcsSize;
+        std::vector<uintptr_t> pcs(sample.pcs, sample.pcs + sample.pcNum);
+        if (symbolizerCache_.size() >= MAX_FRAME_CACHE_SIZE) {
+            symbolizerCache_.clear();
+        }
+        stack += GetStackByPcs(pcs, symbolizerUnwinder_, symbolizerMaps_, sample.snapshotTime, &symbolizerCache_);
+        stack += "\n";
+    }
+    return header.sampleNum > 0;
+}
+
+FlightRecorderStats ThreadSampler::GetFlightRecorderStats()
+{
+    std::lock_guard<std::mutex> lock(flightMutex_);
+    return flightStats_;
 }
 
 SamplerResult ThreadSampler::ThreadSamplerGetResult()
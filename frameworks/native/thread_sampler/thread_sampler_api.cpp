@@ -21,6 +21,8 @@ namespace HiviewDFX {
 namespace {
 constexpr int SUCCESS = 0;
 constexpr int FAIL = -1;
+constexpr int STACK_PART = 0;
+constexpr int HEAVIEST_STACK_PART = 1;
 }  // namespace
 int ThreadSamplerInit(size_t collectStackCount, int recordSubmitterStack)
 {
@@ -33,16 +35,60 @@ int32_t ThreadSamplerSample()
 }
 
 int ThreadSamplerCollect(char* stack, char* heaviestStack, size_t stackSize, size_t heaviestSize, int treeFormat)
+{
+    return ThreadSamplerCollectThread(0, stack, heaviestStack, stackSize, heaviestSize, treeFormat);
+}
+
+int ThreadSamplerCollectStream(int tid, int treeFormat, ThreadSamplerWriter writer, void* context)
+{
+    if (writer == nullptr) {
+        return FAIL;
+    }
+    bool enableTreeFormat = (treeFormat == 1);
+    auto streamWriter = [writer, context](const std::string& piece) {
+        return piece.empty() || writer(context, STACK_PART, piece.data(), piece.size()) == 0;
+    };
+    auto& sampler = ThreadSampler::GetInstance();
+    bool collected = (tid == 0) ? sampler.StreamStack(streamWriter, enableTreeFormat) :
+        sampler.StreamStack(tid, streamWriter, enableTreeFormat);
+    if (!collected) {
+        return FAIL;
+    }
+    const std::string& heaviest = sampler.GetHeaviestStack();
+    if (enableTreeFormat && !heaviest.empty() &&
+        writer(context, HEAVIEST_STACK_PART, heaviest.data(), heaviest.size()) != 0) {
+        return FAIL;
+    }
+    return SUCCESS;
+}
+
+int ThreadSamplerInitThread(int tid, size_t collectStackCount, int recordSubmitterStack)
+{
+    if (tid <= 0) {
+        return FAIL;
+    }
+    return ThreadSampler::GetInstance().Init(collectStackCount, recordSubmitterStack == 1, tid) ? SUCCESS : FAIL;
+}
+
+int32_t ThreadSamplerSampleThread(int tid)
+{
+    return ThreadSampler::GetInstance().Sample(tid);
+}
+
+int ThreadSamplerCollectThread(int tid, char* stack, char* heaviestStack, size_t stackSize, size_t heaviestSize,
+    int treeFormat)
 {
     bool enableTreeFormat = (treeFormat == 1);
     std::string stk;
-    int success = (ThreadSampler::GetInstance().CollectStack(stk, enableTreeFormat) ? SUCCESS : FAIL);
+    bool collected = (tid == 0) ? ThreadSampler::GetInstance().CollectStack(stk, enableTreeFormat) :
+        ThreadSampler::GetInstance().CollectStack(tid, stk, enableTreeFormat);
+    int success = (collected ? SUCCESS : FAIL);
     size_t len = (stk.size() >= stackSize ? stackSize - 1 : stk.size());
     if (strncpy_s(stack, stackSize, stk.c_str(), len) != EOK) {
         return FAIL;
     }
     if (enableTreeFormat) {
-        std::string heaviest = ThreadSampler::GetInstance().GetHeaviestStack();
+        const std::string& heaviest = ThreadSampler::GetInstance().GetHeaviestStack();
         size_t heaviestLen = (heaviest.size() >= heaviestSize ? heaviestSize - 1 : heaviest.size());
         if (strncpy_s(heaviestStack, heaviestSize, heaviest.c_str(), heaviestLen) != EOK) {
             return FAIL;
@@ -51,6 +97,102 @@ int ThreadSamplerCollect(char* stack, char* heaviestStack, size_t stackSize, siz
     return success;
 }
 
+int ThreadSamplerCollectRecord(int tid, ThreadSamplerWriter writer, void* context)
+{
+    if (writer == nullptr) {
+        return FAIL;
+    }
+    std::string data;
+    bool collected = (tid == 0) ? ThreadSampler::GetInstance().CollectRecord(data) :
+        ThreadSampler::GetInstance().CollectRecord(tid, data);
+    if (!collected) {
+        return FAIL;
+    }
+    return (writer(context, STACK_PART, data.data(), data.size()) == 0) ? SUCCESS : FAIL;
+}
+
+int ThreadSamplerCollectProfile(int tid, int format, ThreadSamplerWriter writer, void* context)
+{
+    if (writer == nullptr) {
+        return FAIL;
+    }
+    std::string profile;
+    bool collected = (tid == 0) ? ThreadSampler::GetInstance().CollectProfile(format, profile) :
+        ThreadSampler::GetInstance().CollectProfile(tid, format, profile);
+    if (!collected) {
+        return FAIL;
+    }
+    return (writer(context, STACK_PART, profile.data(), profile.size()) == 0) ? SUCCESS : FAIL;
+}
+
+int ThreadSamplerSetRingDepth(uint32_t depth)
+{
+    return ThreadSampler::GetInstance().SetRingDepth(depth) ? SUCCESS : FAIL;
+}
+
+uint64_t ThreadSamplerGetDroppedCount(int tid)
+{
+    return ThreadSampler::GetInstance().GetDroppedCount(tid);
+}
+
+void ThreadSamplerSetAdaptiveCopy(int enable)
+{
+    ThreadSampler::GetInstance().SetAdaptiveCopy(enable == 1);
+}
+
+void ThreadSamplerSetFpUnwind(int enable)
+{
+    ThreadSampler::GetInstance().SetFpUnwind(enable == 1);
+}
+
+void ThreadSamplerSetWarmCache(int enable)
+{
+    ThreadSampler::GetInstance().SetWarmCache(enable == 1);
+}
+
+int ThreadSamplerStartFlightRecorder(uint32_t interval, uint32_t window, size_t memoryBudget, uint32_t cpuBudget)
+{
+    return ThreadSampler::GetInstance().StartFlightRecorder(interval, window, memoryBudget, cpuBudget) ?
+        SUCCESS : FAIL;
+}
+
+int ThreadSamplerStopFlightRecorder()
+{
+    return ThreadSampler::GetInstance().StopFlightRecorder() ? SUCCESS : FAIL;
+}
+
+int ThreadSamplerFlightSample()
+{
+    return ThreadSampler::GetInstance().FlightRecorderSample() ? SUCCESS : FAIL;
+}
+
+int ThreadSamplerCopyFlightSamples(uint32_t window, ThreadSamplerWriter writer, void* context)
+{
+    std::string data;
+    if (writer == nullptr || !ThreadSampler::GetInstance().CopyFlightSamples(window, data)) {
+        return FAIL;
+    }
+    return (writer(context, STACK_PART, data.data(), data.size()) == 0) ? SUCCESS : FAIL;
+}
+
+int ThreadSamplerSymbolizeFlightSamples(const char* samples, size_t samplesSize, ThreadSamplerWriter writer,
+    void* context)
+{
+    if (samples == nullptr || writer == nullptr) {
+        return FAIL;
+    }
+    std::string stk;
+    if (!ThreadSampler::GetInstance().SymbolizeFlightSamples(std::string(samples, samplesSize), stk)) {
+        return FAIL;
+    }
+    return (writer(context, STACK_PART, stk.data(), stk.size()) == 0) ? SUCCESS : FAIL;
+}
+
+FlightRecorderStats ThreadSamplerGetFlightRecorderStats()
+{
+    return ThreadSampler::GetInstance().GetFlightRecorderStats();
+}
+
 int ThreadSamplerDeinit()
 {
     return ThreadSampler::GetInstance().Deinit() ? SUCCESS : FAIL;
@@ -14,10 +14,16 @@
  */
 #include "thread_sampler_utils.h"
 
+#include <algorithm>
+#include <cstddef>
 #include <cstdio>
+#include <cstring>
 #include <ctime>
 #include <sstream>
 
+#include <link.h>
+#include <sys/mman.h>
+
 #include "dfx_frame_formatter.h"
 #include "unique_stack_table.h"
 
@@ -27,6 +33,26 @@ constexpr uint64_t NANOSEC_PER_SEC = 1000 * 1000 * 1000;
 constexpr uint64_t NANOSEC_PER_MICROSEC = 1000;
 constexpr int FORMAT_TIME_LEN = 20;
 constexpr int MICROSEC_LEN = 6;
+constexpr size_t FP_UNWIND_MAX_FRAME_NUM = 256;
+constexpr size_t FRAME_RECORD_SIZE = 2 * sizeof(uintptr_t);
+constexpr size_t NOTE_ALIGN = 4;
+constexpr char GNU_NOTE_NAME[] = "GNU";
+
+#if defined(__aarch64__)
+uintptr_t StripPac(uintptr_t addr)
+{
+    // xpaclri, a nop on cores without pointer authentication
+    register uintptr_t x30 __asm__("x30") = addr;
+    __asm__("hint 0x7" : "+r"(x30));
+    return x30;
+}
+
+bool IsExecAddr(const std::shared_ptr<DfxMaps>& maps, uintptr_t addr)
+{
+    std::shared_ptr<DfxMap> map;
+    return maps->FindMapByAddr(addr, map) && map != nullptr && (map->prots & PROT_EXEC) != 0;
+}
+#endif
 
 uint64_t GetCurrentTimeNanoseconds()
 {
@@ -37,6 +63,15 @@ uint64_t GetCurrentTimeNanoseconds()
     return static_cast<uint64_t>(t.tv_sec) * NANOSEC_PER_SEC + static_cast<uint64_t>(t.tv_nsec);
 }
 
+uint64_t GetThreadCpuTimeNanoseconds()
+{
+    struct timespec t;
+    t.tv_sec = 0;
+    t.tv_nsec = 0;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &t);
+    return static_cast<uint64_t>(t.tv_sec) * NANOSEC_PER_SEC + static_cast<uint64_t>(t.tv_nsec);
+}
+
 std::string TimeFormat(uint64_t time)
 {
     uint64_t nsec = time % NANOSEC_PER_SEC;
@@ -77,6 +112,50 @@ void DoUnwind(const std::shared_ptr<Unwinder>& unwinder, UnwindInfo& unwindInfo)
 #endif  // #if defined(__loongarch_lp64)
 }
 
+bool DoFpUnwind(ThreadUnwindContext& context, const std::shared_ptr<DfxMaps>& maps, std::vector<uintptr_t>& pcs)
+{
+    pcs.clear();
+#if defined(__aarch64__)
+    if (maps == nullptr) {
+        return false;
+    }
+    pcs.emplace_back(context.pc);
+    uintptr_t stackTop = context.sp + context.stackSize;
+    uintptr_t copyTop = context.sp + context.copySize;
+    uintptr_t fp = context.fp;
+    while (fp != 0 && pcs.size() < FP_UNWIND_MAX_FRAME_NUM) {
+        if (fp < context.sp || fp + FRAME_RECORD_SIZE > stackTop || fp % sizeof(uintptr_t) != 0) {
+            return false;
+        }
+        if (fp + FRAME_RECORD_SIZE > copyTop) {
+            // the DWARF unwinder cannot read the uncopied stack either
+            context.truncated = (context.copySize < context.stackSize);
+            break;
+        }
+        size_t offset = fp - context.sp;
+        const uintptr_t* record = reinterpret_cast<const uintptr_t*>(&context.buffer[offset]);
+        uintptr_t nextFp = record[0];
+        uintptr_t returnAddr = StripPac(record[1]);
+        context.usedSize = std::max(context.usedSize, static_cast<uint32_t>(offset + FRAME_RECORD_SIZE));
+        if (returnAddr == 0) {
+            break;
+        }
+        if (!IsExecAddr(maps, returnAddr)) {
+            return false;
+        }
+        pcs.emplace_back(returnAddr);
+        // frame records of older frames are always higher on the stack
+        if (nextFp != 0 && nextFp <= fp) {
+            return false;
+        }
+        fp = nextFp;
+    }
+    return pcs.size() > 1;
+#else
+    return false;
+#endif
+}
+
 std::vector<uintptr_t> GetAsyncStackPcsByStackId(uint64_t stackId)
 {
     std::vector<uintptr_t> pcVec;
@@ -86,8 +165,103 @@ std::vector<uintptr_t> GetAsyncStackPcsByStackId(uint64_t stackId)
     return pcVec;
 }
 
+bool GetLoadCounts(uint64_t& adds, uint64_t& subs)
+{
+    struct LoadCounts {
+        bool valid = false;
+        uint64_t adds = 0;
+        uint64_t subs = 0;
+    } counts;
+    dl_iterate_phdr([](struct dl_phdr_info* info, size_t size, void* data) -> int {
+        auto counts = static_cast<LoadCounts*>(data);
+        // older loaders pass a shorter info without the counters
+        if (size >= offsetof(struct dl_phdr_info, dlpi_subs) + sizeof(info->dlpi_subs)) {
+            counts->valid = true;
+            counts->adds = info->dlpi_adds;
+            counts->subs = info->dlpi_subs;
+        }
+        return 1;
+    }, &counts);
+    adds = counts.adds;
+    subs = counts.subs;
+    return counts.valid;
+}
+
+size_t AlignNote(size_t size)
+{
+    return (size + NOTE_ALIGN - 1) & ~(NOTE_ALIGN - 1);
+}
+
+bool ReadBuildIdNote(uintptr_t notes, size_t size, std::string& buildId)
+{
+    size_t pos = 0;
+    while (pos + sizeof(ElfW(Nhdr)) <= size) {
+        auto nhdr = reinterpret_cast<const ElfW(Nhdr)*>(notes + pos);
+        size_t nameOffset = pos + sizeof(ElfW(Nhdr));
+        size_t descOffset = nameOffset + AlignNote(nhdr->n_namesz);
+        pos = descOffset + AlignNote(nhdr->n_descsz);
+        if (pos > size) {
+            return false;
+        }
+        if (nhdr->n_type == NT_GNU_BUILD_ID && nhdr->n_namesz == sizeof(GNU_NOTE_NAME) &&
+            memcmp(reinterpret_cast<const void*>(notes + nameOffset), GNU_NOTE_NAME, sizeof(GNU_NOTE_NAME)) == 0) {
+            buildId.assign(reinterpret_cast<const char*>(notes + descOffset), nhdr->n_descsz);
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string GetBuildIdByAddr(uintptr_t addr)
+{
+    struct BuildIdQuery {
+        uintptr_t addr = 0;
+        std::string buildId;
+    } query;
+    query.addr = addr;
+    dl_iterate_phdr([](struct dl_phdr_info* info, size_t, void* data) -> int {
+        auto query = static_cast<BuildIdQuery*>(data);
+        bool covered = false;
+        for (ElfW(Half) i = 0; i < info->dlpi_phnum && !covered; i++) {
+            const auto& phdr = info->dlpi_phdr[i];
+            uintptr_t begin = info->dlpi_addr + phdr.p_vaddr;
+            covered = (phdr.p_type == PT_LOAD && query->addr >= begin && query->addr < begin + phdr.p_memsz);
+        }
+        if (!covered) {
+            return 0;
+        }
+        for (ElfW(Half) i = 0; i < info->dlpi_phnum; i++) {
+            const auto& phdr = info->dlpi_phdr[i];
+            if (phdr.p_type == PT_NOTE &&
+                ReadBuildIdNote(info->dlpi_addr + phdr.p_vaddr, phdr.p_memsz, query->buildId)) {
+                break;
+            }
+        }
+        return 1;
+    }, &query);
+    return query.buildId;
+}
+
+DfxFrame GetFrameByPc(uintptr_t pc, const std::shared_ptr<Unwinder>& unwinder, const std::shared_ptr<DfxMaps>& maps,
+                      FrameCache* frameCache)
+{
+    DfxFrame frame;
+    if (unwinder == nullptr || maps == nullptr) {
+        return frame;
+    }
+    if (frameCache == nullptr) {
+        unwinder->GetFrameByPc(pc, maps, frame);
+    } else if (auto iter = frameCache->find(pc); iter != frameCache->end()) {
+        frame = iter->second;
+    } else {
+        unwinder->GetFrameByPc(pc, maps, frame);
+        frameCache->emplace(pc, frame);
+    }
+    return frame;
+}
+
 std::string GetStackByPcs(const std::vector<uintptr_t>& pcVec, const std::shared_ptr<Unwinder>& unwinder,
-                          const std::shared_ptr<DfxMaps>& maps, uint64_t snapshotTime)
+                          const std::shared_ptr<DfxMaps>& maps, uint64_t snapshotTime, FrameCache* frameCache)
 {
     std::string stack;
     if (unwinder == nullptr || maps == nullptr) {
@@ -97,8 +271,7 @@ std::string GetStackByPcs(const std::vector<uintptr_t>& pcVec, const std::shared
         stack += "SnapshotTime:" + TimeFormat(snapshotTime) + "\n";
     }
     for (size_t i = 0; i < pcVec.size(); i++) {
-        DfxFrame frame;
-        unwinder->GetFrameByPc(pcVec[i], maps, frame);
+        DfxFrame frame = GetFrameByPc(pcVec[i], unwinder, maps, frameCache);
         frame.index = i;
         auto frameStr = DfxFrameFormatter::GetFrameStr(frame);
         stack += frameStr;
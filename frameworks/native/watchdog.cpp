@@ -46,6 +46,23 @@ int Watchdog::AddThread(const std::string &name, std::shared_ptr<AppExecFwk::Eve
     return WatchdogInner::GetInstance().AddThread(name, handler, timeOutCallback, interval, priority);
 }
 
+int Watchdog::AddHeartbeatThread(const std::string &name, std::shared_ptr<AppExecFwk::EventHandler> handler,
+    std::shared_ptr<HeartbeatSlot> heartbeat, TimeOutCallback timeOutCallback, uint64_t interval)
+{
+    return WatchdogInner::GetInstance().AddHeartbeatThread(name, handler, heartbeat, timeOutCallback, interval);
+}
+
+int Watchdog::AddAdaptiveThread(const std::string &name, std::shared_ptr<AppExecFwk::EventHandler> handler,
+    TimeOutCallback timeOutCallback, uint64_t interval)
+{
+    return WatchdogInner::GetInstance().AddAdaptiveThread(name, handler, timeOutCallback, interval);
+}
+
+bool Watchdog::SetProbeLadder(const std::string& name, bool isEnable)
+{
+    return WatchdogInner::GetInstance().SetProbeLadder(name, isEnable);
+}
+
 void Watchdog::RunOneShotTask(const std::string& name, Task&& task, uint64_t delay)
 {
     return WatchdogInner::GetInstance().RunOneShotTask(name, std::move(task), delay);
@@ -149,11 +166,61 @@ void Watchdog::GetSamplerResult(uint64_t &samplerStartTime, uint64_t &samplerFin
     samplerCount = result.samplerCount;
 }
 
+void Watchdog::SetSamplerWarmCache(bool isEnable)
+{
+    WatchdogInner::GetInstance().SetSamplerWarmCache(isEnable);
+}
+
+void Watchdog::SetFreezeSampleRecord(bool isEnable)
+{
+    WatchdogInner::GetInstance().SetFreezeSampleRecord(isEnable);
+}
+
+bool Watchdog::SetFreezeSampleFormat(int format)
+{
+    return WatchdogInner::GetInstance().SetFreezeSampleFormat(format);
+}
+
+bool Watchdog::StartFlightRecorder(uint32_t sampleInterval, uint32_t window)
+{
+    return WatchdogInner::GetInstance().StartFlightRecorder(sampleInterval, window);
+}
+
+void Watchdog::StopFlightRecorder()
+{
+    WatchdogInner::GetInstance().StopFlightRecorder();
+}
+
 int32_t Watchdog::GetReservedTimeForLogging()
 {
     return WatchdogInner::GetInstance().GetReservedTimeForLogging();
 }
 
+uint64_t Watchdog::GetWakeupsPerMinute()
+{
+    return WatchdogInner::GetInstance().GetWakeupsPerMinute();
+}
+
+std::string Watchdog::DumpSchedulerStats(bool isJson)
+{
+    return WatchdogInner::GetInstance().DumpSchedulerStats(isJson);
+}
+
+std::string Watchdog::DumpProbeLatency(bool isJson)
+{
+    return WatchdogInner::GetInstance().DumpProbeLatency(isJson);
+}
+
+int Watchdog::EnableSupervisedMode(uint32_t slotCount)
+{
+    return WatchdogInner::GetInstance().EnableSupervisedMode(slotCount);
+}
+
+bool Watchdog::HandleSupervisorFault(uint32_t slot, uint64_t generation, int waitState)
+{
+    return WatchdogInner::GetInstance().HandleSupervisorFault(slot, generation, waitState);
+}
+
 void* Watchdog::SetFreezeHandler(OH_HiCollie_FreezeCallback handler)
 {
     return XcollieMgr::GetInstance().SetHandler(handler);
@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2026 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "watchdog_histogram.h"
+
+#include <algorithm>
+
+namespace OHOS {
+namespace HiviewDFX {
+namespace {
+constexpr uint64_t MAX_VALUE = (1ULL << LatencyHistogram::MAX_VALUE_BITS) - 1;
+constexpr double QUANTILE_P50 = 0.5;
+constexpr double QUANTILE_P90 = 0.9;
+constexpr double QUANTILE_P99 = 0.99;
+constexpr double QUANTILE_P999 = 0.999;
+
+uint32_t HighestBit(uint64_t value)
+{
+    return 63 - static_cast<uint32_t>(__builtin_clzll(value)); // 63: index of the top bit
+}
+}
+
+uint32_t LatencyHistogram::BucketIndex(uint64_t value)
+{
+    value = std::min(value, MAX_VALUE);
+    if (value < SUB_BUCKET_NUM) {
+        return static_cast<uint32_t>(value);
+    }
+    uint32_t shift = HighestBit(value) - SUB_BUCKET_BITS;
+    return (shift + 1) * SUB_BUCKET_NUM + static_cast<uint32_t>((value >> shift) & (SUB_BUCKET_NUM - 1));
+}
+
+uint64_t LatencyHistogram::BucketUpperBound(uint32_t index)
+{
+    if (index < SUB_BUCKET_NUM) {
+        return index;
+    }
+    uint32_t shift = index / SUB_BUCKET_NUM - 1;
+    uint64_t lower = static_cast<uint64_t>(SUB_BUCKET_NUM + index % SUB_BUCKET_NUM) << shift;
+    return lower + (1ULL << shift) - 1;
+}
+
+void LatencyHistogram::Record(uint64_t value)
+{
+    buckets_[BucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(value, std::memory_order_relaxed);
+    uint64_t max = max_.load(std::memory_order_relaxed);
+    while (value > max && !max_.compare_exchange_weak(max, value, std::memory_order_relaxed)) {
+    }
+}
+
+uint64_t LatencyHistogram::Percentile(double quantile) const
+{
+    uint64_t counts[BUCKET_NUM];
+    uint64_t total = 0;
+    for (uint32_t i = 0; i < BUCKET_NUM; i++) {
+        counts[i] = buckets_[i].load(std::memory_order_relaxed);
+        total += counts[i];
+    }
+    if (total == 0) {
+        return 0;
+    }
+    quantile = std::clamp(quantile, 0.0, 1.0);
+    uint64_t rank = std::max<uint64_t>(static_cast<uint64_t>(quantile * static_cast<double>(total) + 0.5), 1);
+    uint64_t max = max_.load(std::memory_order_relaxed);
+    uint64_t seen = 0;
+    for (uint32_t i = 0; i < BUCKET_NUM; i++) {
+        seen += counts[i];
+        if (seen >= rank) {
+            // the bucket bound may overshoot the largest recorded value
+            return (max != 0) ? std::min(BucketUpperBound(i), max) : BucketUpperBound(i);
+        }
+    }
+    return max;
+}
+
+LatencyHistogram::Summary LatencyHistogram::GetSummary() const
+{
+    Summary summary;
+    summary.count = count_.load(std::memory_order_relaxed);
+    if (summary.count == 0) {
+        return summary;
+    }
+    summary.mean = sum_.load(std::memory_order_relaxed) / summary.count;
+    summary.p50 = Percentile(QUANTILE_P50);
+    summary.p90 = Percentile(QUANTILE_P90);
+    summary.p99 = Percentile(QUANTILE_P99);
+    summary.p999 = Percentile(QUANTILE_P999);
+    summary.max = max_.load(std::memory_order_relaxed);
+    return summary;
+}
+} // end of namespace HiviewDFX
+} // end of namespace OHOS
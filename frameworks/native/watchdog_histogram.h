@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2026 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef RELIABILITY_WATCHDOG_HISTOGRAM_H
+#define RELIABILITY_WATCHDOG_HISTOGRAM_H
+
+#include <atomic>
+#include <cstdint>
+
+namespace OHOS {
+namespace HiviewDFX {
+/*
+ * Log-linear histogram of microsecond values in the HDR layout: every power of two is split
+ * into SUB_BUCKET_NUM linear buckets, so a reported percentile is within 1/SUB_BUCKET_NUM of
+ * the recorded value. Record is a few relaxed atomic adds and may race with readers.
+ */
+class LatencyHistogram {
+public:
+    static constexpr uint32_t SUB_BUCKET_BITS = 3;
+    static constexpr uint32_t SUB_BUCKET_NUM = 1U << SUB_BUCKET_BITS;
+    // larger values, about 71 minutes, are counted in the last bucket
+    static constexpr uint32_t MAX_VALUE_BITS = 32;
+    static constexpr uint32_t BUCKET_NUM = (MAX_VALUE_BITS - SUB_BUCKET_BITS + 1) * SUB_BUCKET_NUM;
+
+    struct Summary {
+        uint64_t count = 0;
+        uint64_t mean = 0;
+        uint64_t p50 = 0;
+        uint64_t p90 = 0;
+        uint64_t p99 = 0;
+        uint64_t p999 = 0;
+        uint64_t max = 0;
+    };
+
+    void Record(uint64_t value);
+    // Highest value of the bucket holding the given quantile, 0 when nothing was recorded.
+    uint64_t Percentile(double quantile) const;
+    Summary GetSummary() const;
+
+    static uint32_t BucketIndex(uint64_t value);
+    static uint64_t BucketUpperBound(uint32_t index);
+
+private:
+    std::atomic<uint64_t> buckets_[BUCKET_NUM] {};
+    std::atomic<uint64_t> count_ {0};
+    std::atomic<uint64_t> sum_ {0};
+    std::atomic<uint64_t> max_ {0};
+};
+} // end of namespace HiviewDFX
+} // end of namespace OHOS
+#endif
@@ -15,6 +15,7 @@
 
 #include "watchdog_inner.h"
 
+#include <algorithm>
 #include <cerrno>
 #include <climits>
 #include <cstdio>
@@ -102,6 +103,12 @@ constexpr const char* KICK_TIME_EXTRA = "kick,";
 constexpr int32_t NOT_OPEN = -1;
 constexpr const char* LIB_THREAD_SAMPLER_PATH = "libthread_sampler.z.so";
 constexpr size_t STACK_LENGTH = 128 * 1024;
+constexpr int SAMPLER_HEAVIEST_STACK_PART = 1; // part of ThreadSamplerCollectStream
+constexpr const char* FREEZE_SAMPLE_SUFFIX[] = {".txt", ".tsr", ".folded", ".pb"}; // by freeze sample format
+constexpr const char* FLIGHT_RECORDER_TASK = "FlightRecorder";
+constexpr const char* FLIGHT_RECORDER_RELEASE_TASK = "FlightRecorderRelease";
+constexpr size_t FLIGHT_RECORDER_MEMORY_BUDGET = 64 * 1024;
+constexpr uint32_t FLIGHT_RECORDER_CPU_BUDGET = 5; // permille
 constexpr uint64_t DEFAULT_SLEEP_TIME = 2 * 1000;
 constexpr uint32_t JOIN_IPC_FULL_UIDS[] = {
     AUDIO_SERVER_UID, DATA_MANAGE_SERVICE_UID,
@@ -112,6 +119,13 @@ constexpr uint64_t MAX_IPC_CHECK_INTERVAL = 30;
 constexpr uint64_t SAMPLE_STACK_MAP_SIZE = 5;
 constexpr uint64_t SAMPLE_TRACE_MAP_SIZE = 1;
 constexpr uint64_t KICK_WATCHDOG_INTERVAL = 30 * 1000;
+constexpr uint64_t WAKEUP_RATE_WINDOW = 60 * 1000;
+constexpr uint64_t SUBMIT_RETRY_INTERVAL = 1;
+constexpr uint32_t SUBMIT_QUEUE_CAPACITY = 64;
+constexpr size_t REPORT_QUEUE_CAPACITY = 16;
+constexpr size_t DUE_TASK_CAPACITY = 64;
+constexpr size_t SCENE_CAPACITY = 256; // prefix and a task name limited to MAX_NAME_SIZE
+constexpr const char* TASK_SCENE_PREFIX = "thread DfxWatchdog: Current scenario is task name: ";
 constexpr int AUTO_STOP_EVENT_TYPE = 1;
 constexpr int MAX_SAMPLE_STACK_TIMES = 2500; // 2.5s
 constexpr int SAMPLE_INTERVAL_MIN = 50; // 50ms
@@ -150,6 +164,7 @@ static std::atomic_bool g_isDumpStack {false};
 static std::shared_ptr<XCollieFfrtTask> xcollieFfrtTask_ = nullptr;
 
 SigActionType WatchdogInner::threadSamplerSigHandler_ = nullptr;
+SigActionType WatchdogInner::flightSigHandler_ = nullptr;
 std::mutex WatchdogInner::threadSamplerSignalMutex_;
 
 std::atomic_bool WatchdogInner::isTestExist_ = false;
@@ -191,11 +206,31 @@ static const int CRASH_SIGNAL_LIST[] = {
     SIGILL, SIGABRT, SIGBUS, SIGFPE,
     SIGSEGV, SIGSTKFLT, SIGSYS, SIGTRAP
 };
+
+struct StreamedStacks {
+    std::string* stack;
+    std::string* heaviestStack;
+};
+
+int AppendStreamedStack(void* context, int part, const char* data, size_t size)
+{
+    auto stacks = static_cast<StreamedStacks*>(context);
+    (part == SAMPLER_HEAVIEST_STACK_PART ? stacks->heaviestStack : stacks->stack)->append(data, size);
+    return 0;
+}
+
+int AppendWrittenData(void* context, int part, const char* data, size_t size)
+{
+    static_cast<std::string*>(context)->append(data, size);
+    return 0;
+}
 }
 
 WatchdogInner::WatchdogInner()
-    : cntCallback_(0), timeCallback_(0)
+    : submitQueue_(SUBMIT_QUEUE_CAPACITY), reportQueue_(REPORT_QUEUE_CAPACITY), cntCallback_(0), timeCallback_(0)
 {
+    currentScene_.reserve(SCENE_CAPACITY);
+    dueTasks_.reserve(DUE_TASK_CAPACITY);
     currentScene_ = "thread DfxWatchdog: Current scenario is hicollie.\n";
 }
 
@@ -206,25 +241,15 @@ WatchdogInner::~WatchdogInner()
 
 static bool IsInAppspwan()
 {
-    if (getuid() == 0 && GetSelfProcName().find("appspawn") != std::string::npos) {
-        return true;
-    }
-
-    if (getuid() == 0 && GetSelfProcName().find("nativespawn") != std::string::npos) {
-        return true;
-    }
-
-    if (getuid() == 0 && GetSelfProcName().find("hybridspawn") != std::string::npos) {
-        return true;
-    }
-
-    return false;
+    return IsSpawnerProcess();
 }
 
 void WatchdogInner::SetBundleInfo(const std::string& bundleName, const std::string& bundleVersion)
 {
     bundleName_ = bundleName;
     bundleVersion_ = bundleVersion;
+    // the app is specialized by now, its name and uid differ from the spawner it was forked from
+    InvalidateProcessIdentity();
 }
 
 void WatchdogInner::SetSystemApp(bool isSystemApp)
@@ -262,10 +287,13 @@ bool WatchdogInner::ReportMainThreadEvent(int64_t tid, std::string eventName, bo
     std::string path;
     int32_t pid = getprocpid();
     bool isOverLimit = false;
+    // the onset of the jank before the sampling started, only in the log file
+    std::string flightSamples = GetFlightRecorderSamples();
     if (!WriteStackToFd(pid, path, stack, eventName, isOverLimit)) {
         XCOLLIE_LOGI("MainThread WriteStackToFd Failed");
         return false;
     }
+    PostFlightRecorderStack(path, std::move(flightSamples));
 #ifdef HISYSEVENT_ENABLE
     int result = -1;
     if (appStart) {
@@ -342,7 +370,7 @@ bool WatchdogInner::InstallThreadSamplerSignal()
 void WatchdogInner::UninstallThreadSamplerSignal()
 {
     std::lock_guard<std::mutex> lock(threadSamplerSignalMutex_);
-    threadSamplerSigHandler_ = nullptr;
+    threadSamplerSigHandler_ = flightSigHandler_;
 }
 
 bool WatchdogInner::CheckThreadSampler(bool recordSubmitterStack)
@@ -387,6 +415,14 @@ bool WatchdogInner::InitThreadSamplerFuncs()
             reinterpret_cast<SigActionType>(FunctionOpen(threadSamplerFuncHandler_, "ThreadSamplerSigHandler"));
         threadSamplerGetResultFunc_ = reinterpret_cast<ThreadSamplerGetResultFunc>(
             FunctionOpen(threadSamplerFuncHandler_, "ThreadSamplerGetResult"));
+        // optional, the freeze sample falls back to the symbolized stack without them
+        threadSamplerCollectRecordFunc_ = reinterpret_cast<ThreadSamplerCollectRecordFunc>(
+            FunctionOpen(threadSamplerFuncHandler_, "ThreadSamplerCollectRecord"));
+        threadSamplerCollectProfileFunc_ = reinterpret_cast<ThreadSamplerCollectProfileFunc>(
+            FunctionOpen(threadSamplerFuncHandler_, "ThreadSamplerCollectProfile"));
+        // optional, the stack is copied out of fixed buffers without it
+        threadSamplerCollectStreamFunc_ = reinterpret_cast<ThreadSamplerCollectStreamFunc>(
+            FunctionOpen(threadSamplerFuncHandler_, "ThreadSamplerCollectStream"));
         if (threadSamplerInitFunc_ == nullptr || threadSamplerSampleFunc_ == nullptr ||
             threadSamplerCollectFunc_ == nullptr || threadSamplerDeinitFunc_ == nullptr ||
             threadSamplerSigHandler_ == nullptr || threadSamplerGetResultFunc_ == nullptr) {
@@ -407,7 +443,13 @@ void WatchdogInner::ResetThreadSamplerFuncs()
     threadSamplerSampleFunc_ = nullptr;
     threadSamplerCollectFunc_ = nullptr;
     threadSamplerDeinitFunc_ = nullptr;
-    threadSamplerSigHandler_ = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(threadSamplerSignalMutex_);
+        threadSamplerSigHandler_ = flightSigHandler_;
+    }
+    threadSamplerCollectRecordFunc_ = nullptr;
+    threadSamplerCollectProfileFunc_ = nullptr;
+    threadSamplerCollectStreamFunc_ = nullptr;
     if (threadSamplerGetResultFunc_) {
         samplerResult_ = threadSamplerGetResultFunc_();
         threadSamplerGetResultFunc_ = nullptr;
@@ -498,6 +540,8 @@ bool WatchdogInner::AppStartSample(bool isScroll, AppStartContent& startContent)
         startContent.collectCount.fetch_add(DEFAULT_SAMPLE_VALUE);
     };
     WatchdogTask task(APP_START_SAMPLE, sampleTask, 0, startContent.sampleInterval, false);
+    task.taskClass = WatchdogTaskClass::INTERNAL_SAMPLING;
+    task.AllowSlack();
     std::unique_lock<std::mutex> lock(lock_);
     if (!InsertWatchdogTaskLocked(APP_START_SAMPLE, std::move(task))) {
         return false;
@@ -663,6 +707,8 @@ bool WatchdogInner::StartScrollProfile(const TimePoint& endTime, int64_t duratio
         }
     };
     WatchdogTask task(STACK_CHECKER, sampleTask, 0, sampleInterval, false);
+    task.taskClass = WatchdogTaskClass::INTERNAL_SAMPLING;
+    task.AllowSlack();
     std::unique_lock<std::mutex> lock(lock_);
     InsertWatchdogTaskLocked(STACK_CHECKER, std::move(task));
     return true;
@@ -722,8 +768,11 @@ void WatchdogInner::StartProfileMainThread(const TimePoint& endTime, int64_t dur
             isMainThreadStackEnabled_;
     };
 
+    WatchdogTask task(STACK_CHECKER, sampleTask, 0, sampleInterval, false);
+    task.taskClass = WatchdogTaskClass::INTERNAL_SAMPLING;
+    task.AllowSlack();
     std::unique_lock<std::mutex> lock(lock_);
-    InsertWatchdogTaskLocked(STACK_CHECKER, WatchdogTask(STACK_CHECKER, sampleTask, 0, sampleInterval, false));
+    InsertWatchdogTaskLocked(STACK_CHECKER, std::move(task));
 }
 
 std::string WatchdogInner::SaveFreezeStackToFile(int32_t pid)
@@ -734,21 +783,32 @@ std::string WatchdogInner::SaveFreezeStackToFile(int32_t pid)
         return "";
     }
     XCOLLIE_LOGI("Start to collect stack, pid:%{public}d.", pid);
-    std::string stack;
-    std::string heaviestStack;
-    if (!CollectStack(stack, heaviestStack, 0)) {
-        XCOLLIE_LOGI("Collect freeze sample stack failed.");
-        return "";
+    std::string info;
+    std::string flightSamples;
+    bool collected = false;
+    switch (sampleFreezeInfo_.format) {
+        case FREEZE_SAMPLE_RECORD:
+            collected = CollectStackRecord(info);
+            break;
+        case FREEZE_SAMPLE_COLLAPSED:
+        case FREEZE_SAMPLE_PPROF:
+            collected = CollectStackProfile(sampleFreezeInfo_.format - FREEZE_SAMPLE_COLLAPSED, info);
+            break;
+        default:
+            collected = GetFreezeStackInfo(pid, info);
+            flightSamples = GetFlightRecorderSamples();
+            break;
     }
-    std::string info = "#ThreadInfos Tid: " + std::to_string(pid) + ", Name: " + bundleName_ + "\n";
-    if (g_isReuseStack) {
-        info += "The current thread is collecting the stack, which conflicts with the main thread jank event."
-            " Reuse the current stack.";
+    if (!collected) {
+        XCOLLIE_LOGI("Collect freeze sample format %{public}d failed.", sampleFreezeInfo_.format);
+        return "";
     }
-    info += stack;
     ClearFreezeFileIfNeed(info.size());
     std::string freezeFile = sampleFreezeInfo_.currentFile;
     bool saveRet = SaveStringToFile(FREEZE_DIR + freezeFile, info);
+    if (saveRet) {
+        PostFlightRecorderStack(FREEZE_DIR + freezeFile, std::move(flightSamples));
+    }
     sampleFreezeInfo_ = {
         .lastSaveTime = GetCurrentTickMillseconds(),
         .freezeFile = freezeFile,
@@ -757,6 +817,23 @@ std::string WatchdogInner::SaveFreezeStackToFile(int32_t pid)
     return freezeFile;
 }
 
+bool WatchdogInner::GetFreezeStackInfo(int32_t pid, std::string& info)
+{
+    info = "#ThreadInfos Tid: " + std::to_string(pid) + ", Name: " + bundleName_ + "\n";
+    if (g_isReuseStack) {
+        info += "The current thread is collecting the stack, which conflicts with the main thread jank event."
+            " Reuse the current stack.";
+    }
+    // the stack goes straight after the head of the file
+    std::string heaviestStack;
+    if (!AppendStack(info, heaviestStack, 0)) {
+        XCOLLIE_LOGI("Collect freeze sample stack failed.");
+        info.clear();
+        return false;
+    }
+    return true;
+}
+
 void WatchdogInner::ResetFreezeSampleFlags()
 {
     g_isDumpStack.store(false);
@@ -821,6 +898,8 @@ std::string WatchdogInner::StartSample(int duration, int interval)
         g_freezeSampleCount.fetch_add(DEFAULT_SAMPLE_VALUE);
     };
     WatchdogTask task(FREEZE_SAMPLE, sampleTask, 0, interval, false);
+    task.taskClass = WatchdogTaskClass::INTERNAL_SAMPLING;
+    task.AllowSlack();
     int id = 0;
     {
         std::unique_lock<std::mutex> lock(lock_);
@@ -828,8 +907,10 @@ std::string WatchdogInner::StartSample(int duration, int interval)
     }
     std::string file = "";
     if (id != 0) {
-        file = "freeze_" + GetFormatDate() + "_" + std::to_string(pid) + ".txt";
+        int format = freezeSampleFormat_.load();
+        file = "freeze_" + GetFormatDate() + "_" + std::to_string(pid) + FREEZE_SAMPLE_SUFFIX[format];
         sampleFreezeInfo_.currentFile = file;
+        sampleFreezeInfo_.format = format;
         XCOLLIE_LOGW("Sample freeze half file=%{public}s", file.c_str());
     }
     return file;
@@ -859,8 +940,269 @@ SamplerResult WatchdogInner::GetSamplerResult()
     return samplerResult_;
 }
 
+void WatchdogInner::SetSamplerWarmCache(bool isEnable)
+{
+#if defined(__aarch64__) || defined(__loongarch_lp64)
+    std::lock_guard<std::mutex> lock(warmSamplerLock_);
+    if ((warmSamplerHandler_ != nullptr) == isEnable) {
+        return;
+    }
+    if (isEnable) {
+        warmSamplerHandler_ = dlopen(LIB_THREAD_SAMPLER_PATH, RTLD_LAZY);
+        if (warmSamplerHandler_ == nullptr) {
+            XCOLLIE_LOGE("dlopen failed, warm sampler is not enabled.\n");
+            return;
+        }
+    }
+    auto setWarmCacheFunc = reinterpret_cast<ThreadSamplerSetWarmCacheFunc>(
+        FunctionOpen(warmSamplerHandler_, "ThreadSamplerSetWarmCache"));
+    if (setWarmCacheFunc != nullptr) {
+        setWarmCacheFunc(isEnable ? 1 : 0);
+    }
+    if (!isEnable || setWarmCacheFunc == nullptr) {
+        dlclose(warmSamplerHandler_);
+        warmSamplerHandler_ = nullptr;
+    }
+    XCOLLIE_LOGI("Set sampler warm cache %{public}d.\n", warmSamplerHandler_ != nullptr);
+#endif
+}
+
+void WatchdogInner::SetFreezeSampleRecord(bool isEnable)
+{
+    freezeSampleFormat_.store(isEnable ? FREEZE_SAMPLE_RECORD : FREEZE_SAMPLE_TEXT);
+}
+
+bool WatchdogInner::SetFreezeSampleFormat(int format)
+{
+    if (format < FREEZE_SAMPLE_TEXT || format > FREEZE_SAMPLE_PPROF) {
+        XCOLLIE_LOGE("Invalid freeze sample format %{public}d.", format);
+        return false;
+    }
+    freezeSampleFormat_.store(format);
+    return true;
+}
+
+bool WatchdogInner::StartFlightRecorder(uint32_t sampleInterval, uint32_t window)
+{
+#if defined(__aarch64__) || defined(__loongarch_lp64)
+    if (sampleInterval < FLIGHT_RECORDER_MIN_INTERVAL || window < sampleInterval) {
+        XCOLLIE_LOGE("Start flight recorder failed, interval=%{public}u, window=%{public}u.", sampleInterval, window);
+        return false;
+    }
+    if (isFlightRecorderOn_.exchange(true)) {
+        XCOLLIE_LOGW("Flight recorder already started.");
+        return false;
+    }
+    // loaded and sampled on the watchdog thread, like the sampling sessions it shares the sampler with
+    auto flightTask = [this, sampleInterval, window]() {
+        // skip this sample rather than wait for a copy of the ring or a release
+        std::unique_lock<std::mutex> lock(flightRecorderLock_, std::try_to_lock);
+        if (!lock.owns_lock() || !isFlightRecorderOn_) {
+            return;
+        }
+        if (flightContent_.handler == nullptr && !InitFlightRecorder(sampleInterval, window)) {
+            isFlightRecorderOn_.store(false);
+            return;
+        }
+        flightContent_.sampleFunc();
+    };
+    RunPeriodicalTask(FLIGHT_RECORDER_TASK, flightTask, sampleInterval, sampleInterval,
+        WatchdogTaskClass::INTERNAL_SAMPLING);
+    return true;
+#else
+    return false;
+#endif
+}
+
+void WatchdogInner::StopFlightRecorder()
+{
+    if (!isFlightRecorderOn_.exchange(false)) {
+        return;
+    }
+    RemoveInnerTask(FLIGHT_RECORDER_TASK);
+    RunOneShotTask(FLIGHT_RECORDER_RELEASE_TASK, [this]() {
+        std::lock_guard<std::mutex> lock(flightRecorderLock_);
+        if (!isFlightRecorderOn_) {
+            ReleaseFlightRecorder();
+        }
+    }, 0);
+}
+
+bool WatchdogInner::InitFlightRecorder(uint32_t sampleInterval, uint32_t window)
+{
+    void* handler = dlopen(LIB_THREAD_SAMPLER_PATH, RTLD_LAZY);
+    if (handler == nullptr) {
+        XCOLLIE_LOGE("dlopen failed, flight recorder is not started.\n");
+        return false;
+    }
+    FlightRecorderContent content;
+    content.handler = handler;
+    content.window = window;
+    content.startFunc = reinterpret_cast<ThreadSamplerStartFlightRecorderFunc>(
+        FunctionOpen(handler, "ThreadSamplerStartFlightRecorder"));
+    content.stopFunc = reinterpret_cast<ThreadSamplerStopFlightRecorderFunc>(
+        FunctionOpen(handler, "ThreadSamplerStopFlightRecorder"));
+    content.sampleFunc = reinterpret_cast<ThreadSamplerFlightSampleFunc>(
+        FunctionOpen(handler, "ThreadSamplerFlightSample"));
+    content.copySamplesFunc = reinterpret_cast<ThreadSamplerCopyFlightSamplesFunc>(
+        FunctionOpen(handler, "ThreadSamplerCopyFlightSamples"));
+    content.symbolizeFunc = reinterpret_cast<ThreadSamplerSymbolizeFlightSamplesFunc>(
+        FunctionOpen(handler, "ThreadSamplerSymbolizeFlightSamples"));
+    content.getStatsFunc = reinterpret_cast<ThreadSamplerGetFlightRecorderStatsFunc>(
+        FunctionOpen(handler, "ThreadSamplerGetFlightRecorderStats"));
+    auto sigHandler = reinterpret_cast<SigActionType>(FunctionOpen(handler, "ThreadSamplerSigHandler"));
+    if (content.startFunc == nullptr || content.stopFunc == nullptr || content.sampleFunc == nullptr ||
+        content.copySamplesFunc == nullptr || content.symbolizeFunc == nullptr || content.getStatsFunc == nullptr ||
+        sigHandler == nullptr || !InstallThreadSamplerSignal()) {
+        XCOLLIE_LOGE("Flight recorder dlsym some function or install signal failed.\n");
+        dlclose(handler);
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(threadSamplerSignalMutex_);
+        flightSigHandler_ = sigHandler;
+        if (threadSamplerSigHandler_ == nullptr) {
+            threadSamplerSigHandler_ = sigHandler;
+        }
+    }
+    flightContent_ = content;
+    if (flightContent_.startFunc(sampleInterval, window, FLIGHT_RECORDER_MEMORY_BUDGET,
+        FLIGHT_RECORDER_CPU_BUDGET) != 0) {
+        XCOLLIE_LOGE("Flight recorder start failed.\n");
+        ReleaseFlightRecorder();
+        return false;
+    }
+    XCOLLIE_LOGI("Flight recorder started, interval=%{public}u, window=%{public}u.", sampleInterval, window);
+    return true;
+}
+
+void WatchdogInner::ReleaseFlightRecorder()
+{
+    if (flightContent_.handler == nullptr) {
+        return;
+    }
+    FlightRecorderStats stats = flightContent_.getStatsFunc();
+    flightContent_.stopFunc();
+    {
+        std::lock_guard<std::mutex> lock(threadSamplerSignalMutex_);
+        flightSigHandler_ = nullptr;
+        // a running session uses the handler till its Deinit
+        if (threadSamplerFuncHandler_ == nullptr) {
+            threadSamplerSigHandler_ = nullptr;
+        }
+    }
+    XCOLLIE_LOGI("Flight recorder stopped, samples=%{public}" PRIu64 ", skipped=%{public}" PRIu64
+        ", cost=%{public}" PRIu64 "ns, maxCost=%{public}" PRIu64 "ns, memory=%{public}" PRIu64 ".",
+        stats.sampleCount, stats.skippedCount, stats.costTime, stats.maxCostTime, stats.memorySize);
+    dlclose(flightContent_.handler);
+    flightContent_ = {};
+}
+
+std::string WatchdogInner::GetFlightRecorderSamples()
+{
+    std::lock_guard<std::mutex> lock(flightRecorderLock_);
+    std::string samples;
+    if (flightContent_.copySamplesFunc == nullptr) {
+        return samples;
+    }
+    if (flightContent_.copySamplesFunc(flightContent_.window, AppendWrittenData, &samples) != 0) {
+        samples.clear();
+    }
+    return samples;
+}
+
+std::string WatchdogInner::SymbolizeFlightRecorderSamples(const std::string& samples)
+{
+    std::string stack;
+    if (samples.empty()) {
+        return stack;
+    }
+    void* handler = nullptr;
+    ThreadSamplerSymbolizeFlightSamplesFunc symbolizeFunc = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(flightRecorderLock_);
+        if (flightContent_.symbolizeFunc == nullptr) {
+            return stack;
+        }
+        // pin the library rather than hold the lock, a release meanwhile unloads it after the symbolization
+        handler = dlopen(LIB_THREAD_SAMPLER_PATH, RTLD_LAZY | RTLD_NOLOAD);
+        symbolizeFunc = flightContent_.symbolizeFunc;
+    }
+    if (handler == nullptr) {
+        return stack;
+    }
+    if (symbolizeFunc(samples.data(), samples.size(), AppendWrittenData, &stack) != 0) {
+        stack.clear();
+    }
+    dlclose(handler);
+    return stack;
+}
+
+void WatchdogInner::PostFlightRecorderStack(const std::string& path, std::string&& samples)
+{
+    if (samples.empty()) {
+        return;
+    }
+    PostReport([this, path, samples = std::move(samples)] {
+        std::string flightStack = SymbolizeFlightRecorderSamples(samples);
+        if (!flightStack.empty() && !OHOS::SaveStringToFile(path, "\n" + flightStack, false)) {
+            XCOLLIE_LOGE("Append flight recorder stack to %{public}s failed.", path.c_str());
+        }
+    });
+}
+
+bool WatchdogInner::CollectStackRecord(std::string& record)
+{
+    record.clear();
+    if (threadSamplerCollectRecordFunc_ == nullptr) {
+        return false;
+    }
+    int collectRet = threadSamplerCollectRecordFunc_(0, AppendWrittenData, &record);
+    if (collectRet != 0) {
+        XCOLLIE_LOGE("threadSampler collect record failed, ret: %{public}d", collectRet);
+        record.clear();
+        return false;
+    }
+    return true;
+}
+
+bool WatchdogInner::CollectStackProfile(int format, std::string& profile)
+{
+    profile.clear();
+    if (threadSamplerCollectProfileFunc_ == nullptr) {
+        return false;
+    }
+    int collectRet = threadSamplerCollectProfileFunc_(0, format, AppendWrittenData, &profile);
+    if (collectRet != 0) {
+        XCOLLIE_LOGE("threadSampler collect profile failed, ret: %{public}d", collectRet);
+        profile.clear();
+        return false;
+    }
+    return true;
+}
+
 bool WatchdogInner::CollectStack(std::string& stack, std::string& heaviestStack, int treeFormat)
 {
+    stack.clear();
+    heaviestStack.clear();
+    return AppendStack(stack, heaviestStack, treeFormat);
+}
+
+bool WatchdogInner::AppendStack(std::string& stack, std::string& heaviestStack, int treeFormat)
+{
+    if (threadSamplerCollectStreamFunc_ != nullptr) {
+        size_t stackLen = stack.size();
+        size_t heaviestLen = heaviestStack.size();
+        StreamedStacks stacks {&stack, &heaviestStack};
+        int collectRet = threadSamplerCollectStreamFunc_(0, treeFormat, AppendStreamedStack, &stacks);
+        if (collectRet != 0) {
+            XCOLLIE_LOGE("threadSampler collect stack failed, ret: %{public}d", collectRet);
+            stack.resize(stackLen);
+            heaviestStack.resize(heaviestLen);
+            return false;
+        }
+        return true;
+    }
     if (threadSamplerCollectFunc_ == nullptr) {
         return false;
     }
@@ -875,8 +1217,8 @@ bool WatchdogInner::CollectStack(std::string& stack, std::string& heaviestStack,
         XCOLLIE_LOGE("threadSampler collect stack failed, ret: %{public}d", collectRet);
         return false;
     }
-    stack.assign(stk.get(), std::min(strlen(stk.get()), STACK_LENGTH - 1));
-    heaviestStack.assign(heaviest.get(), std::min(strlen(heaviest.get()), STACK_LENGTH - 1));
+    stack.append(stk.get(), std::min(strlen(stk.get()), STACK_LENGTH - 1));
+    heaviestStack.append(heaviest.get(), std::min(strlen(heaviest.get()), STACK_LENGTH - 1));
     return true;
 }
 
@@ -940,6 +1282,8 @@ int32_t WatchdogInner::StartTraceProfile()
     traceContent_.traceCount = 0;
     auto traceTask = [this] { this->DumpTraceTask(DURATION_TIME); };
     WatchdogTask task(TRACE_CHECKER, traceTask, 0, DURATION_TIME, false);
+    task.taskClass = WatchdogTaskClass::INTERNAL_SAMPLING;
+    task.AllowSlack();
     {
         std::unique_lock<std::mutex> lock(lock_);
         InsertWatchdogTaskLocked(TRACE_CHECKER, std::move(task));
@@ -1016,6 +1360,18 @@ static void DistributeEnd(const std::string& name, const TimePoint& startTime)
     }
 }
 
+static TimePoint MainLooperStart(const std::string& name)
+{
+    WatchdogInner::GetInstance().mainBeat_.load(std::memory_order_acquire)->BeginEvent();
+    return DistributeStart(name);
+}
+
+static void MainLooperEnd(const std::string& name, const TimePoint& startTime)
+{
+    DistributeEnd(name, startTime);
+    WatchdogInner::GetInstance().mainBeat_.load(std::memory_order_acquire)->EndEvent();
+}
+
 int WatchdogInner::AddThread(const std::string &name, std::shared_ptr<AppExecFwk::EventHandler> handler,
     TimeOutCallback timeOutCallback, uint64_t interval, uint32_t priority)
 {
@@ -1044,6 +1400,78 @@ int WatchdogInner::AddThread(const std::string &name, std::shared_ptr<AppExecFwk
     return 0;
 }
 
+int WatchdogInner::AddHeartbeatThread(const std::string &name, std::shared_ptr<AppExecFwk::EventHandler> handler,
+    std::shared_ptr<HeartbeatSlot> heartbeat, TimeOutCallback timeOutCallback, uint64_t interval)
+{
+    if (name.empty() || handler == nullptr) {
+        XCOLLIE_LOGE("Add heartbeat thread fail, invalid args!");
+        return -1;
+    }
+
+    if (IsInAppspwan()) {
+        return -1;
+    }
+
+    if (heartbeat == nullptr) {
+        if (handler->GetEventRunner() != AppExecFwk::EventRunner::GetMainEventRunner()) {
+            XCOLLIE_LOGE("Add heartbeat thread fail, only the main looper beats by itself!");
+            return -1;
+        }
+        heartbeat = std::atomic_load(&mainHeartbeat_);
+    }
+    std::string limitedName = GetLimitedSizeName(name);
+    XCOLLIE_LOGI("Add heartbeat thread %{public}s to watchdog.", limitedName.c_str());
+    if (heartbeat == std::atomic_load(&mainHeartbeat_) && isSupervised_.load(std::memory_order_acquire)) {
+        return AddSupervisedHeartbeat(WatchdogTask(limitedName, handler, timeOutCallback, interval,
+            AppExecFwk::EventQueue::Priority::IMMEDIATE, heartbeat));
+    }
+    std::unique_lock<std::mutex> lock(lock_);
+    if (!InsertWatchdogTaskLocked(limitedName, WatchdogTask(limitedName, handler, timeOutCallback, interval,
+        AppExecFwk::EventQueue::Priority::IMMEDIATE, heartbeat))) {
+        return -1;
+    }
+    return 0;
+}
+
+int WatchdogInner::AddAdaptiveThread(const std::string &name, std::shared_ptr<AppExecFwk::EventHandler> handler,
+    TimeOutCallback timeOutCallback, uint64_t interval)
+{
+    if (name.empty() || handler == nullptr || interval == 0) {
+        XCOLLIE_LOGE("Add adaptive thread fail, invalid args!");
+        return -1;
+    }
+
+    if (IsInAppspwan()) {
+        return -1;
+    }
+
+    std::string limitedName = GetLimitedSizeName(name);
+    XCOLLIE_LOGI("Add adaptive thread %{public}s to watchdog.", limitedName.c_str());
+    WatchdogTask task(limitedName, handler, timeOutCallback, interval, AppExecFwk::EventQueue::Priority::IMMEDIATE);
+    task.isAdaptive = true;
+    std::unique_lock<std::mutex> lock(lock_);
+    if (!InsertWatchdogTaskLocked(limitedName, std::move(task))) {
+        return -1;
+    }
+    return 0;
+}
+
+bool WatchdogInner::SetProbeLadder(const std::string& name, bool isEnable)
+{
+    bool isFound = false;
+    std::unique_lock<std::mutex> lock(lock_);
+    checkerQueue_.ForEach([&name, isEnable, &isFound](const WatchdogTask& task) {
+        if (task.name == name && task.checker != nullptr) {
+            task.checker->SetProbeLadder(isEnable);
+            isFound = true;
+        }
+    });
+    if (!isFound) {
+        XCOLLIE_LOGE("Set probe ladder fail, can not find handler check %{public}s!", name.c_str());
+    }
+    return isFound;
+}
+
 void WatchdogInner::RunOneShotTask(const std::string& name, Task&& task, uint64_t delay)
 {
     if (name.empty() || task == nullptr) {
@@ -1072,35 +1500,218 @@ int64_t WatchdogInner::RunXCollieTask(const std::string& name, uint64_t timeout,
         return INVALID_ID;
     }
 
+    if (!AcquireXCollieTimerQuota()) {
+        return 0;
+    }
     std::string limitedName = GetLimitedSizeName(name);
-    std::unique_lock<std::mutex> lock(lock_);
-    return InsertWatchdogTaskLocked(limitedName, WatchdogTask(limitedName, timeout, func, arg, flag));
+    SubmitCommand command;
+    command.type = SubmitType::ARM_TIMER;
+    command.task = WatchdogTask(limitedName, timeout, func, arg, flag);
+    if (isSupervised_.load(std::memory_order_acquire)) {
+        int64_t supervisedId = ArmSupervisedTimer(std::move(command.task));
+        if (supervisedId != 0) {
+            return supervisedId;
+        }
+        // the region is full, this timer falls back to the watchdog thread
+    }
+    int64_t id = command.task.id;
+    uint64_t deadline = command.task.nextTickTime;
+    SubmitTaskCommand(std::move(command), deadline);
+    return id;
 }
 
 void WatchdogInner::RemoveXCollieTask(int64_t id)
 {
-    std::priority_queue<WatchdogTask> tmpQueue;
-    std::unique_lock<std::mutex> lock(lock_);
-    size_t size = checkerQueue_.size();
+    if (isSupervised_.load(std::memory_order_acquire) && RemoveSupervisedTimer(id)) {
+        return;
+    }
+    SubmitCommand command;
+    command.type = SubmitType::CANCEL_TIMER;
+    command.id = id;
+    SubmitTaskCommand(std::move(command), UINT64_MAX);
+}
+
+void WatchdogInner::RemoveXCollieTaskLocked(int64_t id)
+{
+    size_t size = timerWheel_.Size();
     if (size == 0) {
         XCOLLIE_LOGE("Remove XCollieTask %{public}lld fail, empty queue!", static_cast<long long>(id));
         return;
     }
-    while (!checkerQueue_.empty()) {
-        const WatchdogTask& task = checkerQueue_.top();
-        if (task.id != id || task.timeout == 0) {
-            tmpQueue.push(task);
-        }
-        checkerQueue_.pop();
-    }
-    if (tmpQueue.size() == size) {
+    if (!timerWheel_.Remove(id)) {
         XCOLLIE_LOGE("Remove XCollieTask fail, can not find timer %{public}lld, size=%{public}zu!",
             static_cast<long long>(id), size);
+        return;
+    }
+    ReleaseXCollieTimerQuota(1);
+}
+
+int WatchdogInner::EnableSupervisedMode(uint32_t slotCount)
+{
+    if (IsInAppspwan()) {
+        return -1;
+    }
+    std::unique_lock<std::mutex> lock(supervisedLock_);
+    if (sharedRegion_ != nullptr) {
+        return sharedRegion_->GetFd();
+    }
+    if (threadLoop_ != nullptr) {
+        XCOLLIE_LOGE("Enable supervised mode fail, the watchdog thread is running!");
+        return -1;
+    }
+    auto region = std::make_shared<WatchdogSharedRegion>();
+    if (!region->Create(slotCount)) {
+        XCOLLIE_LOGE("Enable supervised mode fail, slotCount:%{public}u", slotCount);
+        return -1;
+    }
+    uint64_t generation = 0;
+    int32_t slot = region->Reserve(generation);
+    // the main looper beats into the region, the slot is published once the main looper is added
+    auto heartbeat = std::shared_ptr<HeartbeatSlot>(region, region->GetHeartbeat(static_cast<uint32_t>(slot)));
+    heartbeat->SetAttached(localHeartbeat_->IsAttached());
+    std::atomic_store(&mainHeartbeat_, heartbeat);
+    mainBeat_.store(heartbeat.get(), std::memory_order_release);
+    mainHeartbeatSlot_ = static_cast<uint32_t>(slot);
+    mainHeartbeatGeneration_ = generation;
+    supervisedSlotIds_.assign(region->GetSlotCount(), 0);
+    sharedRegion_ = region;
+    if (mainRunner_ == nullptr) {
+        mainRunner_ = AppExecFwk::EventRunner::GetMainEventRunner();
+    }
+    if (mainRunner_ != nullptr && CheckBusinessEmpty()) {
+        mainRunner_->SetMainLooperWatcher(MainLooperStart, MainLooperEnd);
+    }
+    isSupervised_.store(true, std::memory_order_release);
+    XCOLLIE_LOGI("Watchdog is supervised, slotCount:%{public}u", slotCount);
+    return region->GetFd();
+}
+
+int64_t WatchdogInner::ArmSupervisedTimer(WatchdogTask&& task)
+{
+    std::unique_lock<std::mutex> lock(supervisedLock_);
+    uint64_t generation = 0;
+    int32_t slot = sharedRegion_->Reserve(generation);
+    if (slot < 0) {
+        return 0;
+    }
+    int64_t id = task.id;
+    uint64_t deadline = task.nextTickTime;
+    std::string name = task.name;
+    supervisedSlotIds_[slot] = id;
+    supervisedTasks_[id] = SupervisedTask {static_cast<uint32_t>(slot), generation, std::move(task)};
+    sharedRegion_->Publish(static_cast<uint32_t>(slot), generation, SharedSlotKind::TIMER, name, deadline, 0);
+    return id;
+}
+
+bool WatchdogInner::RemoveSupervisedTimer(int64_t id)
+{
+    std::unique_lock<std::mutex> lock(supervisedLock_);
+    auto it = supervisedTasks_.find(id);
+    if (it == supervisedTasks_.end() || it->second.task.timeout == 0) {
+        return false;
+    }
+    if (!sharedRegion_->Release(it->second.slot, it->second.generation)) {
+        XCOLLIE_LOGE("Remove supervised XCollieTask %{public}lld fail, slot:%{public}u!",
+            static_cast<long long>(id), it->second.slot);
     }
-    tmpQueue.swap(checkerQueue_);
+    supervisedSlotIds_[it->second.slot] = 0;
+    supervisedTasks_.erase(it);
+    ReleaseXCollieTimerQuota(1);
+    return true;
+}
+
+int WatchdogInner::AddSupervisedHeartbeat(WatchdogTask&& task)
+{
+    std::unique_lock<std::mutex> lock(supervisedLock_);
+    if (supervisedSlotIds_[mainHeartbeatSlot_] != 0) {
+        XCOLLIE_LOGE("Add heartbeat thread %{public}s fail, the main looper is already supervised!",
+            task.name.c_str());
+        return -1;
+    }
+    int64_t id = task.id;
+    std::string name = task.name;
+    uint64_t interval = task.checkInterval;
+    supervisedSlotIds_[mainHeartbeatSlot_] = id;
+    supervisedTasks_[id] = SupervisedTask {mainHeartbeatSlot_, mainHeartbeatGeneration_, std::move(task)};
+    sharedRegion_->Publish(mainHeartbeatSlot_, mainHeartbeatGeneration_, SharedSlotKind::HEARTBEAT, name, 0,
+        interval);
+    return 0;
+}
+
+bool WatchdogInner::RemoveSupervisedHeartbeat(const std::string& name)
+{
+    std::unique_lock<std::mutex> lock(supervisedLock_);
+    auto it = supervisedTasks_.find(supervisedSlotIds_[mainHeartbeatSlot_]);
+    if (it == supervisedTasks_.end() || it->second.task.name != name) {
+        return false;
+    }
+    // the slot stays reserved for the main looper, which keeps beating into it
+    if (!sharedRegion_->Transit(mainHeartbeatSlot_, mainHeartbeatGeneration_, SLOT_ARMED, SLOT_FREE)) {
+        XCOLLIE_LOGE("RemoveInnerTask %{public}s fail, its fault is being handled!", name.c_str());
+        return false;
+    }
+    supervisedTasks_.erase(it);
+    supervisedSlotIds_[mainHeartbeatSlot_] = 0;
+    return true;
+}
+
+bool WatchdogInner::HandleSupervisorFault(uint32_t slot, uint64_t generation, int waitState)
+{
+    if (!isSupervised_.load(std::memory_order_acquire)) {
+        return false;
+    }
+    std::unique_lock<std::mutex> lock(supervisedLock_);
+    if (slot >= supervisedSlotIds_.size()) {
+        return false;
+    }
+    auto it = supervisedTasks_.find(supervisedSlotIds_[slot]);
+    if (it == supervisedTasks_.end() || it->second.generation != generation) {
+        return false;
+    }
+    if (it->second.task.timeout != 0) {
+        return HandleSupervisedTimer(slot, generation, lock);
+    }
+    return HandleSupervisedHeartbeat(slot, generation, waitState, lock);
+}
+
+bool WatchdogInner::HandleSupervisedTimer(uint32_t slot, uint64_t generation, std::unique_lock<std::mutex>& lock)
+{
+    // a timer cancelled after it fired is not reported, like one cancelled before the watchdog thread ran it
+    if (!sharedRegion_->Transit(slot, generation, SLOT_FIRED, SLOT_HANDLING)) {
+        return false;
+    }
+    auto it = supervisedTasks_.find(supervisedSlotIds_[slot]);
+    WatchdogTask task = std::move(it->second.task);
+    supervisedTasks_.erase(it);
+    supervisedSlotIds_[slot] = 0;
+    lock.unlock();
+    XCOLLIE_LOGI("Supervisor fired XCollieTask %{public}s", task.name.c_str());
+    task.DoCallback();
+    sharedRegion_->Finish(slot, generation);
+    ReleaseXCollieTimerQuota(1);
+    return true;
+}
+
+bool WatchdogInner::HandleSupervisedHeartbeat(uint32_t slot, uint64_t generation, int waitState,
+    std::unique_lock<std::mutex>& lock)
+{
+    if ((waitState != CheckStatus::WAITING && waitState != CheckStatus::WAITED_HALF) ||
+        !sharedRegion_->Transit(slot, generation, SLOT_ARMED, SLOT_HANDLING)) {
+        return false;
+    }
+    int64_t id = supervisedSlotIds_[slot];
+    WatchdogTask task = supervisedTasks_[id].task;
+    lock.unlock();
+    XCOLLIE_LOGI("Supervisor found %{public}s blocked, waitState = %{public}d", task.name.c_str(), waitState);
+    task.HandleCheckerState(waitState);
+    lock.lock();
+    supervisedTasks_[id].task.reportCount = task.reportCount;
+    sharedRegion_->Transit(slot, generation, SLOT_HANDLING, SLOT_ARMED);
+    return true;
 }
 
-void WatchdogInner::RunPeriodicalTask(const std::string& name, Task&& task, uint64_t interval, uint64_t delay)
+void WatchdogInner::RunPeriodicalTask(const std::string& name, Task&& task, uint64_t interval, uint64_t delay,
+    WatchdogTaskClass taskClass)
 {
     if (name.empty() || task == nullptr) {
         XCOLLIE_LOGE("Add task fail, invalid args!");
@@ -1113,8 +1724,15 @@ void WatchdogInner::RunPeriodicalTask(const std::string& name, Task&& task, uint
 
     std::string limitedName = GetLimitedSizeName(name);
     XCOLLIE_LOGD("Add periodical task %{public}s to watchdog.", name.c_str());
-    std::unique_lock<std::mutex> lock(lock_);
-    InsertWatchdogTaskLocked(limitedName, WatchdogTask(limitedName, std::move(task), delay, interval, false));
+    SubmitCommand command;
+    command.type = SubmitType::ADD_PERIODICAL_TASK;
+    command.task = WatchdogTask(limitedName, std::move(task), delay, interval, false);
+    command.task.taskClass = taskClass;
+    if (taskClass == WatchdogTaskClass::INTERNAL_SAMPLING) {
+        command.task.AllowSlack();
+    }
+    uint64_t deadline = command.task.nextTickTime;
+    SubmitTaskCommand(std::move(command), deadline);
 }
 
 int64_t WatchdogInner::SetTimerCountTask(const std::string &name, uint64_t timeLimit, int countLimit)
@@ -1129,40 +1747,66 @@ int64_t WatchdogInner::SetTimerCountTask(const std::string &name, uint64_t timeL
     }
     std::string limitedName = GetLimitedSizeName(name);
     XCOLLIE_LOGD("SetTimerCountTask name : %{public}s", name.c_str());
+    WatchdogTask task(limitedName, timeLimit, countLimit);
+    std::shared_ptr<TimerCounter> counter = task.timerCounter;
     std::unique_lock<std::mutex> lock(lock_);
-    return InsertWatchdogTaskLocked(limitedName, WatchdogTask(limitedName, timeLimit, countLimit));
+    int64_t id = InsertWatchdogTaskLocked(limitedName, std::move(task));
+    if (id != 0) {
+        timerCounters_.Register(limitedName, counter);
+    }
+    return id;
 }
 
 void WatchdogInner::TriggerTimerCountTask(const std::string &name, bool bTrigger, const std::string &message)
 {
-    std::unique_lock<std::mutex> lock(lock_);
+    if (!timerCounters_.Trigger(name, bTrigger, GetCurrentTickMillseconds(), message)) {
+        XCOLLIE_LOGE("TriggerTimerCount name : %{public}s does not exist!", name.c_str());
+    }
+}
 
-    if (checkerQueue_.empty()) {
-        XCOLLIE_LOGE("TriggerTimerCountTask name : %{public}s fail, empty queue!", name.c_str());
+void WatchdogInner::SubmitTaskCommand(SubmitCommand&& command, uint64_t deadline)
+{
+    CreateWatchdogThreadIfNeed();
+    if (!submitQueue_.Push(std::move(command))) {
+        // ring is full, drain every claimed command first so this one is still applied in order
+        std::unique_lock<std::mutex> lock(lock_);
+        DrainSubmitQueueLocked();
+        ApplySubmitCommandLocked(command);
+        if (deadline < nextWeakUpTime_) {
+            condition_.notify_all();
+        }
         return;
     }
+    if (deadline < nextWeakUpTime_) {
+        std::unique_lock<std::mutex> lock(lock_);
+        condition_.notify_all();
+    }
+}
 
-    bool isTaskExist = false;
-    uint64_t now = GetCurrentTickMillseconds();
-    std::priority_queue<WatchdogTask> tmpQueue;
-    while (!checkerQueue_.empty()) {
-        WatchdogTask task = checkerQueue_.top();
-        if (task.name == name) {
-            isTaskExist = true;
-            if (bTrigger) {
-                task.triggerTimes.push_back(now);
-                task.message = message;
-            } else {
-                task.triggerTimes.clear();
-            }
-        }
-        tmpQueue.push(task);
-        checkerQueue_.pop();
+void WatchdogInner::DrainSubmitQueueLocked()
+{
+    SubmitCommand command;
+    while (submitQueue_.Pop(command)) {
+        ApplySubmitCommandLocked(command);
     }
-    tmpQueue.swap(checkerQueue_);
+}
 
-    if (!isTaskExist) {
-        XCOLLIE_LOGE("TriggerTimerCount name : %{public}s does not exist!", name.c_str());
+void WatchdogInner::ApplySubmitCommandLocked(SubmitCommand& command)
+{
+    switch (command.type) {
+        case SubmitType::ARM_TIMER:
+            InsertXCollieTaskLocked(std::move(command.task));
+            break;
+        case SubmitType::CANCEL_TIMER:
+            RemoveXCollieTaskLocked(command.id);
+            break;
+        case SubmitType::ADD_PERIODICAL_TASK: {
+            std::string name = command.task.name;
+            InsertWatchdogTaskLocked(name, std::move(command.task));
+            break;
+        }
+        default:
+            break;
     }
 }
 
@@ -1171,16 +1815,65 @@ bool WatchdogInner::IsTaskExistLocked(const std::string& name)
     return (taskNameSet_.find(name) != taskNameSet_.end());
 }
 
-bool WatchdogInner::IsExceedMaxTaskLocked()
+static size_t GetTaskQuota(WatchdogTaskClass taskClass)
 {
-    if (checkerQueue_.size() >= MAX_WATCH_NUM) {
-        XCOLLIE_LOGE("Exceed max watchdog task!");
+    switch (taskClass) {
+        case WatchdogTaskClass::HANDLER_CHECK:
+            return MAX_WATCH_NUM;
+        case WatchdogTaskClass::XCOLLIE_TIMER:
+            return MAX_XCOLLIE_TIMER_NUM;
+        case WatchdogTaskClass::INTERNAL_SAMPLING:
+            return MAX_SAMPLING_TASK_NUM;
+        default:
+            return MAX_GENERAL_TASK_NUM;
+    }
+}
+
+bool WatchdogInner::IsExceedMaxTaskLocked(WatchdogTaskClass taskClass)
+{
+    size_t quota = GetTaskQuota(taskClass);
+    size_t count = (taskClass == WatchdogTaskClass::XCOLLIE_TIMER) ? xcollieTimerNum_.load() :
+        checkerQueue_.Count(taskClass);
+    if (count >= quota) {
+        RecordRejectedTask(taskClass, count, quota);
         return true;
     }
 
     return false;
 }
 
+bool WatchdogInner::AcquireXCollieTimerQuota()
+{
+    size_t count = xcollieTimerNum_.fetch_add(1, std::memory_order_relaxed);
+    if (count >= MAX_XCOLLIE_TIMER_NUM) {
+        xcollieTimerNum_.fetch_sub(1, std::memory_order_relaxed);
+        RecordRejectedTask(WatchdogTaskClass::XCOLLIE_TIMER, count, MAX_XCOLLIE_TIMER_NUM);
+        return false;
+    }
+    return true;
+}
+
+void WatchdogInner::ReleaseXCollieTimerQuota(size_t count)
+{
+    xcollieTimerNum_.fetch_sub(count, std::memory_order_relaxed);
+}
+
+void WatchdogInner::RecordRejectedTask(WatchdogTaskClass taskClass, size_t count, size_t quota)
+{
+    uint64_t rejected = ++rejectedTaskNum_[static_cast<size_t>(taskClass)];
+    XCOLLIE_LOGE("Exceed max watchdog task, class=%{public}d, count=%{public}zu, quota=%{public}zu, "
+        "rejected=%{public}" PRIu64 "", static_cast<int>(taskClass), count, quota, rejected);
+}
+
+uint64_t WatchdogInner::GetRejectedTaskCount(WatchdogTaskClass taskClass) const
+{
+    size_t index = static_cast<size_t>(taskClass);
+    if (index >= static_cast<size_t>(WatchdogTaskClass::CLASS_NUM)) {
+        return 0;
+    }
+    return rejectedTaskNum_[index].load();
+}
+
 int64_t WatchdogInner::InsertWatchdogTaskLocked(const std::string& name, WatchdogTask&& task)
 {
     if (!task.isOneshotTask && IsTaskExistLocked(name)) {
@@ -1188,23 +1881,33 @@ int64_t WatchdogInner::InsertWatchdogTaskLocked(const std::string& name, Watchdo
         return 0;
     }
 
-    if (IsExceedMaxTaskLocked()) {
+    if (IsExceedMaxTaskLocked(task.taskClass)) {
         XCOLLIE_LOGE("Exceed max watchdog task, failed to insert.");
         return 0;
     }
     int64_t id = task.id;
+    bool isOneshotTask = task.isOneshotTask;
+    uint64_t nextTickTime = task.nextTickTime;
     checkerQueue_.push(std::move(task));
-    if (!task.isOneshotTask) {
+    if (!isOneshotTask) {
         taskNameSet_.insert(name);
     }
     CreateWatchdogThreadIfNeed();
-    if (task.nextTickTime < nextWeakUpTime_) {
+    if (nextTickTime < nextWeakUpTime_) {
         condition_.notify_all();
     }
 
     return id;
 }
 
+int64_t WatchdogInner::InsertXCollieTaskLocked(WatchdogTask&& task)
+{
+    // quota of XCollie timers is taken when they are submitted
+    int64_t id = task.id;
+    timerWheel_.Add(std::move(task), GetCurrentTickMillseconds());
+    return id;
+}
+
 void WatchdogInner::StopWatchdog()
 {
     Stop();
@@ -1333,7 +2036,7 @@ void WatchdogInner::CreateWatchdogThreadIfNeed()
             if (mainRunner_ == nullptr) {
                 mainRunner_ = AppExecFwk::EventRunner::GetMainEventRunner();
             }
-            mainRunner_->SetMainLooperWatcher(DistributeStart, DistributeEnd);
+            mainRunner_->SetMainLooperWatcher(MainLooperStart, MainLooperEnd);
             if (getuid() >= MIN_APP_UID) {
                 ReadAppStartConfig(APP_START_CONFIG);
             }
@@ -1423,55 +2126,208 @@ bool WatchdogInner::CheckCurrentTaskLocked(const WatchdogTask& queuedTaskCheck)
     return true;
 }
 
-uint64_t WatchdogInner::FetchNextTask(uint64_t now, WatchdogTask& task)
+void WatchdogInner::SetCurrentTaskScene(const std::string& name)
+{
+    // assign into the capacity reserved at construction, no allocation on the scheduler path
+    currentScene_.assign(TASK_SCENE_PREFIX).append(name).append("\n");
+}
+
+uint64_t WatchdogInner::FetchNextTask(uint64_t now, WatchdogTask*& task)
 {
     if (isNeedStop_) {
-        while (!checkerQueue_.empty()) {
-            checkerQueue_.pop();
-        }
+        ClearTasksLocked();
         return DEFAULT_TIMEOUT;
     }
 
+    DrainSubmitQueueLocked();
+    timerWheel_.Update(now);
+    if (timerWheel_.PopExpired(firedTimer_)) {
+        ReleaseXCollieTimerQuota(1);
+        SetCurrentTaskScene(firedTimer_.name);
+        task = &firedTimer_;
+        return 0;
+    }
+    uint64_t timerLeftTime = std::min(timerWheel_.NextTimeout(), DEFAULT_TIMEOUT);
+    if (!submitQueue_.Empty()) {
+        // a producer claimed a cell after the drain, come back shortly
+        timerLeftTime = std::min(timerLeftTime, SUBMIT_RETRY_INTERVAL);
+    }
+
     if (checkerQueue_.empty()) {
-        return DEFAULT_TIMEOUT;
+        return timerLeftTime;
     }
 
     const WatchdogTask& queuedTaskCheck = checkerQueue_.top();
     if (CheckCurrentTaskLocked(queuedTaskCheck) && checkerQueue_.empty()) {
-        return DEFAULT_TIMEOUT;
+        return timerLeftTime;
     }
 
     const WatchdogTask& queuedTask = checkerQueue_.top();
     if (queuedTask.nextTickTime > now) {
-        uint64_t leftTimeMill = queuedTask.nextTickTime - now;
-        if ((queuedTask.name == KICK_WATCHDOG_TASK) && (leftTimeMill > KICK_WATCHDOG_INTERVAL) && g_kickWatchdog) {
-            return KICK_WATCHDOG_INTERVAL;
-        }
-        return queuedTask.nextTickTime - now;
+        return std::min(GetCheckerLeftTimeLocked(now), timerLeftTime);
     }
-    currentScene_ = "thread DfxWatchdog: Current scenario is task name: " + queuedTask.name + "\n";
-    task = queuedTask;
-    checkerQueue_.pop();
+    SetCurrentTaskScene(queuedTask.name);
+    task = checkerQueue_.Acquire();
     return 0;
 }
 
-void WatchdogInner::ReInsertTaskIfNeed(WatchdogTask& task)
+void WatchdogInner::ClearTasksLocked()
+{
+    checkerQueue_.Clear();
+    timerCounters_.Clear();
+    ReleaseXCollieTimerQuota(timerWheel_.Size());
+    timerWheel_.Clear();
+}
+
+uint64_t WatchdogInner::GetCheckerLeftTimeLocked(uint64_t now)
+{
+    const WatchdogTask& queuedTask = checkerQueue_.top();
+    // sleep until the first task runs out of slack, every task due by then shares that wakeup
+    uint64_t leftTimeMill = checkerQueue_.EarliestDeadline() - now;
+    if ((queuedTask.name == KICK_WATCHDOG_TASK) && (leftTimeMill > KICK_WATCHDOG_INTERVAL) && g_kickWatchdog) {
+        leftTimeMill = KICK_WATCHDOG_INTERVAL;
+    }
+    return leftTimeMill;
+}
+
+uint64_t WatchdogInner::FetchDueTasksLocked(uint64_t now)
 {
-    if (task.checkInterval == 0) {
+    if (isNeedStop_) {
+        ClearTasksLocked();
+        return DEFAULT_TIMEOUT;
+    }
+
+    DrainSubmitQueueLocked();
+    timerWheel_.Update(now);
+    while (true) {
+        if (firedTimerNum_ == firedTimers_.size()) {
+            firedTimers_.emplace_back();
+        }
+        if (!timerWheel_.PopExpired(firedTimers_[firedTimerNum_])) {
+            break;
+        }
+        firedTimerNum_++;
+    }
+    ReleaseXCollieTimerQuota(firedTimerNum_);
+    uint64_t leftTimeMill = std::min(timerWheel_.NextTimeout(), DEFAULT_TIMEOUT);
+    if (!submitQueue_.Empty()) {
+        leftTimeMill = std::min(leftTimeMill, SUBMIT_RETRY_INTERVAL);
+    }
+
+    while (!checkerQueue_.empty()) {
+        const WatchdogTask& queuedTask = checkerQueue_.top();
+        if (CheckCurrentTaskLocked(queuedTask)) {
+            continue;
+        }
+        if (queuedTask.nextTickTime > now) {
+            leftTimeMill = std::min(leftTimeMill, GetCheckerLeftTimeLocked(now));
+            break;
+        }
+        WatchdogTask* task = checkerQueue_.Acquire();
+        if (task != nullptr) {
+            dueTasks_.push_back(task);
+        }
+    }
+    return (firedTimerNum_ > 0 || !dueTasks_.empty()) ? 0 : leftTimeMill;
+}
+
+void WatchdogInner::ReInsertTaskIfNeed(WatchdogTask* task)
+{
+    if (task == &firedTimer_) {
+        // release the callback of the fired timer, its arg may be freed by the caller
+        firedTimer_ = WatchdogTask();
         return;
     }
 
     std::lock_guard<std::mutex> lock(lock_);
-    if (taskNameSet_.find(task.name) == taskNameSet_.end()) {
-        XCOLLIE_LOGI("sample stack task %{public}s reach max count, skip reinsert", task.name.c_str());
+    dispatchLockCount_.fetch_add(1, std::memory_order_relaxed);
+    ReInsertTaskLocked(task);
+}
+
+void WatchdogInner::ReInsertTaskLocked(WatchdogTask* task)
+{
+    if (task->checkInterval == 0) {
+        checkerQueue_.Release(task);
+        return;
+    }
+    if (taskNameSet_.find(task->name) == taskNameSet_.end()) {
+        XCOLLIE_LOGI("sample stack task %{public}s reach max count, skip reinsert", task->name.c_str());
+        checkerQueue_.Release(task);
         return;
     }
 
-    task.nextTickTime = task.nextTickTime + task.checkInterval;
+    task->nextTickTime = task->nextTickTime + task->GetNextDelay();
 #ifdef SUSPEND_CHECK_ENABLE
-    CalculateTimes(task.bootTimeStart, task.monoTimeStart);
+    CalculateTimes(task->bootTimeStart, task->monoTimeStart);
 #endif
-    checkerQueue_.push(task);
+    checkerQueue_.Requeue(task);
+}
+
+void WatchdogInner::ReInsertDueTasksLocked()
+{
+    for (WatchdogTask* task : dueTasks_) {
+        ReInsertTaskLocked(task);
+    }
+    dueTasks_.clear();
+}
+
+void WatchdogInner::RunTask(WatchdogTask& task, uint64_t now)
+{
+    SetCurrentTaskScene(task.name);
+#ifdef SUSPEND_CHECK_ENABLE
+    if (!IsInSleep(task)) {
+#endif
+        uint64_t startUs = GetCurrentTickMicroseconds();
+        uint64_t expectUs = task.nextTickTime * TO_MILLISECOND_MULTPLE;
+        task.Run(now);
+        schedulerStats_.Record(task.taskClass, task.name, (startUs > expectUs) ? (startUs - expectUs) : 0,
+            GetCurrentTickMicroseconds() - startUs);
+#ifdef SUSPEND_CHECK_ENABLE
+    }
+#endif
+    currentScene_ = "thread DfxWatchdog: Current scenario is hicollie.\n";
+}
+
+uint64_t WatchdogInner::DispatchNextTask(uint64_t now)
+{
+    WatchdogTask* task = nullptr;
+    uint64_t leftTimeMill;
+    {
+        std::unique_lock<std::mutex> lock(lock_);
+        dispatchLockCount_.fetch_add(1, std::memory_order_relaxed);
+        ReInsertDueTasksLocked();
+        leftTimeMill = FetchNextTask(now, task);
+        nextWeakUpTime_ = now + leftTimeMill;
+    }
+    if (leftTimeMill != 0 || task == nullptr) {
+        return leftTimeMill;
+    }
+    RunTask(*task, now);
+    ReInsertTaskIfNeed(task);
+    return 0;
+}
+
+uint64_t WatchdogInner::DispatchDueTasks(uint64_t now)
+{
+    uint64_t leftTimeMill;
+    {
+        // hand back the previous batch and take the next one in the same critical section
+        std::unique_lock<std::mutex> lock(lock_);
+        dispatchLockCount_.fetch_add(1, std::memory_order_relaxed);
+        ReInsertDueTasksLocked();
+        leftTimeMill = FetchDueTasksLocked(now);
+        nextWeakUpTime_ = now + leftTimeMill;
+    }
+    for (size_t i = 0; i < firedTimerNum_; i++) {
+        RunTask(firedTimers_[i], now);
+        // release the callback of the fired timer, its arg may be freed by the caller
+        firedTimers_[i] = WatchdogTask();
+    }
+    firedTimerNum_ = 0;
+    for (WatchdogTask* task : dueTasks_) {
+        RunTask(*task, now);
+    }
+    return leftTimeMill;
 }
 
 bool WatchdogInner::Start()
@@ -1495,30 +2351,27 @@ bool WatchdogInner::Start()
         InitAsyncStackIfNeed();
 #endif
         uint64_t now = GetCurrentTickMillseconds();
-        WatchdogTask task;
-        uint64_t leftTimeMill;
-        {
-            std::unique_lock<std::mutex> lock(lock_);
-            leftTimeMill = FetchNextTask(now, task);
-            nextWeakUpTime_ = now + leftTimeMill;
-        }
+        uint64_t leftTimeMill = isBatchDispatch_ ? DispatchDueTasks(now) : DispatchNextTask(now);
         if (leftTimeMill == 0) {
-#ifdef SUSPEND_CHECK_ENABLE
-            if (!IsInSleep(task)) {
-#endif
-                task.Run(now);
-                currentScene_ = "thread DfxWatchdog: Current scenario is hicollie.\n";
-#ifdef SUSPEND_CHECK_ENABLE
-            }
-#endif
-            ReInsertTaskIfNeed(task);
             continue;
-        } else if (isNeedStop_) {
+        }
+        if (isNeedStop_) {
             break;
-        } else {
+        }
+        {
             std::unique_lock<std::mutex> lock(lock_);
+            dispatchLockCount_.fetch_add(1, std::memory_order_relaxed);
+            if (!submitQueue_.Empty()) {
+                // commands submitted after the fetch, their producers may skip the notify
+                leftTimeMill = std::min(leftTimeMill, SUBMIT_RETRY_INTERVAL);
+            }
             condition_.wait_for(lock, std::chrono::milliseconds(leftTimeMill));
         }
+        RecordWakeup(GetCurrentTickMillseconds());
+    }
+    {
+        std::unique_lock<std::mutex> lock(lock_);
+        ReInsertDueTasksLocked();
     }
     if (SetThreadInfoCallback != nullptr) {
         SetThreadInfoCallback(nullptr);
@@ -1526,6 +2379,73 @@ bool WatchdogInner::Start()
     return true;
 }
 
+void WatchdogInner::RecordWakeup(uint64_t now)
+{
+    uint64_t count = wakeupCount_.fetch_add(1, std::memory_order_relaxed) + 1;
+    if (wakeupWindowStart_ == 0) {
+        wakeupWindowStart_ = now;
+        wakeupWindowBase_ = count;
+        return;
+    }
+    uint64_t elapsed = now - wakeupWindowStart_;
+    if (elapsed < WAKEUP_RATE_WINDOW) {
+        return;
+    }
+    wakeupsPerMinute_.store((count - wakeupWindowBase_) * WAKEUP_RATE_WINDOW / elapsed, std::memory_order_relaxed);
+    wakeupWindowStart_ = now;
+    wakeupWindowBase_ = count;
+}
+
+uint64_t WatchdogInner::GetWakeupCount() const
+{
+    return wakeupCount_.load(std::memory_order_relaxed);
+}
+
+uint64_t WatchdogInner::GetWakeupsPerMinute() const
+{
+    return wakeupsPerMinute_.load(std::memory_order_relaxed);
+}
+
+std::string WatchdogInner::DumpSchedulerStats(bool isJson)
+{
+    WatchdogSchedulerStats::CounterList counters = {
+        {"wakeups", GetWakeupCount()},
+        {"wakeupsPerMinute", GetWakeupsPerMinute()},
+        {"dispatchLocks", dispatchLockCount_.load(std::memory_order_relaxed)},
+        {"xcollieTimers", xcollieTimerNum_.load(std::memory_order_relaxed)},
+        {"pendingReports", reportQueue_.Pending()},
+        {"overflowReports", reportQueue_.OverflowCount()},
+    };
+    for (size_t i = 0; i < static_cast<size_t>(WatchdogTaskClass::CLASS_NUM); i++) {
+        WatchdogTaskClass taskClass = static_cast<WatchdogTaskClass>(i);
+        counters.emplace_back(std::string("rejected.") + GetTaskClassName(taskClass), GetRejectedTaskCount(taskClass));
+    }
+    return schedulerStats_.Dump(isJson, counters);
+}
+
+std::string WatchdogInner::DumpProbeLatency(bool isJson)
+{
+    std::vector<std::pair<std::string, std::shared_ptr<HandlerChecker>>> checkers;
+    {
+        std::unique_lock<std::mutex> lock(lock_);
+        checkerQueue_.ForEach([&checkers](const WatchdogTask& task) {
+            if (task.checker != nullptr) {
+                checkers.emplace_back(task.name, task.checker);
+            }
+        });
+    }
+    uint64_t now = GetCurrentTickMicroseconds();
+    std::vector<WatchdogSchedulerStats::ProbeStats> probes;
+    for (const auto& [name, checker] : checkers) {
+        WatchdogSchedulerStats::ProbeStats probe;
+        probe.name = name;
+        probe.latency = checker->GetProbeLatency().GetSummary();
+        probe.pending = checker->GetPendingProbeTime(now);
+        probes.push_back(std::move(probe));
+    }
+    return WatchdogSchedulerStats::DumpProbes(isJson, probes);
+}
+
 bool WatchdogInner::SendMsgToHungtask(const std::string& msg)
 {
     if (g_fd == NOT_OPEN) {
@@ -1712,7 +2632,7 @@ void WatchdogInner::IsExistProcess(std::string description)
 {
     bool isTestExist = isTestExist_.load();
     if (!isTestExist) {
-        WatchdogInner::KillPeerBinderProcess(description);
+        WatchdogInner::GetInstance().PostKillPeerBinderProcess(description);
     }
 }
 
@@ -1748,7 +2668,8 @@ void WatchdogInner::InsertSampleStackTaskImpl(const std::string& sampleStackName
             WatchdogInner::GetInstance().taskNameSet_.erase(sampleStackName);
         }
     };
-    WatchdogInner::GetInstance().RunPeriodicalTask(sampleStackName, task, sampleInterval, sampleInterval);
+    WatchdogInner::GetInstance().RunPeriodicalTask(sampleStackName, task, sampleInterval, sampleInterval,
+        WatchdogTaskClass::INTERNAL_SAMPLING);
 }
 
 void WatchdogInner::InitFfrtWatchdog()
@@ -1778,37 +2699,43 @@ void WatchdogInner::SendFfrtEvent(const FfrtEventParam& param)
     delete[] buffer;
     int32_t tid = pid;
     GetFfrtTaskTid(tid, sendMsg);
-    pid_t watchdogTid = ParseTidFromInfo(std::string(param.taskInfo));
-    std::string kernelStack = "\n" + GetKernelStackByTid(watchdogTid);
+    std::string taskInfo(param.taskInfo == nullptr ? "" : param.taskInfo);
+    pid_t watchdogTid = ParseTidFromInfo(taskInfo);
     sendMsg += param.faultTimeStr;
-    std::string binderInfo;
-    if (param.eventName == "SERVICE_WARNING") {
-        std::string rawBinderInfo;
-        binderInfo = GetBinderInfoString(pid, tid, rawBinderInfo);
-        binderInfo = binderInfo.empty() ? rawBinderInfo : rawBinderInfo + "PROCESS_NAME:" + binderInfo;
-    }
+    // the ffrt dump above is the state at fault time, stacks and binder info are collected by the report thread
+    WatchdogInner::GetInstance().PostReport([pid, gid, uid, tid, watchdogTid, sendMsg, taskInfo,
+        eventName = param.eventName, msg = param.msg, isDumpStack = param.isDumpStack,
+        sampleStack = param.sampleStack] {
+        std::string kernelStack = "\n" + GetKernelStackByTid(watchdogTid);
+        std::string binderInfo;
+        if (eventName == "SERVICE_WARNING") {
+            std::string rawBinderInfo;
+            binderInfo = GetBinderInfoString(pid, tid, rawBinderInfo);
+            binderInfo = binderInfo.empty() ? rawBinderInfo : rawBinderInfo + "PROCESS_NAME:" + binderInfo;
+        }
 #ifdef HISYSEVENT_ENABLE
-    int ret = HiSysEventWrite(HiSysEvent::Domain::FRAMEWORK, param.eventName, HiSysEvent::EventType::FAULT,
-        "PID", pid, "TID", watchdogTid < 0 ? tid : watchdogTid, "TGID", gid, "UID", uid,
-        "MODULE_NAME", param.taskInfo, "PROCESS_NAME", GetSelfProcName(),
-        "MSG", sendMsg, "STACK", (param.isDumpStack ? GetProcessStacktrace() : "") + kernelStack,
-        "SAMPLE_STACK", param.sampleStack, "HICOLLIE_BINDER_INFO", binderInfo);
-    if (ret == ERR_OVER_SIZE) {
-        std::string stack = "";
-        if (param.isDumpStack) {
-            GetBacktraceStringByTid(stack, tid, 0, true);
-        }
-        ret = HiSysEventWrite(HiSysEvent::Domain::FRAMEWORK, param.eventName, HiSysEvent::EventType::FAULT, "PID", pid,
-            "TID", watchdogTid < 0 ? tid : watchdogTid, "TGID", gid, "UID", uid, "MODULE_NAME", param.taskInfo,
-            "PROCESS_NAME", GetSelfProcName(), "MSG", sendMsg, "STACK", stack + kernelStack,
-            "SAMPLE_STACK", param.sampleStack, "HICOLLIE_BINDER_INFO", binderInfo);
-    }
-
-    XCOLLIE_LOGI("hisysevent write result=%{public}d, send event [FRAMEWORK,%{public}s], "
-        "msg=%{public}s", ret, param.eventName.c_str(), param.msg.c_str());
+        int ret = HiSysEventWrite(HiSysEvent::Domain::FRAMEWORK, eventName, HiSysEvent::EventType::FAULT,
+            "PID", pid, "TID", watchdogTid < 0 ? tid : watchdogTid, "TGID", gid, "UID", uid,
+            "MODULE_NAME", taskInfo, "PROCESS_NAME", GetSelfProcName(),
+            "MSG", sendMsg, "STACK", (isDumpStack ? GetProcessStacktrace() : "") + kernelStack,
+            "SAMPLE_STACK", sampleStack, "HICOLLIE_BINDER_INFO", binderInfo);
+        if (ret == ERR_OVER_SIZE) {
+            std::string stack = "";
+            if (isDumpStack) {
+                GetBacktraceStringByTid(stack, tid, 0, true);
+            }
+            ret = HiSysEventWrite(HiSysEvent::Domain::FRAMEWORK, eventName, HiSysEvent::EventType::FAULT,
+                "PID", pid, "TID", watchdogTid < 0 ? tid : watchdogTid, "TGID", gid, "UID", uid,
+                "MODULE_NAME", taskInfo, "PROCESS_NAME", GetSelfProcName(), "MSG", sendMsg,
+                "STACK", stack + kernelStack, "SAMPLE_STACK", sampleStack, "HICOLLIE_BINDER_INFO", binderInfo);
+        }
+
+        XCOLLIE_LOGI("hisysevent write result=%{public}d, send event [FRAMEWORK,%{public}s], "
+            "msg=%{public}s", ret, eventName.c_str(), msg.c_str());
 #else
-    XCOLLIE_LOGI("hisysevent not exists");
+        XCOLLIE_LOGI("hisysevent not exists");
 #endif
+    });
 }
 
 void WatchdogInner::GetFfrtTaskTid(int32_t& tid, const std::string& msg)
@@ -1875,12 +2802,14 @@ bool WatchdogInner::Stop()
     if (mainRunner_ != nullptr) {
         mainRunner_->SetMainLooperWatcher(nullptr, nullptr);
     }
+    mainBeat_.load(std::memory_order_acquire)->SetAttached(false);
     isNeedStop_.store(true);
     condition_.notify_all();
     if (threadLoop_ != nullptr && threadLoop_->joinable()) {
         threadLoop_->join();
         threadLoop_ = nullptr;
     }
+    reportQueue_.Stop();
     if (g_fd != NOT_OPEN) {
         fdsan_close_with_tag(g_fd, LOG_DOMAIN);
         g_fd = NOT_OPEN;
@@ -1899,35 +2828,60 @@ void WatchdogInner::KillPeerBinderProcess(const std::string &description)
     }
 }
 
+void WatchdogInner::PostReport(ReportJob&& job)
+{
+    reportQueue_.Post(std::move(job));
+}
+
+void WatchdogInner::PostExitJob(ReportJob&& exitJob)
+{
+    PostReport([exitJob = std::move(exitJob)]() mutable {
+        std::thread exitThread(std::move(exitJob));
+        if (exitThread.joinable()) {
+            exitThread.detach();
+        }
+    });
+}
+
+void WatchdogInner::PostKillPeerBinderProcess(const std::string &description)
+{
+    PostExitJob([description] {
+        WatchdogInner::KillPeerBinderProcess(description);
+    });
+}
+
 bool WatchdogInner::RemoveInnerTask(const std::string& name)
 {
     if (name.empty()) {
         XCOLLIE_LOGI("RemoveInnerTask fail, cname is null");
         return false;
     }
-    std::priority_queue<WatchdogTask> tmpQueue;
+    if (isSupervised_.load(std::memory_order_acquire) && RemoveSupervisedHeartbeat(name)) {
+        return true;
+    }
     std::unique_lock<std::mutex> lock(lock_);
+    DrainSubmitQueueLocked();
     size_t size = checkerQueue_.size();
     if (size == 0) {
         XCOLLIE_LOGE("RemoveInnerTask %{public}s fail, empty queue!", name.c_str());
         return false;
     }
-    while (!checkerQueue_.empty()) {
-        const WatchdogTask& task = checkerQueue_.top();
+    size_t removed = checkerQueue_.RemoveIf([this, &name](const WatchdogTask& task) {
         if (task.name != name) {
-            tmpQueue.push(task);
-        } else {
-            size_t nameSize = taskNameSet_.size();
-            if (nameSize != 0 && !task.isOneshotTask) {
-                taskNameSet_.erase(name);
-                XCOLLIE_LOGI("RemoveInnerTask name %{public}s, remove result=%{public}d",
-                    name.c_str(), nameSize > taskNameSet_.size());
-            }
+            return false;
         }
-        checkerQueue_.pop();
-    }
-    tmpQueue.swap(checkerQueue_);
-    if (checkerQueue_.size() == size) {
+        if (task.timerCounter != nullptr) {
+            timerCounters_.Unregister(name);
+        }
+        size_t nameSize = taskNameSet_.size();
+        if (nameSize != 0 && !task.isOneshotTask) {
+            taskNameSet_.erase(name);
+            XCOLLIE_LOGI("RemoveInnerTask name %{public}s, remove result=%{public}d",
+                name.c_str(), nameSize > taskNameSet_.size());
+        }
+        return true;
+    });
+    if (removed == 0) {
         XCOLLIE_LOGE("RemoveInnerTask fail, can not find name %{public}s, size=%{public}zu!",
             name.c_str(), size);
         return false;
@@ -1982,13 +2936,18 @@ void WatchdogInner::InitMainLooperWatcher(WatchdogInnerBeginFunc* beginFunc,
         if (mainRunner_ != nullptr) {
             mainRunner_->SetMainLooperWatcher(nullptr, nullptr);
         }
+        // the main looper no longer beats, its heartbeat checks fall back to posted tasks
+        mainBeat_.load(std::memory_order_acquire)->SetAttached(false);
         *beginFunc = InitBeginFunc;
         *endFunc = InitEndFunc;
         InsertOrRemoveInfo(tid);
     } else {
         if (CheckBusinessByTid(tid)) {
             XCOLLIE_LOGI("Remove already init tid=%{public}." PRId64, tid);
-            mainRunner_->SetMainLooperWatcher(DistributeStart, DistributeEnd);
+            if (mainRunner_ != nullptr) {
+                mainRunner_->SetMainLooperWatcher(MainLooperStart, MainLooperEnd);
+            }
+            mainBeat_.load(std::memory_order_acquire)->SetAttached(true);
             InsertOrRemoveInfo(tid, true);
         }
     }
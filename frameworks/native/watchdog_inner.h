@@ -20,13 +20,21 @@
 #include <condition_variable>
 #include <csignal>
 #include <memory>
+#include <map>
 #include <mutex>
-#include <queue>
 #include <set>
 #include <string>
 #include <thread>
+#include <vector>
 
+#include "watchdog_report_queue.h"
+#include "watchdog_shared_region.h"
+#include "watchdog_stats.h"
+#include "watchdog_submit_queue.h"
 #include "watchdog_task.h"
+#include "watchdog_task_queue.h"
+#include "watchdog_timer_counter.h"
+#include "watchdog_timer_wheel.h"
 #include "c/ffrt_dump.h"
 #include "singleton.h"
 #include "client/trace_collector_client.h"
@@ -52,8 +60,30 @@ public:
     std::map<int64_t, int> taskIdCnt;
     int AddThread(const std::string &name, std::shared_ptr<AppExecFwk::EventHandler> handler,
         TimeOutCallback timeOutCallback, uint64_t interval, uint32_t priority = PRIORITY_IMMEDIATE);
+    // Check the looper by its heartbeat instead of a posted task, a null slot means the main looper.
+    int AddHeartbeatThread(const std::string &name, std::shared_ptr<AppExecFwk::EventHandler> handler,
+        std::shared_ptr<HeartbeatSlot> heartbeat, TimeOutCallback timeOutCallback, uint64_t interval);
+    // Check the looper less often while it is idle and faster while its probe is pending.
+    int AddAdaptiveThread(const std::string &name, std::shared_ptr<AppExecFwk::EventHandler> handler,
+        TimeOutCallback timeOutCallback, uint64_t interval);
+    // Post an immediate probe next to every probe of the named handler check, to classify its stalls.
+    bool SetProbeLadder(const std::string& name, bool isEnable);
     void RunOneShotTask(const std::string& name, Task&& task, uint64_t delay);
-    void RunPeriodicalTask(const std::string& name, Task&& task, uint64_t interval, uint64_t delay);
+    void RunPeriodicalTask(const std::string& name, Task&& task, uint64_t interval, uint64_t delay,
+        WatchdogTaskClass taskClass = WatchdogTaskClass::GENERAL_TASK);
+    uint64_t GetRejectedTaskCount(WatchdogTaskClass taskClass) const;
+    // Watchdog thread wakeups since start, and the rate over the last full minute.
+    uint64_t GetWakeupCount() const;
+    uint64_t GetWakeupsPerMinute() const;
+    // Lateness and run time histograms of the watchdog thread, as text or as json.
+    std::string DumpSchedulerStats(bool isJson);
+    // Post to run latency of the probes of every watched handler, as text or as json.
+    std::string DumpProbeLatency(bool isJson);
+    // Publish XCollie timers and the main looper heartbeat into a shared region for an out of process
+    // supervisor instead of the watchdog thread, return the region fd or -1.
+    int EnableSupervisedMode(uint32_t slotCount);
+    // Collect the evidence of a fault the supervisor found in slot, false if the slot has moved on.
+    bool HandleSupervisorFault(uint32_t slot, uint64_t generation, int waitState);
     int64_t RunXCollieTask(const std::string& name, uint64_t timeout, XCollieCallback func, void *arg,
         unsigned int flag);
     void RemoveXCollieTask(int64_t id);
@@ -77,9 +107,20 @@ public:
     static void SendFfrtEvent(const FfrtEventParam& param);
     static void LeftTimeExitProcess(const std::string &description);
     static void KillPeerBinderProcess(const std::string &description);
+    // Run job on the report thread, in order with the reports posted before it.
+    void PostReport(ReportJob&& job);
+    // Run exitJob on a thread of its own once the reports already posted have been written,
+    // so its wait before the exit does not hold up the reports posted after it.
+    void PostExitJob(ReportJob&& exitJob);
+    // Kill the process once the reports already posted have been written.
+    void PostKillPeerBinderProcess(const std::string &description);
     bool StartScrollProfile(const TimePoint& endTime, int64_t durationTime, int sampleInterval);
     void StartProfileMainThread(const TimePoint& endTime, int64_t durationTime, int sampleInterval);
     bool CollectStack(std::string& stack, std::string& heaviestStack, int treeFormat = ENABLE_TREE_FORMAT);
+    // Append the stacks to what stack and heaviestStack hold, left as they were on failure.
+    bool AppendStack(std::string& stack, std::string& heaviestStack, int treeFormat = ENABLE_TREE_FORMAT);
+    bool CollectStackRecord(std::string& record);
+    bool CollectStackProfile(int format, std::string& profile);
     bool Deinit();
     void SetBundleInfo(const std::string& bundleName, const std::string& bundleVersion);
     void SetSystemApp(bool isSystemApp);
@@ -102,11 +143,29 @@ public:
     std::string StopSample(int sampleCount);
     bool CheckSample(const TimePoint& endTime, int64_t durationTime);
     SamplerResult GetSamplerResult();
+    void SetSamplerWarmCache(bool isEnable);
+    void SetFreezeSampleRecord(bool isEnable);
+    bool SetFreezeSampleFormat(int format);
+    bool StartFlightRecorder(uint32_t sampleInterval = FLIGHT_RECORDER_DEFAULT_INTERVAL,
+        uint32_t window = FLIGHT_RECORDER_DEFAULT_WINDOW);
+    void StopFlightRecorder();
+    // The flight recorder stack in two steps, a cheap copy of the raw samples on the watchdog thread and their
+    // symbolization on the report thread.
+    std::string GetFlightRecorderSamples();
+    std::string SymbolizeFlightRecorderSamples(const std::string& samples);
+    // Symbolize samples on the report thread and append them to the log file at path.
+    void PostFlightRecorderStack(const std::string& path, std::string&& samples);
     int32_t GetReservedTimeForLogging();
 
 public:
     std::string currentScene_;
     TimePoint bussinessBeginTime_;
+    // the main looper beats here until EnableSupervisedMode moves it to a slot of the shared region
+    std::shared_ptr<HeartbeatSlot> localHeartbeat_ = std::make_shared<HeartbeatSlot>();
+    // owner of the slot the main looper beats into, only touched through std::atomic_load and std::atomic_store
+    std::shared_ptr<HeartbeatSlot> mainHeartbeat_ = localHeartbeat_;
+    // bumped by the main looper watcher without a lock, it stays valid since neither slot is ever freed
+    std::atomic<HeartbeatSlot*> mainBeat_ {localHeartbeat_.get()};
     TimeContent timeContent_ {0};
     StackContent stackContent_;
     TraceContent traceContent_;
@@ -122,14 +181,40 @@ private:
     bool Stop();
     static bool SendMsgToHungtask(const std::string& msg);
     bool IsTaskExistLocked(const std::string& name);
-    bool IsExceedMaxTaskLocked();
+    bool IsExceedMaxTaskLocked(WatchdogTaskClass taskClass);
+    bool AcquireXCollieTimerQuota();
+    void ReleaseXCollieTimerQuota(size_t count);
+    void RecordRejectedTask(WatchdogTaskClass taskClass, size_t count, size_t quota);
     int64_t InsertWatchdogTaskLocked(const std::string& name, WatchdogTask&& task);
+    int64_t InsertXCollieTaskLocked(WatchdogTask&& task);
+    void RemoveXCollieTaskLocked(int64_t id);
+    int64_t ArmSupervisedTimer(WatchdogTask&& task);
+    bool RemoveSupervisedTimer(int64_t id);
+    int AddSupervisedHeartbeat(WatchdogTask&& task);
+    bool RemoveSupervisedHeartbeat(const std::string& name);
+    bool HandleSupervisedTimer(uint32_t slot, uint64_t generation, std::unique_lock<std::mutex>& lock);
+    bool HandleSupervisedHeartbeat(uint32_t slot, uint64_t generation, int waitState,
+        std::unique_lock<std::mutex>& lock);
+    void SubmitTaskCommand(SubmitCommand&& command, uint64_t deadline);
+    void DrainSubmitQueueLocked();
+    void ApplySubmitCommandLocked(SubmitCommand& command);
 #ifdef SUSPEND_CHECK_ENABLE
     bool IsInSleep(const WatchdogTask& queuedTaskCheck);
 #endif
     bool CheckCurrentTaskLocked(const WatchdogTask& queuedTaskCheck);
-    uint64_t FetchNextTask(uint64_t now, WatchdogTask& task);
-    void ReInsertTaskIfNeed(WatchdogTask& task);
+    void SetCurrentTaskScene(const std::string& name);
+    uint64_t FetchNextTask(uint64_t now, WatchdogTask*& task);
+    void ReInsertTaskIfNeed(WatchdogTask* task);
+    void ClearTasksLocked();
+    uint64_t GetCheckerLeftTimeLocked(uint64_t now);
+    // Take every due timer and task in one critical section, return 0 if any was taken.
+    uint64_t FetchDueTasksLocked(uint64_t now);
+    void ReInsertTaskLocked(WatchdogTask* task);
+    void ReInsertDueTasksLocked();
+    void RunTask(WatchdogTask& task, uint64_t now);
+    uint64_t DispatchNextTask(uint64_t now);
+    uint64_t DispatchDueTasks(uint64_t now);
+    void RecordWakeup(uint64_t now);
     void CreateWatchdogThreadIfNeed();
     bool ReportMainThreadEvent(int64_t tid, std::string eventName, bool isScroll = false, bool appStart = false);
     bool CheckEventTimer(int64_t currentTime, int64_t reportBegin, int64_t reportEnd, int interval);
@@ -146,6 +231,7 @@ private:
     bool GetAutoStopSampling(const std::map<std::string, std::string>& paramsMap, int& autoStopSampling);
     bool CheckSampleParam(const std::map<std::string, std::string>& paramsMap, bool keyNeedExist = true);
     std::string SaveFreezeStackToFile(int32_t pid);
+    bool GetFreezeStackInfo(int32_t pid, std::string& info);
     bool AppStartSample(bool isScroll, AppStartContent& startContent);
     void ClearParam(bool& isFinished);
     void UpdateAppStartContent(const std::map<std::string, int64_t>& paramsMap, AppStartContent& startContent);
@@ -168,11 +254,43 @@ private:
     bool InstallThreadSamplerSignal();
     void UninstallThreadSamplerSignal();
     void ResetFreezeSampleFlags();
+    bool InitFlightRecorder(uint32_t sampleInterval, uint32_t window);
+    void ReleaseFlightRecorder();
     static void IsExistProcess(std::string description);
     int32_t GetMainThreadCheckTimer();
 
     static SigActionType threadSamplerSigHandler_;
-    std::priority_queue<WatchdogTask> checkerQueue_; // protected by lock_
+    static SigActionType flightSigHandler_; // the handler left installed between sessions
+    WatchdogTaskQueue checkerQueue_; // protected by lock_
+    WatchdogTimerWheel timerWheel_; // XCollie timers, protected by lock_
+    WatchdogSubmitQueue submitQueue_; // lock free producers, drained under lock_
+    TimerCounterRegistry timerCounters_; // XCollie::TriggerTimerCount counters by name
+    WatchdogSchedulerStats schedulerStats_; // recorded by the watchdog thread
+    WatchdogReportQueue reportQueue_; // evidence collection and event writes, off the watchdog thread
+    WatchdogTask firedTimer_; // expired XCollie timer being run, watchdog thread only
+    std::vector<WatchdogTask> firedTimers_; // expired XCollie timers of a batch, watchdog thread only
+    size_t firedTimerNum_ {0};
+    std::vector<WatchdogTask*> dueTasks_; // acquired tasks of a batch, watchdog thread only
+    std::atomic_bool isBatchDispatch_ {true};
+    struct SupervisedTask {
+        uint32_t slot;
+        uint64_t generation;
+        WatchdogTask task;
+    };
+    std::shared_ptr<WatchdogSharedRegion> sharedRegion_; // set once when supervised mode is enabled
+    std::atomic_bool isSupervised_ {false};
+    std::mutex supervisedLock_;
+    std::map<int64_t, SupervisedTask> supervisedTasks_; // by task id, protected by supervisedLock_
+    std::vector<int64_t> supervisedSlotIds_; // task id by slot, protected by supervisedLock_
+    uint32_t mainHeartbeatSlot_ {0};
+    uint64_t mainHeartbeatGeneration_ {0};
+    std::atomic<uint64_t> dispatchLockCount_ {0}; // lock_ acquisitions of the watchdog loop
+    std::atomic<size_t> xcollieTimerNum_ {0}; // armed and submitted XCollie timers
+    std::atomic<uint64_t> rejectedTaskNum_[static_cast<size_t>(WatchdogTaskClass::CLASS_NUM)] {};
+    std::atomic<uint64_t> wakeupCount_ {0};
+    std::atomic<uint64_t> wakeupsPerMinute_ {0};
+    uint64_t wakeupWindowStart_ {0}; // watchdog thread only
+    uint64_t wakeupWindowBase_ {0}; // watchdog thread only
     std::unique_ptr<std::thread> threadLoop_;
     std::mutex lock_;
     std::condition_variable condition_;
@@ -190,7 +308,17 @@ private:
     ThreadSamplerCollectFunc threadSamplerCollectFunc_ {nullptr};
     ThreadSamplerDeinitFunc threadSamplerDeinitFunc_ {nullptr};
     ThreadSamplerGetResultFunc threadSamplerGetResultFunc_ {nullptr};
+    ThreadSamplerCollectRecordFunc threadSamplerCollectRecordFunc_ {nullptr};
+    ThreadSamplerCollectProfileFunc threadSamplerCollectProfileFunc_ {nullptr};
+    ThreadSamplerCollectStreamFunc threadSamplerCollectStreamFunc_ {nullptr};
+    std::atomic_int freezeSampleFormat_ {FREEZE_SAMPLE_TEXT};
     SamplerResult samplerResult_ {0, 0, 0};
+    // holds libthread_sampler loaded between sessions while its warm cache is on
+    void* warmSamplerHandler_ {nullptr};
+    std::mutex warmSamplerLock_;
+    FlightRecorderContent flightContent_; // protected by flightRecorderLock_
+    std::atomic_bool isFlightRecorderOn_ {false};
+    std::mutex flightRecorderLock_;
     uint64_t watchdogStartTime_ {0};
     static std::mutex threadSamplerSignalMutex_;
 
@@ -213,7 +341,7 @@ private:
         .isBusinessJank = false,
     };
     std::string specifiedProcessName_;
-    uint64_t nextWeakUpTime_ {UINT64_MAX};
+    std::atomic<uint64_t> nextWeakUpTime_ {UINT64_MAX};
     AppStartContent startSlowContent_;
     AppStartContent scrollSlowContent_;
     SampleFreezeInfo sampleFreezeInfo_;
@@ -47,12 +47,18 @@ constexpr int DEFAULT_IGNORE_STARTUP_TIME = 10; // 10s
 constexpr int XCOLLIE_CALLBACK_HISTORY_MAX = 5;
 constexpr int XCOLLIE_CALLBACK_TIMEWIN_MAX = 60;
 constexpr unsigned int MAX_WATCH_NUM = 128; // 128: max handler thread
+constexpr unsigned int MAX_XCOLLIE_TIMER_NUM = 4096; // live XCollie timers, armed in the timing wheel
+constexpr unsigned int MAX_GENERAL_TASK_NUM = 256; // oneshot, periodical and timer count tasks
+constexpr unsigned int MAX_SAMPLING_TASK_NUM = 16; // internal stack, trace and freeze sampling tasks
 constexpr int XCOLLIE_TASK_MAX_CONCURRENCY_NUM = 1;
 constexpr int64_t APP_START_LIMIT = 7 * 24 * 60 * 60 * 1000; // 7 days
 constexpr int SET_TIMES_FLAG = 1;
 constexpr int ENABLE_TREE_FORMAT = 1;
 constexpr int DEFAULT_RESERVED_TIME = 3500; // 3.5s
 constexpr int BETA_RESERVED_TIME = 6000; // 6s
+constexpr uint32_t FLIGHT_RECORDER_MIN_INTERVAL = 50; // ms, at most 20 samples a second
+constexpr uint32_t FLIGHT_RECORDER_DEFAULT_INTERVAL = 100;
+constexpr uint32_t FLIGHT_RECORDER_DEFAULT_WINDOW = 5000; // ms
 
 using TimePoint = AppExecFwk::InnerEvent::TimePoint;
 
@@ -62,6 +68,15 @@ struct SamplerResult {
     int32_t samplerCount;
 };
 
+struct FlightRecorderStats {
+    uint64_t startTime;
+    uint64_t sampleCount;
+    uint64_t skippedCount;
+    uint64_t costTime;
+    uint64_t maxCostTime;
+    uint64_t memorySize;
+};
+
 typedef void (*WatchdogInnerBeginFunc)(const char* eventName);
 typedef void (*WatchdogInnerEndFunc)(const char* eventName);
 typedef int (*ThreadSamplerInitFunc)(size_t, int);
@@ -70,6 +85,17 @@ typedef int (*ThreadSamplerCollectFunc)(char*, char*, size_t, size_t, int);
 typedef int (*ThreadSamplerDeinitFunc)();
 typedef void (*SigActionType)(int, siginfo_t*, void*);
 typedef SamplerResult (*ThreadSamplerGetResultFunc)();
+typedef void (*ThreadSamplerSetWarmCacheFunc)(int);
+typedef int (*ThreadSamplerWriterFunc)(void*, int, const char*, size_t);
+typedef int (*ThreadSamplerCollectRecordFunc)(int, ThreadSamplerWriterFunc, void*);
+typedef int (*ThreadSamplerCollectProfileFunc)(int, int, ThreadSamplerWriterFunc, void*);
+typedef int (*ThreadSamplerCollectStreamFunc)(int, int, ThreadSamplerWriterFunc, void*);
+typedef int (*ThreadSamplerStartFlightRecorderFunc)(uint32_t, uint32_t, size_t, uint32_t);
+typedef int (*ThreadSamplerStopFlightRecorderFunc)();
+typedef int (*ThreadSamplerFlightSampleFunc)();
+typedef int (*ThreadSamplerCopyFlightSamplesFunc)(uint32_t, ThreadSamplerWriterFunc, void*);
+typedef int (*ThreadSamplerSymbolizeFlightSamplesFunc)(const char*, size_t, ThreadSamplerWriterFunc, void*);
+typedef FlightRecorderStats (*ThreadSamplerGetFlightRecorderStatsFunc)();
 
 struct TimeContent {
     int64_t curBegin;
@@ -109,10 +135,29 @@ struct AppStartContent {
     std::atomic_bool enableStartSample {false};
 };
 
+// Output of the freeze sample, the profiles are SampleProfileFormat of libthread_sampler plus FREEZE_SAMPLE_COLLAPSED.
+constexpr int FREEZE_SAMPLE_TEXT = 0;
+constexpr int FREEZE_SAMPLE_RECORD = 1;
+constexpr int FREEZE_SAMPLE_COLLAPSED = 2;
+constexpr int FREEZE_SAMPLE_PPROF = 3;
+
 struct SampleFreezeInfo {
     uint64_t lastSaveTime {0};
     std::string freezeFile;
     std::string currentFile;
+    int format {FREEZE_SAMPLE_TEXT}; // format of currentFile
+};
+
+// libthread_sampler pinned by the flight recorder, apart from the handle of the sampling sessions
+struct FlightRecorderContent {
+    void* handler {nullptr};
+    uint32_t window {0};
+    ThreadSamplerStartFlightRecorderFunc startFunc {nullptr};
+    ThreadSamplerStopFlightRecorderFunc stopFunc {nullptr};
+    ThreadSamplerFlightSampleFunc sampleFunc {nullptr};
+    ThreadSamplerCopyFlightSamplesFunc copySamplesFunc {nullptr};
+    ThreadSamplerSymbolizeFlightSamplesFunc symbolizeFunc {nullptr};
+    ThreadSamplerGetFlightRecorderStatsFunc getStatsFunc {nullptr};
 };
 
 struct SampleJankParams {
@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) 2026 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "watchdog_report_queue.h"
+
+#include <cerrno>
+#include <chrono>
+#include <pthread.h>
+#include <utility>
+
+#include "xcollie_utils.h"
+
+namespace OHOS {
+namespace HiviewDFX {
+WatchdogReportQueue::WatchdogReportQueue(size_t capacity) : capacity_(capacity)
+{
+}
+
+WatchdogReportQueue::~WatchdogReportQueue()
+{
+    Stop();
+}
+
+void WatchdogReportQueue::Post(ReportJob&& job)
+{
+    if (job == nullptr) {
+        return;
+    }
+    std::unique_lock<std::mutex> lock(lock_);
+    if (jobs_.size() >= capacity_) {
+        // running it here would overtake the queued reports, an exit job among them above all
+        overflowCount_++;
+        if (jobs_.size() == capacity_) {
+            XCOLLIE_LOGW("report queue is full, grow past %{public}zu reports", capacity_);
+        }
+    }
+    if (thread_ == nullptr) {
+        // first post, or the first one since Stop
+        isStopped_ = false;
+        generation_++;
+        thread_ = std::make_unique<std::thread>(&WatchdogReportQueue::Loop, this, generation_);
+    }
+    jobs_.push_back(std::move(job));
+    condition_.notify_all();
+}
+
+bool WatchdogReportQueue::Flush(uint64_t timeoutMs)
+{
+    std::unique_lock<std::mutex> lock(lock_);
+    return idleCondition_.wait_for(lock, std::chrono::milliseconds(timeoutMs),
+        [this] { return jobs_.empty() && runningNum_ == 0; });
+}
+
+void WatchdogReportQueue::Stop()
+{
+    std::unique_ptr<std::thread> thread;
+    {
+        std::unique_lock<std::mutex> lock(lock_);
+        isStopped_ = true;
+        thread = std::move(thread_);
+        condition_.notify_all();
+    }
+    if (thread == nullptr || !thread->joinable()) {
+        return;
+    }
+    if (thread->get_id() == std::this_thread::get_id()) {
+        // stopped from a report job, the loop exits once that job returns
+        thread->detach();
+        return;
+    }
+    thread->join();
+}
+
+size_t WatchdogReportQueue::Pending() const
+{
+    std::unique_lock<std::mutex> lock(lock_);
+    return jobs_.size() + runningNum_;
+}
+
+uint64_t WatchdogReportQueue::OverflowCount() const
+{
+    std::unique_lock<std::mutex> lock(lock_);
+    return overflowCount_;
+}
+
+void WatchdogReportQueue::Loop(uint64_t generation)
+{
+    if (pthread_setname_np(pthread_self(), "OS_DfxReport") != 0) {
+        XCOLLIE_LOGW("Failed to set threadName for report, errno:%d.", errno);
+    }
+    std::unique_lock<std::mutex> lock(lock_);
+    while (true) {
+        // a report thread started while the one stopped from a job still runs it waits for that job
+        condition_.wait(lock, [this, generation] {
+            return generation != generation_ || (runningNum_ == 0 && !jobs_.empty()) || isStopped_;
+        });
+        if (generation != generation_ || jobs_.empty()) {
+            break;
+        }
+        if (runningNum_ != 0) {
+            condition_.wait(lock, [this] { return runningNum_ == 0; });
+            continue;
+        }
+        ReportJob job = std::move(jobs_.front());
+        jobs_.pop_front();
+        runningNum_++;
+        lock.unlock();
+        job();
+        job = nullptr;
+        lock.lock();
+        runningNum_--;
+        condition_.notify_all();
+        if (jobs_.empty() && runningNum_ == 0) {
+            idleCondition_.notify_all();
+        }
+    }
+    idleCondition_.notify_all();
+}
+} // end of namespace HiviewDFX
+} // end of namespace OHOS
@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2026 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef RELIABILITY_WATCHDOG_REPORT_QUEUE_H
+#define RELIABILITY_WATCHDOG_REPORT_QUEUE_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace OHOS {
+namespace HiviewDFX {
+using ReportJob = std::function<void()>;
+
+/*
+ * FIFO of fault report jobs run by one OS_DfxReport thread, so stack capture, binder parsing
+ * and event writes never hold up the watchdog scheduler. Jobs always run in posting order,
+ * which lets a process exit be queued behind the reports it must not cut short. Past its
+ * capacity the queue grows and counts the overflow rather than block or reorder the poster.
+ */
+class WatchdogReportQueue {
+public:
+    explicit WatchdogReportQueue(size_t capacity);
+    ~WatchdogReportQueue();
+
+    void Post(ReportJob&& job);
+    // Wait until every job posted so far has run, return false on timeout.
+    bool Flush(uint64_t timeoutMs);
+    // Run the queued jobs, then join the report thread. A later post starts a new report thread.
+    void Stop();
+    size_t Pending() const;
+    uint64_t OverflowCount() const;
+
+private:
+    void Loop(uint64_t generation);
+
+    const size_t capacity_;
+    mutable std::mutex lock_;
+    std::condition_variable condition_;
+    std::condition_variable idleCondition_;
+    std::deque<ReportJob> jobs_;
+    std::unique_ptr<std::thread> thread_;
+    uint64_t generation_ {0}; // of the current report thread, an older one leaves the jobs to it
+    size_t runningNum_ {0};   // jobs being run, more than one report thread only across a restart
+    bool isStopped_ {false};
+    uint64_t overflowCount_ {0};
+};
+} // end of namespace HiviewDFX
+} // end of namespace OHOS
+#endif
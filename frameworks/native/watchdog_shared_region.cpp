@@ -0,0 +1,287 @@
+/*
+ * Copyright (c) 2026 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "watchdog_shared_region.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <new>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "xcollie_utils.h"
+
+namespace OHOS {
+namespace HiviewDFX {
+namespace {
+constexpr uint64_t STATE_MASK = (1ULL << WatchdogSharedRegion::SLOT_STATE_BITS) - 1;
+constexpr uint64_t FREE_INDEX_MASK = 0xffffffffULL;
+constexpr uint32_t FREE_TAG_SHIFT = 32;
+constexpr int READ_RETRY_TIMES = 3;
+constexpr size_t NAME_SIZE = SHARED_SLOT_NAME_WORDS * sizeof(uint64_t);
+}
+
+WatchdogSharedRegion::~WatchdogSharedRegion()
+{
+    if (base_ != nullptr) {
+        munmap(base_, size_);
+    }
+    if (fd_ >= 0) {
+        close(fd_);
+    }
+}
+
+uint64_t WatchdogSharedRegion::PackState(uint64_t generation, SharedSlotState state)
+{
+    return (generation << SLOT_STATE_BITS) | static_cast<uint64_t>(state);
+}
+
+bool WatchdogSharedRegion::Create(uint32_t slotCount)
+{
+    if (base_ != nullptr || slotCount == 0 || slotCount > SHARED_REGION_MAX_SLOTS) {
+        return false;
+    }
+    size_t size = sizeof(SharedRegionHeader) + sizeof(SharedTaskSlot) * slotCount;
+    int fd = memfd_create("xcollie_watchdog", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (fd < 0) {
+        XCOLLIE_LOGE("create shared region failed, errno:%{public}d", errno);
+        return false;
+    }
+    // the supervisor keeps its mapping, the region must never shrink under it
+    if (ftruncate(fd, static_cast<off_t>(size)) != 0 ||
+        fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) != 0 || !Map(fd, size)) {
+        XCOLLIE_LOGE("init shared region failed, errno:%{public}d", errno);
+        close(fd);
+        return false;
+    }
+    header_ = new (base_) SharedRegionHeader();
+    header_->magic = SHARED_REGION_MAGIC;
+    header_->version = SHARED_REGION_VERSION;
+    header_->headerSize = sizeof(SharedRegionHeader);
+    header_->slotSize = sizeof(SharedTaskSlot);
+    header_->slotCount = slotCount;
+    header_->pid = getprocpid();
+    slotCount_ = slotCount;
+    slots_ = reinterpret_cast<SharedTaskSlot*>(static_cast<char*>(base_) + sizeof(SharedRegionHeader));
+    freeNext_ = std::make_unique<std::atomic<uint32_t>[]>(slotCount);
+    for (uint32_t i = slotCount; i > 0; i--) {
+        new (&slots_[i - 1]) SharedTaskSlot();
+        PushFree(i - 1);
+    }
+    return true;
+}
+
+bool WatchdogSharedRegion::Attach(int fd)
+{
+    if (base_ != nullptr || fd < 0) {
+        return false;
+    }
+    int dupFd = fcntl(fd, F_DUPFD_CLOEXEC, 0);
+    if (dupFd < 0) {
+        return false;
+    }
+    struct stat st = {};
+    if (fstat(dupFd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(SharedRegionHeader)) ||
+        !Map(dupFd, static_cast<size_t>(st.st_size))) {
+        close(dupFd);
+        return false;
+    }
+    auto header = static_cast<SharedRegionHeader*>(base_);
+    size_t needSize = sizeof(SharedRegionHeader) + sizeof(SharedTaskSlot) * header->slotCount;
+    if (header->magic != SHARED_REGION_MAGIC || header->version != SHARED_REGION_VERSION ||
+        header->headerSize != sizeof(SharedRegionHeader) || header->slotSize != sizeof(SharedTaskSlot) ||
+        header->slotCount > SHARED_REGION_MAX_SLOTS || needSize > size_) {
+        XCOLLIE_LOGE("unknown shared region layout, version:%{public}u", header->version);
+        munmap(base_, size_);
+        base_ = nullptr;
+        close(dupFd);
+        fd_ = -1;
+        return false;
+    }
+    header_ = header;
+    slotCount_ = header->slotCount;
+    slots_ = reinterpret_cast<SharedTaskSlot*>(static_cast<char*>(base_) + sizeof(SharedRegionHeader));
+    return true;
+}
+
+bool WatchdogSharedRegion::Map(int fd, size_t size)
+{
+    void* base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) {
+        return false;
+    }
+    base_ = base;
+    size_ = size;
+    fd_ = fd;
+    return true;
+}
+
+int WatchdogSharedRegion::GetFd() const
+{
+    return fd_;
+}
+
+uint32_t WatchdogSharedRegion::GetSlotCount() const
+{
+    return slotCount_;
+}
+
+pid_t WatchdogSharedRegion::GetOwnerPid() const
+{
+    return (header_ != nullptr) ? header_->pid : -1;
+}
+
+int32_t WatchdogSharedRegion::Arm(SharedSlotKind kind, const std::string& name, uint64_t deadline,
+    uint64_t interval, uint64_t& generation)
+{
+    int32_t slot = Reserve(generation);
+    if (slot >= 0) {
+        Publish(static_cast<uint32_t>(slot), generation, kind, name, deadline, interval);
+    }
+    return slot;
+}
+
+int32_t WatchdogSharedRegion::Reserve(uint64_t& generation)
+{
+    int32_t slot = PopFree();
+    if (slot < 0) {
+        return -1;
+    }
+    SharedTaskSlot* taskSlot = GetSlot(static_cast<uint32_t>(slot));
+    generation = (taskSlot->state.load(std::memory_order_relaxed) >> SLOT_STATE_BITS) + 1;
+    taskSlot->state.store(PackState(generation, SLOT_FREE), std::memory_order_relaxed);
+    return slot;
+}
+
+void WatchdogSharedRegion::Publish(uint32_t slot, uint64_t generation, SharedSlotKind kind, const std::string& name,
+    uint64_t deadline, uint64_t interval)
+{
+    SharedTaskSlot* taskSlot = GetSlot(slot);
+    if (taskSlot == nullptr) {
+        return;
+    }
+    uint64_t words[SHARED_SLOT_NAME_WORDS] = {0};
+    if (memcpy_s(words, NAME_SIZE, name.c_str(), std::min(name.size(), NAME_SIZE)) != 0) {
+        XCOLLIE_LOGW("copy shared slot name failed");
+    }
+    for (size_t i = 0; i < SHARED_SLOT_NAME_WORDS; i++) {
+        taskSlot->name[i].store(words[i], std::memory_order_relaxed);
+    }
+    taskSlot->kind.store(static_cast<uint32_t>(kind), std::memory_order_relaxed);
+    taskSlot->deadline.store(deadline, std::memory_order_relaxed);
+    taskSlot->interval.store(interval, std::memory_order_relaxed);
+    taskSlot->state.store(PackState(generation, SLOT_ARMED), std::memory_order_release);
+}
+
+bool WatchdogSharedRegion::Release(uint32_t slot, uint64_t generation)
+{
+    return Free(slot, generation, SLOT_ARMED) || Free(slot, generation, SLOT_FIRED);
+}
+
+bool WatchdogSharedRegion::Finish(uint32_t slot, uint64_t generation)
+{
+    return Free(slot, generation, SLOT_HANDLING);
+}
+
+bool WatchdogSharedRegion::Free(uint32_t slot, uint64_t generation, SharedSlotState from)
+{
+    if (!Transit(slot, generation, from, SLOT_FREE)) {
+        return false;
+    }
+    PushFree(slot);
+    return true;
+}
+
+bool WatchdogSharedRegion::Transit(uint32_t slot, uint64_t generation, SharedSlotState from, SharedSlotState to)
+{
+    SharedTaskSlot* taskSlot = GetSlot(slot);
+    if (taskSlot == nullptr) {
+        return false;
+    }
+    uint64_t expected = PackState(generation, from);
+    return taskSlot->state.compare_exchange_strong(expected, PackState(generation, to), std::memory_order_acq_rel);
+}
+
+bool WatchdogSharedRegion::Read(uint32_t slot, SharedSlotSnapshot& snapshot) const
+{
+    SharedTaskSlot* taskSlot = GetSlot(slot);
+    if (taskSlot == nullptr) {
+        return false;
+    }
+    for (int i = 0; i < READ_RETRY_TIMES; i++) {
+        uint64_t state = taskSlot->state.load(std::memory_order_acquire);
+        uint64_t words[SHARED_SLOT_NAME_WORDS] = {0};
+        for (size_t j = 0; j < SHARED_SLOT_NAME_WORDS; j++) {
+            words[j] = taskSlot->name[j].load(std::memory_order_relaxed);
+        }
+        snapshot.kind = static_cast<SharedSlotKind>(taskSlot->kind.load(std::memory_order_relaxed));
+        snapshot.deadline = taskSlot->deadline.load(std::memory_order_relaxed);
+        snapshot.interval = taskSlot->interval.load(std::memory_order_relaxed);
+        snapshot.beats = taskSlot->heartbeat.GetBeats();
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (taskSlot->state.load(std::memory_order_relaxed) != state) {
+            continue;
+        }
+        snapshot.generation = state >> SLOT_STATE_BITS;
+        snapshot.state = static_cast<SharedSlotState>(state & STATE_MASK);
+        const char* name = reinterpret_cast<const char*>(words);
+        snapshot.name.assign(name, strnlen(name, NAME_SIZE));
+        return true;
+    }
+    return false;
+}
+
+HeartbeatSlot* WatchdogSharedRegion::GetHeartbeat(uint32_t slot)
+{
+    SharedTaskSlot* taskSlot = GetSlot(slot);
+    return (taskSlot != nullptr) ? &taskSlot->heartbeat : nullptr;
+}
+
+SharedTaskSlot* WatchdogSharedRegion::GetSlot(uint32_t slot) const
+{
+    return (slots_ != nullptr && slot < slotCount_) ? &slots_[slot] : nullptr;
+}
+
+void WatchdogSharedRegion::PushFree(uint32_t slot)
+{
+    uint64_t head = freeHead_.load(std::memory_order_relaxed);
+    uint64_t next;
+    do {
+        freeNext_[slot].store(static_cast<uint32_t>(head & FREE_INDEX_MASK), std::memory_order_relaxed);
+        next = (((head >> FREE_TAG_SHIFT) + 1) << FREE_TAG_SHIFT) | (slot + 1);
+    } while (!freeHead_.compare_exchange_weak(head, next, std::memory_order_release, std::memory_order_relaxed));
+}
+
+int32_t WatchdogSharedRegion::PopFree()
+{
+    if (freeNext_ == nullptr) {
+        return -1;
+    }
+    uint64_t head = freeHead_.load(std::memory_order_acquire);
+    uint64_t next;
+    do {
+        uint64_t index = head & FREE_INDEX_MASK;
+        if (index == 0) {
+            return -1;
+        }
+        next = (((head >> FREE_TAG_SHIFT) + 1) << FREE_TAG_SHIFT) |
+            freeNext_[index - 1].load(std::memory_order_relaxed);
+    } while (!freeHead_.compare_exchange_weak(head, next, std::memory_order_acquire, std::memory_order_acquire));
+    return static_cast<int32_t>((head & FREE_INDEX_MASK) - 1);
+}
+} // end of namespace HiviewDFX
+} // end of namespace OHOS
@@ -0,0 +1,143 @@
+/*
+ * Copyright (c) 2026 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef RELIABILITY_WATCHDOG_SHARED_REGION_H
+#define RELIABILITY_WATCHDOG_SHARED_REGION_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <sys/types.h>
+
+#include "watchdog_heartbeat.h"
+
+namespace OHOS {
+namespace HiviewDFX {
+constexpr uint32_t SHARED_REGION_MAGIC = 0x58435352; // "XCSR"
+constexpr uint32_t SHARED_REGION_VERSION = 1;
+constexpr uint32_t SHARED_REGION_MAX_SLOTS = 4096;
+constexpr size_t SHARED_SLOT_NAME_WORDS = 4;
+
+enum class SharedSlotKind : uint32_t {
+    NONE = 0,
+    TIMER, // fires once when deadline passes
+    HEARTBEAT, // blocked when heartbeat stays inside one event for interval
+};
+
+enum SharedSlotState : uint64_t {
+    SLOT_FREE = 0,
+    SLOT_ARMED = 1,
+    SLOT_FIRED = 2, // set by the supervisor, the owner has not handled it yet
+    SLOT_HANDLING = 3,
+};
+
+/*
+ * Layout of the region, shared by the owner process and the supervisor, so it only changes
+ * together with SHARED_REGION_VERSION. Every slot field is an atomic word, the state word
+ * carries a generation that changes on every reuse, a reader that sees the same state before
+ * and after reading the fields has read one consistent publication.
+ */
+struct alignas(64) SharedRegionHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t headerSize;
+    uint32_t slotSize;
+    uint32_t slotCount;
+    int32_t pid;
+};
+
+struct alignas(64) SharedTaskSlot {
+    std::atomic<uint64_t> state; // generation << SLOT_STATE_BITS | SharedSlotState
+    std::atomic<uint32_t> kind;
+    std::atomic<uint64_t> deadline; // CLOCK_MONOTONIC milliseconds, timers only
+    std::atomic<uint64_t> interval; // milliseconds, heartbeats only
+    std::atomic<uint64_t> name[SHARED_SLOT_NAME_WORDS];
+    HeartbeatSlot heartbeat;
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared region needs address free atomics");
+
+struct SharedSlotSnapshot {
+    uint64_t generation = 0;
+    SharedSlotState state = SLOT_FREE;
+    SharedSlotKind kind = SharedSlotKind::NONE;
+    uint64_t deadline = 0;
+    uint64_t interval = 0;
+    uint64_t beats = 0;
+    std::string name;
+};
+
+/*
+ * memfd backed table of task deadlines and heartbeat counters, published by the owner process
+ * for an out of process supervisor. The owner arms and releases slots without locks, the
+ * supervisor maps the same fd and only ever moves a slot from armed to fired.
+ */
+class WatchdogSharedRegion {
+public:
+    static constexpr uint32_t SLOT_STATE_BITS = 8;
+
+    WatchdogSharedRegion() = default;
+    ~WatchdogSharedRegion();
+    WatchdogSharedRegion(const WatchdogSharedRegion&) = delete;
+    WatchdogSharedRegion& operator=(const WatchdogSharedRegion&) = delete;
+
+    // Owner side, create and map a new region.
+    bool Create(uint32_t slotCount);
+    // Supervisor side, map the region behind fd, which is duplicated. Fails on an unknown layout.
+    bool Attach(int fd);
+    int GetFd() const;
+    uint32_t GetSlotCount() const;
+    pid_t GetOwnerPid() const;
+
+    // Take a free slot and publish it, return the slot index or -1 when the region is full.
+    int32_t Arm(SharedSlotKind kind, const std::string& name, uint64_t deadline, uint64_t interval,
+        uint64_t& generation);
+    // Take a free slot without publishing it, so its heartbeat can be handed out before Publish.
+    int32_t Reserve(uint64_t& generation);
+    void Publish(uint32_t slot, uint64_t generation, SharedSlotKind kind, const std::string& name,
+        uint64_t deadline, uint64_t interval);
+    // Free an armed or fired slot of that generation, return false if it is gone or being handled.
+    bool Release(uint32_t slot, uint64_t generation);
+    // Free a slot of that generation once its fault has been handled.
+    bool Finish(uint32_t slot, uint64_t generation);
+    // Move a slot of that generation between two states, return false if it is in another one.
+    bool Transit(uint32_t slot, uint64_t generation, SharedSlotState from, SharedSlotState to);
+    bool Read(uint32_t slot, SharedSlotSnapshot& snapshot) const;
+    HeartbeatSlot* GetHeartbeat(uint32_t slot);
+
+    static uint64_t PackState(uint64_t generation, SharedSlotState state);
+
+private:
+    bool Map(int fd, size_t size);
+    bool Free(uint32_t slot, uint64_t generation, SharedSlotState from);
+    SharedTaskSlot* GetSlot(uint32_t slot) const;
+    void PushFree(uint32_t slot);
+    int32_t PopFree();
+
+    int fd_ {-1};
+    void* base_ {nullptr};
+    size_t size_ {0};
+    SharedRegionHeader* header_ {nullptr};
+    SharedTaskSlot* slots_ {nullptr};
+    uint32_t slotCount_ {0};
+    // owner only, lock free stack of free slots, the head packs an ABA tag with index + 1
+    std::unique_ptr<std::atomic<uint32_t>[]> freeNext_;
+    std::atomic<uint64_t> freeHead_ {0};
+};
+} // end of namespace HiviewDFX
+} // end of namespace OHOS
+#endif
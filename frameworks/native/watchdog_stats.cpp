@@ -0,0 +1,237 @@
+/*
+ * Copyright (c) 2026 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "watchdog_stats.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <mutex>
+
+namespace OHOS {
+namespace HiviewDFX {
+namespace {
+constexpr size_t MAX_NAMED_STATS = 32;
+constexpr uint32_t HEX_DIGIT_MASK = 0xf;
+constexpr uint32_t HEX_HIGH_SHIFT = 4;
+constexpr unsigned char JSON_CONTROL_LIMIT = 0x20;
+constexpr size_t CLASS_NUM = static_cast<size_t>(WatchdogTaskClass::CLASS_NUM);
+
+void AppendJsonString(std::string& out, const std::string& value)
+{
+    static const char HEX[] = "0123456789abcdef";
+    out += '"';
+    for (unsigned char c : value) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += static_cast<char>(c);
+        } else if (c < JSON_CONTROL_LIMIT) {
+            out += "\\u00";
+            out += HEX[(c >> HEX_HIGH_SHIFT) & HEX_DIGIT_MASK];
+            out += HEX[c & HEX_DIGIT_MASK];
+        } else {
+            out += static_cast<char>(c);
+        }
+    }
+    out += '"';
+}
+
+void AppendSummaryText(std::string& out, const char* title, const LatencyHistogram::Summary& summary)
+{
+    char buf[256] = {0}; // 256: enough for seven 64-bit numbers
+    int len = snprintf(buf, sizeof(buf), " %s(us) count:%" PRIu64 " mean:%" PRIu64 " p50:%" PRIu64 " p90:%" PRIu64
+        " p99:%" PRIu64 " p999:%" PRIu64 " max:%" PRIu64, title, summary.count, summary.mean, summary.p50,
+        summary.p90, summary.p99, summary.p999, summary.max);
+    if (len > 0) {
+        out.append(buf, std::min(static_cast<size_t>(len), sizeof(buf) - 1));
+    }
+}
+
+void AppendSummaryJson(std::string& out, const char* title, const LatencyHistogram::Summary& summary)
+{
+    char buf[256] = {0}; // 256: enough for seven 64-bit numbers
+    int len = snprintf(buf, sizeof(buf), "\"%s\":{\"count\":%" PRIu64 ",\"mean\":%" PRIu64 ",\"p50\":%" PRIu64
+        ",\"p90\":%" PRIu64 ",\"p99\":%" PRIu64 ",\"p999\":%" PRIu64 ",\"max\":%" PRIu64 "}", title, summary.count,
+        summary.mean, summary.p50, summary.p90, summary.p99, summary.p999, summary.max);
+    if (len > 0) {
+        out.append(buf, std::min(static_cast<size_t>(len), sizeof(buf) - 1));
+    }
+}
+
+void AppendStatsJson(std::string& out, const TaskLatencyStats& stats)
+{
+    AppendSummaryJson(out, "lateness", stats.lateness.GetSummary());
+    out += ',';
+    AppendSummaryJson(out, "run", stats.runTime.GetSummary());
+}
+}
+
+const char* GetTaskClassName(WatchdogTaskClass taskClass)
+{
+    switch (taskClass) {
+        case WatchdogTaskClass::HANDLER_CHECK:
+            return "HANDLER_CHECK";
+        case WatchdogTaskClass::XCOLLIE_TIMER:
+            return "XCOLLIE_TIMER";
+        case WatchdogTaskClass::GENERAL_TASK:
+            return "GENERAL_TASK";
+        case WatchdogTaskClass::INTERNAL_SAMPLING:
+            return "INTERNAL_SAMPLING";
+        default:
+            return "UNKNOWN";
+    }
+}
+
+void WatchdogSchedulerStats::Record(WatchdogTaskClass taskClass, const std::string& name, uint64_t latenessUs,
+    uint64_t runTimeUs)
+{
+    size_t classIndex = static_cast<size_t>(taskClass);
+    if (classIndex >= CLASS_NUM) {
+        return;
+    }
+    classStats_[classIndex].lateness.Record(latenessUs);
+    classStats_[classIndex].runTime.Record(runTimeUs);
+    TaskLatencyStats* named = GetNamedStats(taskClass, name);
+    if (named == nullptr) {
+        untrackedRunNum_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    named->lateness.Record(latenessUs);
+    named->runTime.Record(runTimeUs);
+}
+
+TaskLatencyStats* WatchdogSchedulerStats::GetNamedStats(WatchdogTaskClass taskClass, const std::string& name)
+{
+    {
+        std::shared_lock<std::shared_mutex> lock(namedLock_);
+        auto it = namedStats_.find(name);
+        if (it != namedStats_.end()) {
+            return &it->second->stats;
+        }
+        if (namedStats_.size() >= MAX_NAMED_STATS) {
+            return nullptr;
+        }
+    }
+    // only the watchdog thread inserts, the name can not have been added meanwhile
+    auto entry = std::make_unique<NamedStats>();
+    entry->taskClass = taskClass;
+    TaskLatencyStats* stats = &entry->stats;
+    std::unique_lock<std::shared_mutex> lock(namedLock_);
+    namedStats_.emplace(name, std::move(entry));
+    return stats;
+}
+
+const TaskLatencyStats& WatchdogSchedulerStats::GetClassStats(WatchdogTaskClass taskClass) const
+{
+    size_t classIndex = std::min(static_cast<size_t>(taskClass), CLASS_NUM - 1);
+    return classStats_[classIndex];
+}
+
+bool WatchdogSchedulerStats::GetNamedSummary(const std::string& name, LatencyHistogram::Summary& lateness,
+    LatencyHistogram::Summary& runTime) const
+{
+    std::shared_lock<std::shared_mutex> lock(namedLock_);
+    auto it = namedStats_.find(name);
+    if (it == namedStats_.end()) {
+        return false;
+    }
+    lateness = it->second->stats.lateness.GetSummary();
+    runTime = it->second->stats.runTime.GetSummary();
+    return true;
+}
+
+std::string WatchdogSchedulerStats::Dump(bool isJson, const CounterList& counters) const
+{
+    return isJson ? DumpJson(counters) : DumpText(counters);
+}
+
+std::string WatchdogSchedulerStats::DumpText(const CounterList& counters) const
+{
+    std::string out = "watchdog scheduler stats:\n";
+    for (const auto& counter : counters) {
+        out += counter.first + ":" + std::to_string(counter.second) + "\n";
+    }
+    out += "untrackedRuns:" + std::to_string(untrackedRunNum_.load(std::memory_order_relaxed)) + "\n";
+    for (size_t i = 0; i < CLASS_NUM; i++) {
+        out += std::string("class ") + GetTaskClassName(static_cast<WatchdogTaskClass>(i));
+        AppendSummaryText(out, "lateness", classStats_[i].lateness.GetSummary());
+        AppendSummaryText(out, "run", classStats_[i].runTime.GetSummary());
+        out += "\n";
+    }
+    std::shared_lock<std::shared_mutex> lock(namedLock_);
+    for (const auto& named : namedStats_) {
+        out += "task " + named.first + " class:" + GetTaskClassName(named.second->taskClass);
+        AppendSummaryText(out, "lateness", named.second->stats.lateness.GetSummary());
+        AppendSummaryText(out, "run", named.second->stats.runTime.GetSummary());
+        out += "\n";
+    }
+    return out;
+}
+
+std::string WatchdogSchedulerStats::DumpJson(const CounterList& counters) const
+{
+    std::string out = "{\"unit\":\"us\",\"counters\":{";
+    for (const auto& counter : counters) {
+        AppendJsonString(out, counter.first);
+        out += ":" + std::to_string(counter.second) + ",";
+    }
+    out += "\"untrackedRuns\":" + std::to_string(untrackedRunNum_.load(std::memory_order_relaxed));
+    out += "},\"classes\":{";
+    for (size_t i = 0; i < CLASS_NUM; i++) {
+        out += (i == 0) ? "\"" : ",\"";
+        out += std::string(GetTaskClassName(static_cast<WatchdogTaskClass>(i))) + "\":{";
+        AppendStatsJson(out, classStats_[i]);
+        out += "}";
+    }
+    out += "},\"tasks\":[";
+    std::shared_lock<std::shared_mutex> lock(namedLock_);
+    bool isFirst = true;
+    for (const auto& named : namedStats_) {
+        out += isFirst ? "{\"name\":" : ",{\"name\":";
+        isFirst = false;
+        AppendJsonString(out, named.first);
+        out += std::string(",\"class\":\"") + GetTaskClassName(named.second->taskClass) + "\",";
+        AppendStatsJson(out, named.second->stats);
+        out += "}";
+    }
+    out += "]}";
+    return out;
+}
+
+std::string WatchdogSchedulerStats::DumpProbes(bool isJson, const std::vector<ProbeStats>& probes)
+{
+    std::string out = isJson ? "{\"unit\":\"us\",\"handlers\":[" : "watchdog probe latency:\n";
+    bool isFirst = true;
+    for (const auto& probe : probes) {
+        if (!isJson) {
+            out += "handler " + probe.name + " pending(us):" + std::to_string(probe.pending);
+            AppendSummaryText(out, "latency", probe.latency);
+            out += "\n";
+            continue;
+        }
+        out += isFirst ? "{\"name\":" : ",{\"name\":";
+        isFirst = false;
+        AppendJsonString(out, probe.name);
+        out += ",\"pending\":" + std::to_string(probe.pending) + ",";
+        AppendSummaryJson(out, "latency", probe.latency);
+        out += "}";
+    }
+    if (isJson) {
+        out += "]}";
+    }
+    return out;
+}
+} // end of namespace HiviewDFX
+} // end of namespace OHOS
@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2026 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef RELIABILITY_WATCHDOG_STATS_H
+#define RELIABILITY_WATCHDOG_STATS_H
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "watchdog_histogram.h"
+#include "watchdog_task.h"
+
+namespace OHOS {
+namespace HiviewDFX {
+struct TaskLatencyStats {
+    // how long after nextTickTime the task started, and how long its Run took
+    LatencyHistogram lateness;
+    LatencyHistogram runTime;
+};
+
+/*
+ * Scheduler health of the watchdog thread, kept per task class and per task name.
+ * Record is only called from the watchdog thread, Dump may be called from any thread.
+ */
+class WatchdogSchedulerStats {
+public:
+    using CounterList = std::vector<std::pair<std::string, uint64_t>>;
+    struct ProbeStats {
+        std::string name;
+        LatencyHistogram::Summary latency;
+        uint64_t pending = 0; // us the current probe has been waiting
+    };
+
+    void Record(WatchdogTaskClass taskClass, const std::string& name, uint64_t latenessUs, uint64_t runTimeUs);
+    const TaskLatencyStats& GetClassStats(WatchdogTaskClass taskClass) const;
+    // Return false when the name was never recorded or is not tracked.
+    bool GetNamedSummary(const std::string& name, LatencyHistogram::Summary& lateness,
+        LatencyHistogram::Summary& runTime) const;
+    // Render the histograms, preceded by the given counters, as text or as one json object.
+    std::string Dump(bool isJson, const CounterList& counters) const;
+    // Render the probe latency of watched handlers in the same forms.
+    static std::string DumpProbes(bool isJson, const std::vector<ProbeStats>& probes);
+
+private:
+    struct NamedStats {
+        WatchdogTaskClass taskClass;
+        TaskLatencyStats stats;
+    };
+
+    TaskLatencyStats* GetNamedStats(WatchdogTaskClass taskClass, const std::string& name);
+    std::string DumpText(const CounterList& counters) const;
+    std::string DumpJson(const CounterList& counters) const;
+
+    TaskLatencyStats classStats_[static_cast<size_t>(WatchdogTaskClass::CLASS_NUM)];
+    mutable std::shared_mutex namedLock_;
+    std::map<std::string, std::unique_ptr<NamedStats>> namedStats_;
+    std::atomic<uint64_t> untrackedRunNum_ {0};
+};
+
+const char* GetTaskClassName(WatchdogTaskClass taskClass);
+} // end of namespace HiviewDFX
+} // end of namespace OHOS
+#endif
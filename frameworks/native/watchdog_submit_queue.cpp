@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2026 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "watchdog_submit_queue.h"
+
+#include <thread>
+#include <utility>
+
+namespace OHOS {
+namespace HiviewDFX {
+namespace {
+uint32_t RoundUpPowerOfTwo(uint32_t value)
+{
+    uint32_t result = 1;
+    while (result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+}
+
+WatchdogSubmitQueue::WatchdogSubmitQueue(uint32_t capacity)
+{
+    uint32_t size = RoundUpPowerOfTwo(capacity);
+    cells_ = std::make_unique<Cell[]>(size);
+    for (uint32_t i = 0; i < size; i++) {
+        cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    mask_ = size - 1;
+}
+
+bool WatchdogSubmitQueue::Push(SubmitCommand&& command)
+{
+    uint64_t pos = enqueuePos_.load(std::memory_order_relaxed);
+    Cell* cell = nullptr;
+    while (true) {
+        cell = &cells_[pos & mask_];
+        uint64_t sequence = cell->sequence.load(std::memory_order_acquire);
+        int64_t diff = static_cast<int64_t>(sequence - pos);
+        if (diff == 0) {
+            if (enqueuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return false;
+        } else {
+            pos = enqueuePos_.load(std::memory_order_relaxed);
+        }
+    }
+    cell->command = std::move(command);
+    cell->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+}
+
+bool WatchdogSubmitQueue::Pop(SubmitCommand& command)
+{
+    if (Empty()) {
+        return false;
+    }
+    Cell& cell = cells_[dequeuePos_ & mask_];
+    // the cell is claimed, wait for its producer to publish rather than let later commands overtake it
+    while (cell.sequence.load(std::memory_order_acquire) != dequeuePos_ + 1) {
+        std::this_thread::yield();
+    }
+    command = std::move(cell.command);
+    cell.command.task = WatchdogTask();
+    cell.sequence.store(dequeuePos_ + mask_ + 1, std::memory_order_release);
+    dequeuePos_++;
+    return true;
+}
+
+bool WatchdogSubmitQueue::Empty() const
+{
+    return enqueuePos_.load(std::memory_order_acquire) == dequeuePos_;
+}
+} // end of namespace HiviewDFX
+} // end of namespace OHOS
@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2026 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef RELIABILITY_WATCHDOG_SUBMIT_QUEUE_H
+#define RELIABILITY_WATCHDOG_SUBMIT_QUEUE_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#include "watchdog_task.h"
+
+namespace OHOS {
+namespace HiviewDFX {
+enum class SubmitType : uint8_t {
+    ARM_TIMER,
+    CANCEL_TIMER,
+    ADD_PERIODICAL_TASK,
+};
+
+struct SubmitCommand {
+    SubmitType type {SubmitType::ARM_TIMER};
+    int64_t id {0};
+    WatchdogTask task;
+};
+
+/*
+ * Bounded multi-producer single-consumer ring of task commands. Producers claim a cell with
+ * one CAS and publish it with a release store, they never block. The consumer is whoever holds
+ * WatchdogInner::lock_, normally the watchdog thread draining before it picks the next deadline.
+ */
+class WatchdogSubmitQueue {
+public:
+    explicit WatchdogSubmitQueue(uint32_t capacity);
+    ~WatchdogSubmitQueue() = default;
+
+    // Return false when the ring is full, command is left untouched in that case.
+    bool Push(SubmitCommand&& command);
+    // Consumer side, return false when no cell is claimed. A claimed cell is waited for until its
+    // producer publishes it, so commands are always applied in claim order.
+    bool Pop(SubmitCommand& command);
+    // Consumer side, true when no cell has been claimed since the last Pop.
+    bool Empty() const;
+
+private:
+    struct Cell {
+        std::atomic<uint64_t> sequence {0};
+        SubmitCommand command;
+    };
+
+    std::unique_ptr<Cell[]> cells_;
+    uint64_t mask_;
+    alignas(64) std::atomic<uint64_t> enqueuePos_ {0};
+    alignas(64) uint64_t dequeuePos_ {0};
+};
+} // end of namespace HiviewDFX
+} // end of namespace OHOS
+#endif
@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) 2026 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "watchdog_supervisor.h"
+
+#include "handler_checker.h"
+#include "xcollie_utils.h"
+
+namespace OHOS {
+namespace HiviewDFX {
+namespace {
+constexpr uint64_t HALF_DIVISOR = 2;
+}
+
+pid_t WatchdogSupervisor::AddProcess(int fd)
+{
+    auto region = std::make_unique<WatchdogSharedRegion>();
+    if (!region->Attach(fd)) {
+        return -1;
+    }
+    pid_t pid = region->GetOwnerPid();
+    SupervisedProcess process;
+    process.region = std::move(region);
+    processes_[pid] = std::move(process);
+    XCOLLIE_LOGI("supervise process %{public}d, slots:%{public}u", pid, processes_[pid].region->GetSlotCount());
+    return pid;
+}
+
+void WatchdogSupervisor::RemoveProcess(pid_t pid)
+{
+    processes_.erase(pid);
+}
+
+size_t WatchdogSupervisor::GetProcessNum() const
+{
+    return processes_.size();
+}
+
+void WatchdogSupervisor::Scan(uint64_t now, std::vector<SupervisorFault>& faults)
+{
+    for (auto& [pid, process] : processes_) {
+        uint32_t slotCount = process.region->GetSlotCount();
+        for (uint32_t slot = 0; slot < slotCount; slot++) {
+            SharedSlotSnapshot snapshot;
+            if (!process.region->Read(slot, snapshot)) {
+                continue;
+            }
+            if (snapshot.state == SLOT_FREE) {
+                // a heartbeat published again starts a new stall record
+                process.beats.erase(slot);
+            }
+            if (snapshot.state != SLOT_ARMED) {
+                continue;
+            }
+            if (snapshot.kind == SharedSlotKind::TIMER) {
+                ScanTimer(process, slot, snapshot, now, faults);
+            } else if (snapshot.kind == SharedSlotKind::HEARTBEAT) {
+                ScanHeartbeat(process, slot, snapshot, now, faults);
+            }
+        }
+    }
+}
+
+void WatchdogSupervisor::ScanTimer(SupervisedProcess& process, uint32_t slot, const SharedSlotSnapshot& snapshot,
+    uint64_t now, std::vector<SupervisorFault>& faults)
+{
+    if (now < snapshot.deadline) {
+        return;
+    }
+    // losing the race to a release means the timer was cancelled in time
+    if (!process.region->Transit(slot, snapshot.generation, SLOT_ARMED, SLOT_FIRED)) {
+        return;
+    }
+    SupervisorFault fault;
+    fault.pid = process.region->GetOwnerPid();
+    fault.slot = slot;
+    fault.generation = snapshot.generation;
+    fault.kind = SharedSlotKind::TIMER;
+    fault.name = snapshot.name;
+    fault.overdue = now - snapshot.deadline;
+    faults.push_back(std::move(fault));
+}
+
+void WatchdogSupervisor::ScanHeartbeat(SupervisedProcess& process, uint32_t slot,
+    const SharedSlotSnapshot& snapshot, uint64_t now, std::vector<SupervisorFault>& faults)
+{
+    BeatRecord& record = process.beats[slot];
+    if (record.generation != snapshot.generation || record.beats != snapshot.beats) {
+        record.generation = snapshot.generation;
+        record.beats = snapshot.beats;
+        record.since = now;
+        record.reportedState = CheckStatus::COMPLETED;
+        return;
+    }
+    // only a looper stuck inside one event is visible from here, an idle looper does not beat either
+    if (!HeartbeatSlot::IsInEvent(snapshot.beats) || snapshot.interval == 0) {
+        return;
+    }
+    uint64_t stalled = now - record.since;
+    int waitState = CheckStatus::COMPLETED;
+    if (stalled >= snapshot.interval) {
+        waitState = CheckStatus::WAITING;
+    } else if (stalled >= snapshot.interval / HALF_DIVISOR) {
+        waitState = CheckStatus::WAITED_HALF;
+    }
+    if (waitState == CheckStatus::COMPLETED || waitState == record.reportedState) {
+        return;
+    }
+    record.reportedState = waitState;
+    SupervisorFault fault;
+    fault.pid = process.region->GetOwnerPid();
+    fault.slot = slot;
+    fault.generation = snapshot.generation;
+    fault.kind = SharedSlotKind::HEARTBEAT;
+    fault.waitState = waitState;
+    fault.name = snapshot.name;
+    fault.overdue = stalled;
+    faults.push_back(std::move(fault));
+}
+} // end of namespace HiviewDFX
+} // end of namespace OHOS
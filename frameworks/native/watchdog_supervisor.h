@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2026 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef RELIABILITY_WATCHDOG_SUPERVISOR_H
+#define RELIABILITY_WATCHDOG_SUPERVISOR_H
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "watchdog_shared_region.h"
+
+namespace OHOS {
+namespace HiviewDFX {
+struct SupervisorFault {
+    pid_t pid = 0;
+    uint32_t slot = 0;
+    uint64_t generation = 0;
+    SharedSlotKind kind = SharedSlotKind::NONE;
+    int waitState = 0; // CheckStatus of a heartbeat, 0 for a timer
+    std::string name;
+    uint64_t overdue = 0; // ms past the deadline, or ms the heartbeat has stayed in one event
+};
+
+/*
+ * Scanner of the shared regions of many processes, one thread of a supervisor daemon replaces
+ * the watchdog threads of all of them. A fault is only detected here, it is handed back to the
+ * owner, which collects the evidence through Watchdog::HandleSupervisorFault.
+ */
+class WatchdogSupervisor {
+public:
+    // Map the region behind fd, return the owner pid or -1.
+    pid_t AddProcess(int fd);
+    void RemoveProcess(pid_t pid);
+    size_t GetProcessNum() const;
+    // Fire every timer past its deadline and report every heartbeat stuck in one event, now is
+    // CLOCK_MONOTONIC milliseconds. A timer is reported once, a heartbeat once per stall level.
+    void Scan(uint64_t now, std::vector<SupervisorFault>& faults);
+
+private:
+    struct BeatRecord {
+        uint64_t generation = 0;
+        uint64_t beats = 0;
+        uint64_t since = 0; // when beats was first seen
+        int reportedState = 0;
+    };
+
+    struct SupervisedProcess {
+        std::unique_ptr<WatchdogSharedRegion> region;
+        std::map<uint32_t, BeatRecord> beats; // by slot
+    };
+
+    void ScanTimer(SupervisedProcess& process, uint32_t slot, const SharedSlotSnapshot& snapshot, uint64_t now,
+        std::vector<SupervisorFault>& faults);
+    void ScanHeartbeat(SupervisedProcess& process, uint32_t slot, const SharedSlotSnapshot& snapshot,
+        uint64_t now, std::vector<SupervisorFault>& faults);
+
+    std::map<pid_t, SupervisedProcess> processes_;
+};
+} // end of namespace HiviewDFX
+} // end of namespace OHOS
+#endif
@@ -15,6 +15,7 @@
 
 #include "watchdog_task.h"
 
+#include <algorithm>
 #include <charconv>
 #include <cinttypes>
 #include <ctime>
@@ -36,8 +37,13 @@
 namespace OHOS {
 namespace HiviewDFX {
 namespace {
-constexpr int COUNT_LIMIT_NUM_MAX_RATIO = 2;
 constexpr int TIME_LIMIT_NUM_MAX_RATIO = 2;
+constexpr uint64_t TASK_SLACK_DIVISOR = 10;
+constexpr uint64_t ADAPTIVE_IDLE_LATENCY_US = 1000;
+constexpr uint32_t ADAPTIVE_IDLE_ROUNDS = 3;
+constexpr uint64_t ADAPTIVE_MAX_BACKOFF = 2;
+constexpr uint64_t ADAPTIVE_RECHECK_DIVISOR = 4;
+constexpr uint64_t ADAPTIVE_MAX_RECHECK_MS = 500;
 constexpr int BINDER_SPACE_FULL_COUNT_HALF = 2;
 constexpr int UID_TYPE_THRESHOLD = 20000;
 constexpr int BINDER_SPACE_FULL_WARNING_MULTIPLE = 10;
@@ -58,15 +64,18 @@ constexpr size_t INT32_MAX_DIGITS = 10;
 constexpr int32_t DECIAML = 10;
 }
 
-int64_t WatchdogTask::curId = 0;
+std::atomic<int64_t> WatchdogTask::curId {0};
 
 WatchdogTask::WatchdogTask(std::string name, std::shared_ptr<AppExecFwk::EventHandler> handler,
-    TimeOutCallback timeOutCallback, uint64_t interval, AppExecFwk::EventQueue::Priority priority)
+    TimeOutCallback timeOutCallback, uint64_t interval, AppExecFwk::EventQueue::Priority priority,
+    std::shared_ptr<HeartbeatSlot> heartbeat)
     : name(name), task(nullptr), timeOutCallback(timeOutCallback), timeout(0), func(nullptr), arg(nullptr), flag(0),
       watchdogTid(0), timeLimit(0), countLimit(0), reportCount(0), binderSpaceFullCount(0)
 {
     id = ++curId;
-    checker = std::make_shared<HandlerChecker>(name, handler, priority);
+    taskClass = WatchdogTaskClass::HANDLER_CHECK;
+    checker = (heartbeat != nullptr) ? std::make_shared<HandlerChecker>(name, handler, heartbeat) :
+        std::make_shared<HandlerChecker>(name, handler, priority);
     checkInterval = interval;
     nextTickTime = GetCurrentTickMillseconds();
     isOneshotTask = false;
@@ -83,6 +92,7 @@ WatchdogTask::WatchdogTask(uint64_t interval, unsigned int count, IpcFullCallbac
       flag(flag), watchdogTid(0), timeLimit(0), countLimit(0), reportCount(0)
 {
     id = ++curId;
+    taskClass = WatchdogTaskClass::HANDLER_CHECK;
     checker = (count > 0) ? nullptr:std::make_shared<HandlerChecker>(IPC_FULL_TASK, nullptr);
     name = (count > 0) ? ASYNC_BINDER_SPACE_FULL_TASK : IPC_FULL_TASK;
     checkInterval = interval;
@@ -112,6 +122,7 @@ WatchdogTask::WatchdogTask(std::string name, unsigned int timeout, XCollieCallba
       arg(arg), flag(flag), timeLimit(0), countLimit(0), reportCount(0), binderSpaceFullCount(0)
 {
     id = ++curId;
+    taskClass = WatchdogTaskClass::XCOLLIE_TIMER;
     checkInterval = 0;
     nextTickTime = GetCurrentTickMillseconds() + timeout;
     isOneshotTask = true;
@@ -127,6 +138,7 @@ WatchdogTask::WatchdogTask(std::string name, unsigned int timeLimit, int countLi
       reportCount(0), binderSpaceFullCount(0)
 {
     id = ++curId;
+    timerCounter = std::make_shared<TimerCounter>(timeLimit, countLimit);
     checkInterval = timeLimit / TIME_LIMIT_NUM_MAX_RATIO;
     nextTickTime = GetCurrentTickMillseconds();
 #ifdef SUSPEND_CHECK_ENABLE
@@ -134,6 +146,11 @@ WatchdogTask::WatchdogTask(std::string name, unsigned int timeLimit, int countLi
 #endif
 }
 
+void WatchdogTask::AllowSlack()
+{
+    slack = isOneshotTask ? 0 : checkInterval / TASK_SLACK_DIVISOR;
+}
+
 bool ParseTid(const char* str, size_t len, pid_t& tid)
 {
     if (str == nullptr || len == 0 || len >= INT32_MAX_DIGITS) {
@@ -173,14 +190,12 @@ void WatchdogTask::DoCallback()
     if (flag & XCOLLIE_FLAG_RECOVERY) {
         XCOLLIE_LOGE("%{public}s blocked, after timeout %{public}llu ,process will exit", name.c_str(),
             static_cast<long long>(timeout));
-        alarm(LEFT_TIME_EXIT_ALARM_SECONDS);
-        std::thread exitFunc([] {
+        // the timeout event above is still queued, the exit and its alarm start once it is written
+        WatchdogInner::GetInstance().PostExitJob([] {
+            alarm(LEFT_TIME_EXIT_ALARM_SECONDS);
             std::string description = "timeout, exit...";
             WatchdogInner::LeftTimeExitProcess(description);
         });
-        if (exitFunc.joinable()) {
-            exitFunc.detach();
-        }
     }
 }
 
@@ -255,12 +270,12 @@ void WatchdogTask::AsyncBinderSpace()
             SendEvent(description, "BINDER_BUFFER_FULL", faultTimeStr);
         }
         if ((flag & XCOLLIE_FLAG_RECOVERY)||(func == nullptr)) {
-            WatchdogInner::KillPeerBinderProcess(description);
+            WatchdogInner::GetInstance().PostKillPeerBinderProcess(description);
         }
     } else if (reportCount >= binderSpaceFullCount * BINDER_SPACE_FULL_WARNING_MULTIPLE) {
         reportCount = 0;
         XCOLLIE_LOGE("async binder space full reach fullCount 10 ratio, reportCount reset to 0");
-        WatchdogInner::KillPeerBinderProcess(description);
+        WatchdogInner::GetInstance().PostKillPeerBinderProcess(description);
     }
 }
 
@@ -282,44 +297,69 @@ bool WatchdogTask::IsBinderSpaceInsufficient()
 #endif
 void WatchdogTask::TimerCountTask()
 {
-    int size = static_cast<int>(triggerTimes.size());
-    if (size < countLimit) {
+    uint64_t timeInterval = 0;
+    if (timerCounter == nullptr || !timerCounter->Check(timeInterval)) {
         return;
     }
-    XCOLLIE_LOGD("timeLimit : %{public}" PRIu64 ", countLimit : %{public}d, triggerTimes size : %{public}d",
-        timeLimit, countLimit, size);
-
-    while (size >= countLimit) {
-        uint64_t timeInterval = triggerTimes[size -1] - triggerTimes[size - countLimit];
-        if (timeInterval < timeLimit) {
-            std::string sendMsg = name + " occured " + std::to_string(countLimit) + " times in " +
-                std::to_string(timeInterval) + " ms, " + message;
+    XCOLLIE_LOGD("timeLimit : %{public}" PRIu64 ", countLimit : %{public}d, interval : %{public}" PRIu64,
+        timeLimit, countLimit, timeInterval);
+    std::string sendMsg = name + " occured " + std::to_string(countLimit) + " times in " +
+        std::to_string(timeInterval) + " ms, " + timerCounter->GetMessage();
 #ifdef HISYSEVENT_ENABLE
-            HiSysEventWrite(HiSysEvent::Domain::FRAMEWORK, name, HiSysEvent::EventType::FAULT,
-                "PID", getprocpid(), "PROCESS_NAME", GetSelfProcName(), "MSG", sendMsg);
+    HiSysEventWrite(HiSysEvent::Domain::FRAMEWORK, name, HiSysEvent::EventType::FAULT,
+        "PID", getprocpid(), "PROCESS_NAME", GetSelfProcName(), "MSG", sendMsg);
 #else
-            XCOLLIE_LOGI("hisysevent not exists");
+    XCOLLIE_LOGI("hisysevent not exists");
 #endif
-            triggerTimes.clear();
-            return;
-        }
-        size--;
-    }
-
-    if (triggerTimes.size() > static_cast<unsigned long>(countLimit * COUNT_LIMIT_NUM_MAX_RATIO)) {
-        triggerTimes.erase(triggerTimes.begin(), triggerTimes.end() - countLimit);
-    }
 }
 
 void WatchdogTask::RunHandlerCheckerTask()
 {
-    if (checker) {
+    if (checker && isAdaptive) {
+        RunAdaptiveCheckerTask();
+    } else if (checker) {
         EvaluateCheckerState();
         // While state is completed, check!
         checker->ScheduleCheck();
     }
 }
 
+void WatchdogTask::RunAdaptiveCheckerTask()
+{
+    uint64_t pending = checker->GetPendingProbeTime(GetCurrentTickMicroseconds()) / TO_MILLISECOND_MULTPLE;
+    if (pending == 0) {
+        if (blockedTime != 0) {
+            XCOLLIE_LOGI("%{public}s recovered, probe latency:%{public}" PRIu64 "us", name.c_str(),
+                checker->GetLastProbeLatency());
+            blockedTime = 0;
+            reportCount = 0;
+        }
+        // a block that starts after the last probe ran is only seen through the probe posted now,
+        // so the part of the delay to this check beyond checkInterval counts as pending time too
+        backoffWindow = GetNextDelay() - std::min(GetNextDelay(), checkInterval);
+        idleRounds = (checker->GetLastProbeLatency() <= ADAPTIVE_IDLE_LATENCY_US) ? (idleRounds + 1) : 0;
+        nextDelay = (idleRounds >= ADAPTIVE_IDLE_ROUNDS) ?
+            std::min(GetNextDelay() * 2, checkInterval * ADAPTIVE_MAX_BACKOFF) : checkInterval; // 2: double
+        checker->ScheduleCheck();
+        return;
+    }
+    idleRounds = 0;
+    nextDelay = std::max<uint64_t>(std::min(checkInterval / ADAPTIVE_RECHECK_DIVISOR, ADAPTIVE_MAX_RECHECK_MS), 1);
+    // one report per whole checkInterval of pending time, like a fixed check every checkInterval
+    pending += backoffWindow;
+    uint64_t level = pending / checkInterval;
+    if (level == 0 || level == blockedTime / checkInterval) {
+        return;
+    }
+    blockedTime = pending;
+    HandleCheckerState((level == 1) ? CheckStatus::WAITED_HALF : CheckStatus::WAITING);
+}
+
+uint64_t WatchdogTask::GetNextDelay() const
+{
+    return (nextDelay != 0) ? nextDelay : checkInterval;
+}
+
 void WatchdogTask::SendEvent(const std::string &msg, const std::string &eventName, const std::string& faultTimeStr)
 {
     int32_t pid = getprocpid();
@@ -337,12 +377,15 @@ void WatchdogTask::SendEvent(const std::string &msg, const std::string &eventNam
     watchdogTid = pid;
     ParseTidFromMsg(sendMsg);
 
-    std::string binderInfo;
+    std::string flightSamples;
     if (eventName == "SERVICE_WARNING") {
         InsertSampleStackTask();
-        std::string rawBinderInfo;
-        binderInfo = GetBinderInfoString(pid, watchdogTid, rawBinderInfo);
-        binderInfo = binderInfo.empty() ? rawBinderInfo : rawBinderInfo + "PROCESS_NAME:" + binderInfo;
+        // the main thread samples from before the warning, the block event brings the ones after it,
+        // only the raw pcs are copied here and the report thread symbolizes them
+        if (watchdogTid == pid) {
+            sampleStack.clear();
+            flightSamples = WatchdogInner::GetInstance().GetFlightRecorderSamples();
+        }
     } else if (eventName == "SERVICE_BLOCK") {
         std::string sampleStackName = name + "_sample_stack" + std::to_string(watchdogTid);
         sampleStack = SampleStackMap::GetInstance().GetAndRemove(sampleStackName);
@@ -350,7 +393,21 @@ void WatchdogTask::SendEvent(const std::string &msg, const std::string &eventNam
     }
 
     sendMsg += faultTimeStr;
-    SendHisyseventEvent({pid, gid, uid, sendMsg, eventName, binderInfo});
+    // only the state above is taken on the watchdog thread, binder info and stacks are collected by the report thread
+    HisyseventParam param {pid, gid, uid, watchdogTid, sendMsg, eventName, "", name, sampleStack};
+    bool needBinderInfo = (eventName == "SERVICE_WARNING");
+    WatchdogInner::GetInstance().PostReport([param = std::move(param), needBinderInfo,
+        flightSamples = std::move(flightSamples)]() mutable {
+        if (!flightSamples.empty()) {
+            param.sampleStack = WatchdogInner::GetInstance().SymbolizeFlightRecorderSamples(flightSamples);
+        }
+        if (needBinderInfo) {
+            std::string rawBinderInfo;
+            std::string binderInfo = GetBinderInfoString(param.pid, param.tid, rawBinderInfo);
+            param.binderInfo = binderInfo.empty() ? rawBinderInfo : rawBinderInfo + "PROCESS_NAME:" + binderInfo;
+        }
+        SendHisyseventEvent(param);
+    });
 }
 
 void WatchdogTask::ParseTidFromMsg(const std::string& sendMsg)
@@ -377,19 +434,20 @@ void WatchdogTask::SendHisyseventEvent(const HisyseventParam& param)
 {
 #ifdef HISYSEVENT_ENABLE
     std::string processName = GetSelfProcName();
-    std::string moduleName = (name == IPC_FULL_TASK) ? (processName + "_" + name) : name;
+    std::string moduleName = (param.taskName == IPC_FULL_TASK) ? (processName + "_" + param.taskName) :
+        param.taskName;
     std::string stackTrace = GetProcessStacktrace();
     int ret = HiSysEventWrite(HiSysEvent::Domain::FRAMEWORK, param.eventName, HiSysEvent::EventType::FAULT,
-        "PID", param.pid, "TID", watchdogTid, "TGID", param.gid, "UID", param.uid, "MODULE_NAME", moduleName,
+        "PID", param.pid, "TID", param.tid, "TGID", param.gid, "UID", param.uid, "MODULE_NAME", moduleName,
         "PROCESS_NAME", processName, "MSG", param.sendMsg, "STACK", stackTrace,
-        "SAMPLE_STACK", sampleStack, "HICOLLIE_BINDER_INFO", param.binderInfo);
+        "SAMPLE_STACK", param.sampleStack, "HICOLLIE_BINDER_INFO", param.binderInfo);
     if (ret == ERR_OVER_SIZE) {
         std::string stack;
-        GetBacktraceStringByTid(stack, watchdogTid, 0, true);
+        GetBacktraceStringByTid(stack, param.tid, 0, true);
         ret = HiSysEventWrite(HiSysEvent::Domain::FRAMEWORK, param.eventName, HiSysEvent::EventType::FAULT,
-            "PID", param.pid, "TID", watchdogTid, "TGID", param.gid, "UID", param.uid, "MODULE_NAME", moduleName,
+            "PID", param.pid, "TID", param.tid, "TGID", param.gid, "UID", param.uid, "MODULE_NAME", moduleName,
             "PROCESS_NAME", processName, "MSG", param.sendMsg, "STACK", stack,
-            "SAMPLE_STACK", sampleStack, "HICOLLIE_BINDER_INFO", param.binderInfo);
+            "SAMPLE_STACK", param.sampleStack, "HICOLLIE_BINDER_INFO", param.binderInfo);
     }
 
     XCOLLIE_LOGI("hisysevent write result=%{public}d, send event [FRAMEWORK,%{public}s], msg=%{public}s",
@@ -414,36 +472,42 @@ void WatchdogTask::SendXCollieEvent(const std::string &timerName, const std::str
     std::string sendMsg = std::string((timeStr == nullptr) ? "" : timeStr) + "\n" +
         "timeout timer: " + timerName + "\n" + keyMsg + faultTimeStr;
 
-    std::string eventName = "APP_HICOLLIE";
-    std::string stack;
-    std::string processName = GetSelfProcName();
-    if (uid <= UID_TYPE_THRESHOLD) {
-        eventName = (std::find(std::begin(CORE_PROCS), std::end(CORE_PROCS), processName) != std::end(CORE_PROCS) &&
-            (flag & XCOLLIE_FLAG_RECOVERY))
-            ? "SERVICE_TIMEOUT"
-            : "SERVICE_TIMEOUT_WARNING";
-        stack = GetProcessStacktrace();
-    } else if (!GetBacktraceStringByTid(stack, watchdogTid, 0, true)) {
-        XCOLLIE_LOGE("get tid:%{public}d BacktraceString failed", watchdogTid);
-    }
+    pid_t tid = watchdogTid;
+    std::string taskName = name;
+    unsigned int taskFlag = flag;
+    WatchdogInner::GetInstance().PostReport([pid, gid, uid, tid, sendMsg, timerName, keyMsg, taskName, taskFlag] {
+        std::string eventName = "APP_HICOLLIE";
+        std::string stack;
+        std::string processName = GetSelfProcName();
+        if (uid <= UID_TYPE_THRESHOLD) {
+            eventName = (std::find(std::begin(CORE_PROCS), std::end(CORE_PROCS), processName) !=
+                std::end(CORE_PROCS) && (taskFlag & XCOLLIE_FLAG_RECOVERY))
+                ? "SERVICE_TIMEOUT"
+                : "SERVICE_TIMEOUT_WARNING";
+            stack = GetProcessStacktrace();
+        } else if (!GetBacktraceStringByTid(stack, tid, 0, true)) {
+            XCOLLIE_LOGE("get tid:%{public}d BacktraceString failed", tid);
+        }
 
-    std::string binderInfo;
-    if (eventName == "SERVICE_TIMEOUT") {
-        std::string rawBinderInfo;
-        binderInfo = GetBinderInfoString(pid, watchdogTid, rawBinderInfo);
-        binderInfo = binderInfo.empty() ? rawBinderInfo : rawBinderInfo + "PROCESS_NAME:" + binderInfo;
-    }
+        std::string binderInfo;
+        if (eventName == "SERVICE_TIMEOUT") {
+            std::string rawBinderInfo;
+            binderInfo = GetBinderInfoString(pid, tid, rawBinderInfo);
+            binderInfo = binderInfo.empty() ? rawBinderInfo : rawBinderInfo + "PROCESS_NAME:" + binderInfo;
+        }
 
 #ifdef HISYSEVENT_ENABLE
-    int result = HiSysEventWrite(HiSysEvent::Domain::FRAMEWORK, eventName, HiSysEvent::EventType::FAULT, "PID", pid,
-        "TID", watchdogTid, "TGID", gid, "UID", uid, "MODULE_NAME", timerName, "PROCESS_NAME", processName,
-        "MSG", sendMsg, "STACK", stack + "\n"+ GetKernelStackByTid(watchdogTid), "SPECIFICSTACK_NAME",
-        WatchdogInner::GetInstance().GetSpecifiedProcessName(), "TASK_NAME", name, "HICOLLIE_BINDER_INFO", binderInfo);
-    XCOLLIE_LOGI("hisysevent write result=%{public}d, send event [FRAMEWORK,%{public}s], "
-        "msg=%{public}s", result, eventName.c_str(), keyMsg.c_str());
+        int result = HiSysEventWrite(HiSysEvent::Domain::FRAMEWORK, eventName, HiSysEvent::EventType::FAULT,
+            "PID", pid, "TID", tid, "TGID", gid, "UID", uid, "MODULE_NAME", timerName, "PROCESS_NAME", processName,
+            "MSG", sendMsg, "STACK", stack + "\n"+ GetKernelStackByTid(tid), "SPECIFICSTACK_NAME",
+            WatchdogInner::GetInstance().GetSpecifiedProcessName(), "TASK_NAME", taskName,
+            "HICOLLIE_BINDER_INFO", binderInfo);
+        XCOLLIE_LOGI("hisysevent write result=%{public}d, send event [FRAMEWORK,%{public}s], "
+            "msg=%{public}s", result, eventName.c_str(), keyMsg.c_str());
 #else
-    XCOLLIE_LOGI("hisysevent not exists");
+        XCOLLIE_LOGI("hisysevent not exists");
 #endif
+    });
 }
 
 void WatchdogTask::InsertSampleStackTask()
@@ -455,7 +519,11 @@ void WatchdogTask::InsertSampleStackTask()
 
 void WatchdogTask::EvaluateCheckerState()
 {
-    int waitState = checker->GetCheckState();
+    HandleCheckerState(checker->GetCheckState());
+}
+
+void WatchdogTask::HandleCheckerState(int waitState)
+{
     if (waitState == CheckStatus::COMPLETED) {
         reportCount = 0;
 #ifdef LOW_MEMORY_FREEZE_STRATEGY_ENABLE
@@ -477,7 +545,12 @@ void WatchdogTask::EvaluateCheckerState()
         timeOutCallback(name, waitState);
         return;
     }
-    std::string description = GetBlockDescription(checkInterval / TO_MILLISECOND_MULTPLE);
+    // an adaptive check knows how long its probe has waited, not just how often it checks
+    uint64_t blocked = (blockedTime != 0) ? blockedTime : checkInterval;
+    std::string description = GetBlockDescription(blocked / TO_MILLISECOND_MULTPLE);
+    if (blockedTime != 0) {
+        description += "\nBlocked time(ms) = " + std::to_string(blockedTime);
+    }
     if (waitState == CheckStatus::WAITED_HALF) {
         HandleWaitedHalfState(description, faultTimeStr);
     } else {
@@ -518,7 +591,7 @@ void WatchdogTask::HandleWaitedFullState(std::string &description, const std::st
             return;
         }
 #endif
-        WatchdogInner::KillPeerBinderProcess(description);
+        WatchdogInner::GetInstance().PostKillPeerBinderProcess(description);
     }
 }
 
@@ -16,12 +16,14 @@
 #ifndef RELIABILITY_WATCHDOG_TASK_H
 #define RELIABILITY_WATCHDOG_TASK_H
 
+#include <atomic>
 #include <functional>
 #include <string>
 #include <sys/types.h>
 
 #include "event_handler.h"
 #include "handler_checker.h"
+#include "watchdog_timer_counter.h"
 
 using Task = std::function<void()>;
 using TimeOutCallback = std::function<void(const std::string &name, int waitState)>;
@@ -29,20 +31,33 @@ using XCollieCallback = std::function<void (void *)>;
 using IpcFullCallback = std::function<void (void *)>;
 namespace OHOS {
 namespace HiviewDFX {
+// every class has its own quota so bursts of one kind can not crowd out the others
+enum class WatchdogTaskClass : uint8_t {
+    HANDLER_CHECK = 0,
+    XCOLLIE_TIMER,
+    GENERAL_TASK,
+    INTERNAL_SAMPLING,
+    CLASS_NUM,
+};
+
 class WatchdogTask {
-    static int64_t curId;
+    static std::atomic<int64_t> curId;
 public:
     struct HisyseventParam {
         int32_t pid;
         uint32_t gid;
         uint32_t uid;
+        pid_t tid;
         std::string sendMsg;
         std::string eventName;
         std::string binderInfo;
+        std::string taskName;
+        std::string sampleStack;
     };
 
     WatchdogTask(std::string name, std::shared_ptr<AppExecFwk::EventHandler> handler,
-        TimeOutCallback timeOutCallback, uint64_t interval, AppExecFwk::EventQueue::Priority priority);
+        TimeOutCallback timeOutCallback, uint64_t interval, AppExecFwk::EventQueue::Priority priority,
+        std::shared_ptr<HeartbeatSlot> heartbeat = nullptr);
     WatchdogTask(uint64_t interval, unsigned int count, IpcFullCallback func, void *arg, unsigned int flag);
     WatchdogTask(std::string name, Task&& task, uint64_t delay, uint64_t interval, bool isOneshot);
     WatchdogTask(std::string name, unsigned int timeout, XCollieCallback func, void *arg, unsigned int flag);
@@ -70,15 +85,24 @@ public:
           reportCount(0),
           binderSpaceFullCount(0) {};
     ~WatchdogTask() {};
+    WatchdogTask(const WatchdogTask&) = default;
+    WatchdogTask& operator=(const WatchdogTask&) = default;
+    WatchdogTask(WatchdogTask&&) = default;
+    WatchdogTask& operator=(WatchdogTask&&) = default;
 
     bool operator<(const WatchdogTask &obj) const
     {
-        // as we use std::priority_queue, the event with smaller target time will be in the top of the queue
+        // priority_queue order, the event with smaller target time is considered greater
         return (this->nextTickTime > obj.nextTickTime);
     }
 
+    // Let a periodical task run up to a tenth of its interval late, for tasks whose timing is not checked.
+    void AllowSlack();
     void Run(uint64_t now);
     void RunHandlerCheckerTask();
+    void RunAdaptiveCheckerTask();
+    // Delay until the next run of a periodical task.
+    uint64_t GetNextDelay() const;
     void SendEvent(const std::string &msg, const std::string &eventName, const std::string& faultTimeStr);
     void SendXCollieEvent(const std::string &timerName, const std::string &keyMsg,
         const std::string& faultTimeStr) const;
@@ -96,12 +120,14 @@ public:
     bool IsLowMemoryStatus();
 #endif
     void EvaluateCheckerState();
+    // Report a check result, also used for the results of an out of process supervisor.
+    void HandleCheckerState(int waitState);
     void HandleWaitedHalfState(std::string &description, const std::string &faultTimeStr);
     void HandleWaitedFullState(std::string &description, const std::string &faultTimeStr);
     std::string GetBlockDescription(uint64_t interval);
     void InsertSampleStackTask();
     void ParseTidFromMsg(const std::string& sendMsg);
-    void SendHisyseventEvent(const HisyseventParam& param);
+    static void SendHisyseventEvent(const HisyseventParam& param);
     std::string name;
     std::string message;
     Task task;
@@ -118,7 +144,7 @@ public:
     pid_t watchdogTid;
     uint64_t timeLimit;
     int countLimit;
-    std::vector<uint64_t> triggerTimes;
+    std::shared_ptr<TimerCounter> timerCounter;
 #ifdef SUSPEND_CHECK_ENABLE
     uint64_t bootTimeStart;
     uint64_t monoTimeStart;
@@ -132,6 +158,18 @@ public:
     bool hadSendEvent = false;
 #endif
     std::string sampleStack;
+    WatchdogTaskClass taskClass = WatchdogTaskClass::GENERAL_TASK;
+    // the task may run up to slack ms after nextTickTime so it can share a wakeup with its neighbours,
+    // 0 unless the task opts in with AllowSlack
+    uint64_t slack = 0;
+    // adaptive checks back off while the probe runs at once and re-check fast while it is pending,
+    // the warning and block thresholds are one and two checkInterval of pending time, less the
+    // backoff window so a backed off check reports no later than a check every checkInterval
+    bool isAdaptive = false;
+    uint32_t idleRounds = 0;
+    uint64_t nextDelay = 0; // 0 means checkInterval
+    uint64_t backoffWindow = 0; // ms the check before the pending probe was late by backing off
+    uint64_t blockedTime = 0; // ms pending time and backoff window when the last report was made
 };
 } // end of namespace HiviewDFX
 } // end of namespace OHOS
@@ -0,0 +1,279 @@
+/*
+ * Copyright (c) 2026 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "watchdog_task_queue.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace OHOS {
+namespace HiviewDFX {
+namespace {
+constexpr size_t HEAP_ARITY = 2;
+}
+
+void WatchdogTaskQueue::push(WatchdogTask&& task)
+{
+    uint32_t slot = AllocSlot(std::move(task));
+    PushEntry(slot);
+}
+
+void WatchdogTaskQueue::pop()
+{
+    if (heap_.empty()) {
+        return;
+    }
+    uint32_t slot = heap_.front().slot;
+    RemoveAt(0);
+    FreeSlot(slot);
+}
+
+const WatchdogTask& WatchdogTaskQueue::top() const
+{
+    return SlotAt(heap_.front().slot).task;
+}
+
+size_t WatchdogTaskQueue::size() const
+{
+    return heap_.size();
+}
+
+bool WatchdogTaskQueue::empty() const
+{
+    return heap_.empty();
+}
+
+WatchdogTask* WatchdogTaskQueue::Acquire()
+{
+    if (heap_.empty()) {
+        return nullptr;
+    }
+    HeapEntry top = heap_.front();
+    RemoveAt(0);
+    Slot& entry = SlotAt(top.slot);
+    if (entry.generation != top.generation) {
+        return nullptr;
+    }
+    entry.state = SlotState::RUNNING;
+    return &entry.task;
+}
+
+void WatchdogTaskQueue::Requeue(const WatchdogTask* task)
+{
+    uint32_t slot = 0;
+    if (!FindSlot(task, slot) || SlotAt(slot).state != SlotState::RUNNING) {
+        return;
+    }
+    PushEntry(slot);
+}
+
+void WatchdogTaskQueue::Release(const WatchdogTask* task)
+{
+    uint32_t slot = 0;
+    if (!FindSlot(task, slot) || SlotAt(slot).state != SlotState::RUNNING) {
+        return;
+    }
+    FreeSlot(slot);
+}
+
+WatchdogTask* WatchdogTaskQueue::Find(int64_t id)
+{
+    auto it = slotOfId_.find(id);
+    if (it == slotOfId_.end() || SlotAt(it->second).state != SlotState::QUEUED) {
+        return nullptr;
+    }
+    return &SlotAt(it->second).task;
+}
+
+bool WatchdogTaskQueue::Remove(int64_t id)
+{
+    auto it = slotOfId_.find(id);
+    if (it == slotOfId_.end()) {
+        return false;
+    }
+    uint32_t slot = it->second;
+    Slot& entry = SlotAt(slot);
+    if (entry.state != SlotState::QUEUED) {
+        // a running task is owned by the watchdog thread until it is requeued or released
+        return false;
+    }
+    RemoveAt(entry.heapPos);
+    FreeSlot(slot);
+    return true;
+}
+
+void WatchdogTaskQueue::Clear()
+{
+    for (const auto& entry : heap_) {
+        FreeSlot(entry.slot);
+    }
+    heap_.clear();
+}
+
+size_t WatchdogTaskQueue::Count(WatchdogTaskClass taskClass) const
+{
+    size_t index = static_cast<size_t>(taskClass);
+    return (index < static_cast<size_t>(WatchdogTaskClass::CLASS_NUM)) ? classCount_[index] : 0;
+}
+
+uint64_t WatchdogTaskQueue::EarliestDeadline() const
+{
+    uint64_t deadline = UINT64_MAX;
+    VisitDeadline(0, deadline);
+    return deadline;
+}
+
+WatchdogTaskQueue::Slot& WatchdogTaskQueue::SlotAt(uint32_t slot) const
+{
+    return chunks_[slot >> CHUNK_SHIFT][slot & (CHUNK_SIZE - 1)];
+}
+
+uint32_t WatchdogTaskQueue::AllocSlot(WatchdogTask&& task)
+{
+    if (freeSlots_.empty()) {
+        uint32_t base = static_cast<uint32_t>(chunks_.size()) << CHUNK_SHIFT;
+        chunks_.push_back(std::make_unique<Slot[]>(CHUNK_SIZE));
+        freeSlots_.reserve(chunks_.size() << CHUNK_SHIFT);
+        for (uint32_t i = CHUNK_SIZE; i > 0; i--) {
+            freeSlots_.push_back(base + i - 1);
+        }
+    }
+    uint32_t slot = freeSlots_.back();
+    freeSlots_.pop_back();
+    Slot& entry = SlotAt(slot);
+    entry.task = std::move(task);
+    entry.state = SlotState::QUEUED;
+    slotOfId_[entry.task.id] = slot;
+    classCount_[static_cast<size_t>(entry.task.taskClass)]++;
+    return slot;
+}
+
+void WatchdogTaskQueue::FreeSlot(uint32_t slot)
+{
+    Slot& entry = SlotAt(slot);
+    auto it = slotOfId_.find(entry.task.id);
+    if (it != slotOfId_.end() && it->second == slot) {
+        slotOfId_.erase(it);
+    }
+    classCount_[static_cast<size_t>(entry.task.taskClass)]--;
+    // drop the callbacks and their captures now, the slot itself is kept for reuse
+    entry.task = WatchdogTask();
+    entry.generation++;
+    entry.heapPos = INVALID_POS;
+    entry.state = SlotState::FREE;
+    freeSlots_.push_back(slot);
+}
+
+bool WatchdogTaskQueue::FindSlot(const WatchdogTask* task, uint32_t& slot) const
+{
+    if (task == nullptr) {
+        return false;
+    }
+    auto it = slotOfId_.find(task->id);
+    if (it == slotOfId_.end() || &SlotAt(it->second).task != task) {
+        return false;
+    }
+    slot = it->second;
+    return true;
+}
+
+void WatchdogTaskQueue::PushEntry(uint32_t slot)
+{
+    Slot& entry = SlotAt(slot);
+    entry.state = SlotState::QUEUED;
+    heap_.push_back({entry.task.nextTickTime, slot, entry.generation});
+    entry.heapPos = static_cast<uint32_t>(heap_.size() - 1);
+    SiftUp(heap_.size() - 1);
+}
+
+void WatchdogTaskQueue::Place(size_t pos, const HeapEntry& entry)
+{
+    heap_[pos] = entry;
+    SlotAt(entry.slot).heapPos = static_cast<uint32_t>(pos);
+}
+
+void WatchdogTaskQueue::SiftUp(size_t pos)
+{
+    HeapEntry entry = heap_[pos];
+    while (pos > 0) {
+        size_t parent = (pos - 1) / HEAP_ARITY;
+        if (heap_[parent].nextTickTime <= entry.nextTickTime) {
+            break;
+        }
+        Place(pos, heap_[parent]);
+        pos = parent;
+    }
+    Place(pos, entry);
+}
+
+void WatchdogTaskQueue::SiftDown(size_t pos)
+{
+    size_t size = heap_.size();
+    HeapEntry entry = heap_[pos];
+    while (true) {
+        size_t child = pos * HEAP_ARITY + 1;
+        if (child >= size) {
+            break;
+        }
+        if (child + 1 < size && heap_[child + 1].nextTickTime < heap_[child].nextTickTime) {
+            child++;
+        }
+        if (entry.nextTickTime <= heap_[child].nextTickTime) {
+            break;
+        }
+        Place(pos, heap_[child]);
+        pos = child;
+    }
+    Place(pos, entry);
+}
+
+void WatchdogTaskQueue::RemoveAt(size_t pos)
+{
+    size_t last = heap_.size() - 1;
+    SlotAt(heap_[pos].slot).heapPos = INVALID_POS;
+    if (pos != last) {
+        Place(pos, heap_[last]);
+    }
+    heap_.pop_back();
+    if (pos < heap_.size()) {
+        SiftDown(pos);
+        SiftUp(pos);
+    }
+}
+
+void WatchdogTaskQueue::VisitDeadline(size_t pos, uint64_t& deadline) const
+{
+    // a subtree that starts at or after the best deadline can not end before it
+    if (pos >= heap_.size() || heap_[pos].nextTickTime >= deadline) {
+        return;
+    }
+    uint64_t slack = SlotAt(heap_[pos].slot).task.slack;
+    uint64_t end = heap_[pos].nextTickTime + slack;
+    deadline = std::min(deadline, (end < slack) ? UINT64_MAX : end);
+    VisitDeadline(pos * HEAP_ARITY + 1, deadline);
+    VisitDeadline(pos * HEAP_ARITY + 2, deadline);
+}
+
+void WatchdogTaskQueue::Rebuild()
+{
+    for (size_t pos = 0; pos < heap_.size(); pos++) {
+        SlotAt(heap_[pos].slot).heapPos = static_cast<uint32_t>(pos);
+    }
+    for (size_t pos = heap_.size() / HEAP_ARITY; pos > 0; pos--) {
+        SiftDown(pos - 1);
+    }
+}
+} // end of namespace HiviewDFX
+} // end of namespace OHOS
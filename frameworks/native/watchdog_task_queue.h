@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2026 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef RELIABILITY_WATCHDOG_TASK_QUEUE_H
+#define RELIABILITY_WATCHDOG_TASK_QUEUE_H
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "watchdog_task.h"
+
+namespace OHOS {
+namespace HiviewDFX {
+/*
+ * Min-heap of watchdog tasks ordered by nextTickTime. Tasks live in a chunked slab with stable
+ * addresses, the heap only holds 16 byte {nextTickTime, slot, generation} entries and every slot
+ * knows its heap position, so removing a single task is O(log n) and never moves a task.
+ * A periodic task is acquired, run in place and requeued without being copied or reallocated.
+ * The push/pop/top/size/empty members keep the std::priority_queue shape used by the scheduler.
+ * Not thread safe, callers hold WatchdogInner::lock_.
+ */
+class WatchdogTaskQueue {
+public:
+    WatchdogTaskQueue() = default;
+    ~WatchdogTaskQueue() = default;
+
+    void push(WatchdogTask&& task);
+    void pop();
+    const WatchdogTask& top() const;
+    size_t size() const;
+    bool empty() const;
+
+    // Take the earliest task off the heap, it stays in its slot until Requeue or Release.
+    WatchdogTask* Acquire();
+    // Put an acquired task back on the heap at its current nextTickTime.
+    void Requeue(const WatchdogTask* task);
+    void Release(const WatchdogTask* task);
+    // Queued tasks only, a task being run is not visible until it is requeued.
+    WatchdogTask* Find(int64_t id);
+    bool Remove(int64_t id);
+    void Clear();
+    // Number of queued and running tasks of one class.
+    size_t Count(WatchdogTaskClass taskClass) const;
+    // Earliest nextTickTime + slack of the queued tasks, UINT64_MAX when empty.
+    uint64_t EarliestDeadline() const;
+
+    // Remove all queued tasks matching pred, return the number of removed tasks.
+    template <typename Pred>
+    size_t RemoveIf(Pred pred)
+    {
+        size_t kept = 0;
+        for (size_t pos = 0; pos < heap_.size(); pos++) {
+            uint32_t slot = heap_[pos].slot;
+            if (pred(static_cast<const WatchdogTask&>(SlotAt(slot).task))) {
+                FreeSlot(slot);
+                continue;
+            }
+            heap_[kept++] = heap_[pos];
+        }
+        size_t removed = heap_.size() - kept;
+        if (removed > 0) {
+            heap_.resize(kept);
+            Rebuild();
+        }
+        return removed;
+    }
+
+    // Visit every queued task in heap order, func must not change nextTickTime.
+    template <typename Func>
+    void ForEach(Func func)
+    {
+        for (const auto& entry : heap_) {
+            func(SlotAt(entry.slot).task);
+        }
+    }
+
+private:
+    static constexpr uint32_t CHUNK_SHIFT = 4;
+    static constexpr uint32_t CHUNK_SIZE = 1U << CHUNK_SHIFT;
+    static constexpr uint32_t INVALID_POS = UINT32_MAX;
+
+    enum class SlotState : uint8_t {
+        FREE,
+        QUEUED,
+        RUNNING,
+    };
+
+    struct Slot {
+        WatchdogTask task;
+        uint32_t generation {0};
+        uint32_t heapPos {INVALID_POS};
+        SlotState state {SlotState::FREE};
+    };
+
+    struct HeapEntry {
+        uint64_t nextTickTime;
+        uint32_t slot;
+        uint32_t generation;
+    };
+
+    Slot& SlotAt(uint32_t slot) const;
+    uint32_t AllocSlot(WatchdogTask&& task);
+    void FreeSlot(uint32_t slot);
+    bool FindSlot(const WatchdogTask* task, uint32_t& slot) const;
+    void PushEntry(uint32_t slot);
+    void Place(size_t pos, const HeapEntry& entry);
+    void SiftUp(size_t pos);
+    void SiftDown(size_t pos);
+    void RemoveAt(size_t pos);
+    void Rebuild();
+    void VisitDeadline(size_t pos, uint64_t& deadline) const;
+
+    std::vector<std::unique_ptr<Slot[]>> chunks_;
+    std::vector<uint32_t> freeSlots_;
+    std::vector<HeapEntry> heap_;
+    std::unordered_map<int64_t, uint32_t> slotOfId_;
+    size_t classCount_[static_cast<size_t>(WatchdogTaskClass::CLASS_NUM)] {};
+};
+} // end of namespace HiviewDFX
+} // end of namespace OHOS
+#endif
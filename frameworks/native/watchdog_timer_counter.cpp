@@ -0,0 +1,182 @@
+/*
+ * Copyright (c) 2026 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "watchdog_timer_counter.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace OHOS {
+namespace HiviewDFX {
+namespace {
+constexpr uint64_t COUNT_LIMIT_RING_RATIO = 2;
+constexpr uint64_t MAX_COUNT_LIMIT = 1ULL << 20;
+constexpr uint32_t TIME_BITS = 40;
+constexpr uint64_t TIME_MASK = (1ULL << TIME_BITS) - 1;
+constexpr uint64_t TAG_MASK = (1ULL << (64 - TIME_BITS)) - 1;
+constexpr size_t MAX_MESSAGE_COUNT = 16;
+
+uint64_t RoundUpPowerOfTwo(uint64_t value)
+{
+    uint64_t result = 1;
+    while (result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+
+// cell value of a published trigger, the tag is never 0 so a zeroed cell is never valid
+uint64_t PackCell(uint64_t pos, uint64_t time)
+{
+    return ((((pos + 1) & TAG_MASK) | 1) << TIME_BITS) | (time & TIME_MASK);
+}
+}
+
+TimerCounter::TimerCounter(uint64_t timeLimit, int countLimit)
+    : timeLimit_(timeLimit),
+      countLimit_(std::clamp<uint64_t>(static_cast<uint64_t>(std::max(countLimit, 1)), 1, MAX_COUNT_LIMIT))
+{
+    uint64_t size = RoundUpPowerOfTwo(countLimit_ * COUNT_LIMIT_RING_RATIO);
+    cells_ = std::make_unique<std::atomic<uint64_t>[]>(size);
+    for (uint64_t i = 0; i < size; i++) {
+        cells_[i].store(0, std::memory_order_relaxed);
+    }
+    mask_ = size - 1;
+}
+
+void TimerCounter::Trigger(uint64_t now, const std::string& message)
+{
+    uint64_t pos = head_.fetch_add(1, std::memory_order_relaxed);
+    cells_[pos & mask_].store(PackCell(pos, now), std::memory_order_release);
+    const std::string* current = message_.load(std::memory_order_acquire);
+    if (current == nullptr || *current != message) {
+        UpdateMessage(message);
+    }
+}
+
+void TimerCounter::Reset()
+{
+    MoveStartTo(head_.load(std::memory_order_acquire));
+}
+
+bool TimerCounter::Check(uint64_t& interval)
+{
+    uint64_t head = head_.load(std::memory_order_acquire);
+    uint64_t begin = std::max(start_.load(std::memory_order_acquire), (head > mask_) ? head - mask_ - 1 : 0);
+    if (head - begin < countLimit_) {
+        return false;
+    }
+    // only windows ending after the last check can be new, older ones were already too wide
+    uint64_t firstEnd = std::max(begin + countLimit_ - 1, checkedPos_);
+    uint64_t pending = head;
+    for (uint64_t end = head; end > firstEnd; end--) {
+        uint64_t last = 0;
+        uint64_t first = 0;
+        if (!Load(end - 1, last) || !Load(end - countLimit_, first)) {
+            // still being written, look at this window again next time
+            pending = end - 1;
+            continue;
+        }
+        if (last >= first && last - first < timeLimit_) {
+            interval = last - first;
+            MoveStartTo(head);
+            checkedPos_ = head;
+            return true;
+        }
+    }
+    checkedPos_ = pending;
+    return false;
+}
+
+std::string TimerCounter::GetMessage() const
+{
+    const std::string* current = message_.load(std::memory_order_acquire);
+    return (current == nullptr) ? "" : *current;
+}
+
+uint32_t TimerCounter::Capacity() const
+{
+    return static_cast<uint32_t>(mask_ + 1);
+}
+
+bool TimerCounter::Load(uint64_t pos, uint64_t& time) const
+{
+    uint64_t value = cells_[pos & mask_].load(std::memory_order_acquire);
+    if (value != PackCell(pos, value & TIME_MASK)) {
+        return false;
+    }
+    time = value & TIME_MASK;
+    return true;
+}
+
+void TimerCounter::MoveStartTo(uint64_t pos)
+{
+    uint64_t start = start_.load(std::memory_order_relaxed);
+    while (start < pos && !start_.compare_exchange_weak(start, pos, std::memory_order_release)) {
+    }
+}
+
+void TimerCounter::UpdateMessage(const std::string& message)
+{
+    std::lock_guard<std::mutex> lock(messageLock_);
+    auto it = std::find(messages_.begin(), messages_.end(), message);
+    if (it != messages_.end()) {
+        message_.store(&*it, std::memory_order_release);
+        return;
+    }
+    if (messages_.size() >= MAX_MESSAGE_COUNT) {
+        // callers pass a handful of fixed texts, keep the last interned one instead of growing
+        message_.store(&messages_.back(), std::memory_order_release);
+        return;
+    }
+    messages_.push_back(message);
+    message_.store(&messages_.back(), std::memory_order_release);
+}
+
+bool TimerCounterRegistry::Register(const std::string& name, std::shared_ptr<TimerCounter> counter)
+{
+    std::unique_lock<std::shared_mutex> lock(lock_);
+    return counters_.emplace(name, std::move(counter)).second;
+}
+
+void TimerCounterRegistry::Unregister(const std::string& name)
+{
+    std::unique_lock<std::shared_mutex> lock(lock_);
+    counters_.erase(name);
+}
+
+bool TimerCounterRegistry::Trigger(const std::string& name, bool bTrigger, uint64_t now,
+    const std::string& message)
+{
+    std::shared_lock<std::shared_mutex> lock(lock_);
+    auto it = counters_.find(name);
+    if (it == counters_.end()) {
+        return false;
+    }
+    if (bTrigger) {
+        it->second->Trigger(now, message);
+    } else {
+        it->second->Reset();
+    }
+    return true;
+}
+
+void TimerCounterRegistry::Clear()
+{
+    std::unique_lock<std::shared_mutex> lock(lock_);
+    counters_.clear();
+}
+} // end of namespace HiviewDFX
+} // end of namespace OHOS
@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2026 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef RELIABILITY_WATCHDOG_TIMER_COUNTER_H
+#define RELIABILITY_WATCHDOG_TIMER_COUNTER_H
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+namespace OHOS {
+namespace HiviewDFX {
+/*
+ * Trigger timestamps of one XCollie::TriggerTimerCount counter in a fixed size ring.
+ * Every cell packs the low bits of its ring position with the timestamp in one word, so a
+ * trigger is a fetch_add plus a store and a reader can tell a published cell from a stale one.
+ * Messages are interned once per distinct text, a trigger repeating the current message only
+ * compares it, messageLock_ is taken only when a caller passes a text not seen before.
+ * Trigger and Reset may be called from any thread, Check only from the watchdog thread.
+ */
+class TimerCounter {
+public:
+    TimerCounter(uint64_t timeLimit, int countLimit);
+    ~TimerCounter() = default;
+
+    void Trigger(uint64_t now, const std::string& message);
+    // Forget every trigger recorded so far.
+    void Reset();
+    // Return true when countLimit triggers recorded since the last check fall within timeLimit,
+    // interval is the span of that window and the counter is reset.
+    bool Check(uint64_t& interval);
+    std::string GetMessage() const;
+    uint32_t Capacity() const;
+
+private:
+    bool Load(uint64_t pos, uint64_t& time) const;
+    void MoveStartTo(uint64_t pos);
+    void UpdateMessage(const std::string& message);
+
+    uint64_t timeLimit_;
+    uint64_t countLimit_;
+    uint64_t mask_;
+    std::unique_ptr<std::atomic<uint64_t>[]> cells_;
+    alignas(64) std::atomic<uint64_t> head_ {0};
+    std::atomic<uint64_t> start_ {0};
+    uint64_t checkedPos_ {0};
+    std::mutex messageLock_;
+    // interned texts live as long as the counter, so message_ never dangles
+    std::deque<std::string> messages_;
+    std::atomic<const std::string*> message_ {nullptr};
+};
+
+/*
+ * Name indexed registry of timer counters. Lookups take a shared lock only, so triggers from
+ * many threads never serialize on WatchdogInner::lock_ or touch the scheduler queue.
+ */
+class TimerCounterRegistry {
+public:
+    bool Register(const std::string& name, std::shared_ptr<TimerCounter> counter);
+    void Unregister(const std::string& name);
+    // Return false when no counter is registered under name.
+    bool Trigger(const std::string& name, bool bTrigger, uint64_t now, const std::string& message);
+    void Clear();
+
+private:
+    mutable std::shared_mutex lock_;
+    std::unordered_map<std::string, std::shared_ptr<TimerCounter>> counters_;
+};
+} // end of namespace HiviewDFX
+} // end of namespace OHOS
+#endif
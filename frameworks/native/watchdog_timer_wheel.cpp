@@ -0,0 +1,248 @@
+/*
+ * Copyright (c) 2026 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "watchdog_timer_wheel.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace OHOS {
+namespace HiviewDFX {
+namespace {
+constexpr uint32_t BITS_OF_UINT64 = 64;
+
+uint64_t RotateLeft(uint64_t value, uint32_t shift)
+{
+    shift %= BITS_OF_UINT64;
+    return (shift == 0) ? value : ((value << shift) | (value >> (BITS_OF_UINT64 - shift)));
+}
+
+uint64_t RotateRight(uint64_t value, uint32_t shift)
+{
+    shift %= BITS_OF_UINT64;
+    return (shift == 0) ? value : ((value >> shift) | (value << (BITS_OF_UINT64 - shift)));
+}
+
+uint64_t LowBitsMask(uint64_t bits)
+{
+    return (bits >= BITS_OF_UINT64) ? ~0ULL : ((1ULL << bits) - 1);
+}
+}
+
+WatchdogTimerWheel::WatchdogTimerWheel()
+{
+    std::fill(std::begin(heads_), std::end(heads_), INVALID_INDEX);
+    std::fill(std::begin(tails_), std::end(tails_), INVALID_INDEX);
+    std::fill(std::begin(pending_), std::end(pending_), 0);
+}
+
+void WatchdogTimerWheel::Add(WatchdogTask&& task, uint64_t now)
+{
+    Update(now);
+    int64_t id = task.id;
+    uint32_t index = AllocNode(std::move(task));
+    index_[id] = index;
+    Schedule(index);
+}
+
+bool WatchdogTimerWheel::Remove(int64_t id)
+{
+    auto it = index_.find(id);
+    if (it == index_.end()) {
+        return false;
+    }
+    uint32_t index = it->second;
+    index_.erase(it);
+    Unlink(index);
+    FreeNode(index);
+    return true;
+}
+
+void WatchdogTimerWheel::Update(uint64_t now)
+{
+    if (now <= curTime_) {
+        return;
+    }
+    uint64_t elapsed = now - curTime_;
+    for (uint32_t wheel = 0; wheel < WHEEL_NUM; wheel++) {
+        uint32_t shift = wheel * WHEEL_BIT;
+        uint64_t slots;
+        if ((elapsed >> shift) > WHEEL_MASK) {
+            slots = ~0ULL;
+        } else {
+            // slots passed between the old and the new position of this wheel, both ends included
+            uint64_t passed = WHEEL_MASK & (elapsed >> shift);
+            uint32_t oldSlot = static_cast<uint32_t>(WHEEL_MASK & (curTime_ >> shift));
+            uint32_t newSlot = static_cast<uint32_t>(WHEEL_MASK & (now >> shift));
+            slots = RotateLeft(LowBitsMask(passed), oldSlot);
+            slots |= RotateRight(RotateLeft(LowBitsMask(passed), newSlot), static_cast<uint32_t>(passed));
+            slots |= 1ULL << newSlot;
+        }
+        uint64_t hit = slots & pending_[wheel];
+        pending_[wheel] &= ~slots;
+        while (hit != 0) {
+            uint32_t list = wheel * WHEEL_LEN + static_cast<uint32_t>(__builtin_ctzll(hit));
+            hit &= hit - 1;
+            for (uint32_t index = heads_[list]; index != INVALID_INDEX; index = nodes_[index].next) {
+                cascade_.push_back(index);
+            }
+            heads_[list] = INVALID_INDEX;
+            tails_[list] = INVALID_INDEX;
+        }
+        if ((slots & 1) == 0) {
+            break; // this wheel did not wrap around, higher wheels have not moved
+        }
+        elapsed = std::max(elapsed, static_cast<uint64_t>(WHEEL_LEN) << shift);
+    }
+    curTime_ = now;
+    for (uint32_t index : cascade_) {
+        nodes_[index].prev = INVALID_INDEX;
+        nodes_[index].next = INVALID_INDEX;
+        nodes_[index].list = INVALID_INDEX;
+        Schedule(index);
+    }
+    cascade_.clear();
+}
+
+bool WatchdogTimerWheel::PopExpired(WatchdogTask& task)
+{
+    uint32_t index = heads_[EXPIRED_LIST];
+    if (index == INVALID_INDEX) {
+        return false;
+    }
+    Unlink(index);
+    index_.erase(nodes_[index].task.id);
+    task = std::move(nodes_[index].task);
+    FreeNode(index);
+    return true;
+}
+
+uint64_t WatchdogTimerWheel::NextTimeout() const
+{
+    if (heads_[EXPIRED_LIST] != INVALID_INDEX) {
+        return 0;
+    }
+    uint64_t timeout = UINT64_MAX;
+    uint64_t relMask = 0;
+    for (uint32_t wheel = 0; wheel < WHEEL_NUM; wheel++) {
+        uint32_t shift = wheel * WHEEL_BIT;
+        if (pending_[wheel] != 0) {
+            uint32_t slot = static_cast<uint32_t>(WHEEL_MASK & (curTime_ >> shift));
+            // timers on higher wheels are at least one rotation away, otherwise they sit on a lower wheel
+            uint64_t wheelTimeout = static_cast<uint64_t>(__builtin_ctzll(RotateRight(pending_[wheel], slot)) +
+                (wheel != 0 ? 1 : 0)) << shift;
+            wheelTimeout -= relMask & curTime_;
+            timeout = std::min(timeout, wheelTimeout);
+        }
+        relMask = (relMask << WHEEL_BIT) | WHEEL_MASK;
+    }
+    return timeout;
+}
+
+size_t WatchdogTimerWheel::Size() const
+{
+    return index_.size();
+}
+
+bool WatchdogTimerWheel::Empty() const
+{
+    return index_.empty();
+}
+
+void WatchdogTimerWheel::Clear()
+{
+    nodes_.clear();
+    freeNodes_.clear();
+    index_.clear();
+    std::fill(std::begin(heads_), std::end(heads_), INVALID_INDEX);
+    std::fill(std::begin(tails_), std::end(tails_), INVALID_INDEX);
+    std::fill(std::begin(pending_), std::end(pending_), 0);
+}
+
+void WatchdogTimerWheel::Schedule(uint32_t index)
+{
+    uint64_t expires = nodes_[index].task.nextTickTime;
+    if (expires <= curTime_) {
+        LinkTail(EXPIRED_LIST, index);
+        return;
+    }
+    uint64_t remain = std::min(expires - curTime_, TIMEOUT_MAX);
+    uint32_t wheel = static_cast<uint32_t>(BITS_OF_UINT64 - 1 - __builtin_clzll(remain)) / WHEEL_BIT;
+    uint32_t shift = wheel * WHEEL_BIT;
+    uint32_t slot = static_cast<uint32_t>(WHEEL_MASK & ((expires >> shift) - (wheel != 0 ? 1 : 0)));
+    LinkTail(wheel * WHEEL_LEN + slot, index);
+    pending_[wheel] |= 1ULL << slot;
+}
+
+void WatchdogTimerWheel::LinkTail(uint32_t list, uint32_t index)
+{
+    Node& node = nodes_[index];
+    node.list = list;
+    node.next = INVALID_INDEX;
+    node.prev = tails_[list];
+    if (tails_[list] != INVALID_INDEX) {
+        nodes_[tails_[list]].next = index;
+    } else {
+        heads_[list] = index;
+    }
+    tails_[list] = index;
+}
+
+void WatchdogTimerWheel::Unlink(uint32_t index)
+{
+    Node& node = nodes_[index];
+    uint32_t list = node.list;
+    if (list == INVALID_INDEX) {
+        return;
+    }
+    if (node.prev != INVALID_INDEX) {
+        nodes_[node.prev].next = node.next;
+    } else {
+        heads_[list] = node.next;
+    }
+    if (node.next != INVALID_INDEX) {
+        nodes_[node.next].prev = node.prev;
+    } else {
+        tails_[list] = node.prev;
+    }
+    if (list < EXPIRED_LIST && heads_[list] == INVALID_INDEX) {
+        pending_[list / WHEEL_LEN] &= ~(1ULL << (list % WHEEL_LEN));
+    }
+    node.prev = INVALID_INDEX;
+    node.next = INVALID_INDEX;
+    node.list = INVALID_INDEX;
+}
+
+uint32_t WatchdogTimerWheel::AllocNode(WatchdogTask&& task)
+{
+    if (!freeNodes_.empty()) {
+        uint32_t index = freeNodes_.back();
+        freeNodes_.pop_back();
+        nodes_[index].task = std::move(task);
+        return index;
+    }
+    nodes_.emplace_back();
+    nodes_.back().task = std::move(task);
+    return static_cast<uint32_t>(nodes_.size() - 1);
+}
+
+void WatchdogTimerWheel::FreeNode(uint32_t index)
+{
+    // drop the callback and its captures now, the slot itself is kept for reuse
+    nodes_[index].task = WatchdogTask();
+    freeNodes_.push_back(index);
+}
+} // end of namespace HiviewDFX
+} // end of namespace OHOS
@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2026 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef RELIABILITY_WATCHDOG_TIMER_WHEEL_H
+#define RELIABILITY_WATCHDOG_TIMER_WHEEL_H
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "watchdog_task.h"
+
+namespace OHOS {
+namespace HiviewDFX {
+/*
+ * Hierarchical timing wheel for XCollie timers, 4 levels of 64 slots with millisecond ticks on
+ * the lowest level. Arm and cancel are O(1), tasks live in a pooled node array linked into
+ * per-slot lists, so a cancelled timer is unlinked without touching any other timer.
+ * Timers beyond the wheel range are parked on the top level and cascaded again when reached.
+ * Not thread safe, callers hold WatchdogInner::lock_.
+ */
+class WatchdogTimerWheel {
+public:
+    WatchdogTimerWheel();
+    ~WatchdogTimerWheel() = default;
+
+    // Arm task to expire at task.nextTickTime, now is the current tick in milliseconds.
+    void Add(WatchdogTask&& task, uint64_t now);
+    bool Remove(int64_t id);
+    // Advance the wheel to now, expired timers are then returned by PopExpired.
+    void Update(uint64_t now);
+    bool PopExpired(WatchdogTask& task);
+    // Milliseconds after the last Update before a timer may expire, UINT64_MAX if no timer is armed.
+    uint64_t NextTimeout() const;
+    size_t Size() const;
+    bool Empty() const;
+    void Clear();
+
+private:
+    static constexpr uint32_t WHEEL_BIT = 6;
+    static constexpr uint32_t WHEEL_NUM = 4;
+    static constexpr uint32_t WHEEL_LEN = 1U << WHEEL_BIT;
+    static constexpr uint64_t WHEEL_MASK = WHEEL_LEN - 1;
+    static constexpr uint64_t TIMEOUT_MAX = (1ULL << (WHEEL_BIT * WHEEL_NUM)) - 1;
+    static constexpr uint32_t EXPIRED_LIST = WHEEL_NUM * WHEEL_LEN;
+    static constexpr uint32_t LIST_NUM = EXPIRED_LIST + 1;
+    static constexpr uint32_t INVALID_INDEX = UINT32_MAX;
+
+    struct Node {
+        WatchdogTask task;
+        uint32_t prev {INVALID_INDEX};
+        uint32_t next {INVALID_INDEX};
+        uint32_t list {INVALID_INDEX};
+    };
+
+    void Schedule(uint32_t index);
+    void LinkTail(uint32_t list, uint32_t index);
+    void Unlink(uint32_t index);
+    uint32_t AllocNode(WatchdogTask&& task);
+    void FreeNode(uint32_t index);
+
+    std::vector<Node> nodes_;
+    std::vector<uint32_t> freeNodes_;
+    std::vector<uint32_t> cascade_;
+    std::unordered_map<int64_t, uint32_t> index_;
+    uint32_t heads_[LIST_NUM];
+    uint32_t tails_[LIST_NUM];
+    uint64_t pending_[WHEEL_NUM];
+    uint64_t curTime_ {0};
+};
+} // end of namespace HiviewDFX
+} // end of namespace OHOS
+#endif
@@ -17,6 +17,7 @@
 #include <ctime>
 #include <cinttypes>
 #include <algorithm>
+#include <atomic>
 #include <cmath>
 #include <cstdlib>
 #include <cstdio>
@@ -24,6 +25,7 @@
 #include <sstream>
 #include <securec.h>
 #include <iostream>
+#include <mutex>
 #include <new>
 #include <unistd.h>
 #include <fcntl.h>
@@ -31,6 +33,7 @@
 #include <sys/prctl.h>
 #include <sys/stat.h>
 #include <set>
+#include <pthread.h>
 #include "directory_ex.h"
 #include "file_ex.h"
 #include "storage_acl.h"
@@ -56,6 +59,7 @@ const int START_PATH_LEN = 128;
 constexpr int64_t MAX_TIME_BUFF = 64;
 constexpr int64_t SEC_TO_MILLISEC = 1000;
 constexpr int64_t SEC_TO_NANOSEC = 1000000000;
+constexpr int64_t MICROSEC_TO_NANOSEC = 1000;
 constexpr size_t MICROSEC_DIGIT_COUNT = 6;
 constexpr int64_t MINUTE_TO_S = 60; // 60s
 constexpr size_t TOTAL_HALF = 2; // 2 : remove half of the total
@@ -82,6 +86,13 @@ constexpr const char* PROC_MEMORYINFO = "/proc/meminfo";
 static std::string g_curProcName;
 static int32_t g_lastPid;
 static std::mutex g_lock;
+
+const char* const SPAWNER_NAMES[] = {"appspawn", "nativespawn", "hybridspawn"};
+std::mutex g_identityLock;
+ProcessIdentity g_identity; // protected by g_identityLock
+std::atomic_bool g_isIdentityCached {false};
+std::atomic<uint64_t> g_identityRefreshCount {0};
+std::once_flag g_identityForkFlag;
 }
 
 std::string FormatTimeImpl(const std::string &format, int64_t* ns)
@@ -303,6 +314,15 @@ uint64_t GetCurrentTickMillseconds()
     return static_cast<uint64_t>((t.tv_sec) * SEC_TO_MANOSEC + t.tv_nsec) / SEC_TO_MICROSEC;
 }
 
+uint64_t GetCurrentTickMicroseconds()
+{
+    struct timespec t;
+    t.tv_sec = 0;
+    t.tv_nsec = 0;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return static_cast<uint64_t>(t.tv_sec * SEC_TO_MICROSEC + t.tv_nsec / MICROSEC_TO_NANOSEC);
+}
+
 #ifdef SUSPEND_CHECK_ENABLE
 uint64_t GetCurrentBootMillseconds()
 {
@@ -361,13 +381,86 @@ bool IsFileNameFormat(char c)
     return true;
 }
 
-std::string GetSelfProcName()
+static std::string ReadSelfProcName()
 {
     std::string processName = GetProcessNameFromProcCmdline();
     processName.erase(std::remove_if(processName.begin(), processName.end(), IsFileNameFormat), processName.end());
     return processName;
 }
 
+std::string GetSelfProcName()
+{
+    return GetProcessIdentity().name;
+}
+
+static void RefreshProcessIdentityLocked()
+{
+    g_identity.uid = getuid();
+    g_identity.name = ReadSelfProcName();
+    g_identity.isSpawner = false;
+    if (g_identity.uid == 0) {
+        for (const char* spawnerName : SPAWNER_NAMES) {
+            if (g_identity.name.find(spawnerName) != std::string::npos) {
+                g_identity.isSpawner = true;
+                break;
+            }
+        }
+    }
+    g_identityRefreshCount.fetch_add(1, std::memory_order_relaxed);
+    // a spawner changes uid and name of its children after fork, so it is read again every time
+    g_isIdentityCached.store(!g_identity.name.empty() && !g_identity.isSpawner, std::memory_order_release);
+}
+
+static void PrepareIdentityFork()
+{
+    g_identityLock.lock();
+}
+
+static void ParentIdentityFork()
+{
+    g_identityLock.unlock();
+}
+
+static void ChildIdentityFork()
+{
+    g_isIdentityCached.store(false, std::memory_order_relaxed);
+    g_identityLock.unlock();
+}
+
+ProcessIdentity GetProcessIdentity()
+{
+    std::call_once(g_identityForkFlag, [] {
+        if (pthread_atfork(PrepareIdentityFork, ParentIdentityFork, ChildIdentityFork) != 0) {
+            XCOLLIE_LOGW("register process identity fork handler failed");
+        }
+    });
+    std::lock_guard<std::mutex> lock(g_identityLock);
+    if (!g_isIdentityCached.load(std::memory_order_relaxed)) {
+        RefreshProcessIdentityLocked();
+    }
+    return g_identity;
+}
+
+bool IsSpawnerProcess()
+{
+    if (g_isIdentityCached.load(std::memory_order_acquire)) {
+        // only processes that are not spawners stay cached
+        return false;
+    }
+    return GetProcessIdentity().isSpawner;
+}
+
+void InvalidateProcessIdentity()
+{
+    std::lock_guard<std::mutex> lock(g_identityLock);
+    g_isIdentityCached.store(false, std::memory_order_release);
+}
+
+uint64_t GetProcessIdentityRefreshCount()
+{
+    return g_identityRefreshCount.load(std::memory_order_relaxed);
+}
+
 std::string GetFirstLine(const std::string& path)
 {
     char checkPath[PATH_MAX] = {0};
@@ -19,6 +19,7 @@
 #include <chrono>
 #include <string>
 #include <sys/ioctl.h>
+#include <sys/types.h>
 #include <map>
 #include <set>
 #include <vector>
@@ -105,6 +106,9 @@ struct ParseBinderCallChainParam {
 
 uint64_t GetCurrentTickMillseconds();
 
+// CLOCK_MONOTONIC in microseconds, the same clock as GetCurrentTickMillseconds.
+uint64_t GetCurrentTickMicroseconds();
+
 #ifdef SUSPEND_CHECK_ENABLE
 uint64_t GetCurrentBootMillseconds();
 
@@ -117,6 +121,25 @@ bool IsFileNameFormat(char c);
 
 std::string GetSelfProcName();
 
+struct ProcessIdentity {
+    std::string name;
+    uid_t uid = 0;
+    bool isSpawner = false;
+};
+
+// Name, uid and spawn state of this process, read from /proc once and again after fork
+// or InvalidateProcessIdentity, a spawner is read again on every call.
+ProcessIdentity GetProcessIdentity();
+
+// appspawn, nativespawn or hybridspawn running as root.
+bool IsSpawnerProcess();
+
+// Call after the process is renamed or changes uid.
+void InvalidateProcessIdentity();
+
+// Times the identity was read from /proc, each read costs several syscalls.
+uint64_t GetProcessIdentityRefreshCount();
+
 std::string GetFirstLine(const std::string& path);
 
 std::string GetProcessNameFromProcCmdline(int32_t pid = 0);
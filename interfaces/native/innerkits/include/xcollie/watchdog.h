@@ -19,6 +19,7 @@
 #include <map>
 #include <string>
 #include "singleton.h"
+#include "watchdog_heartbeat.h"
 #include "xcollie_define.h"
 #include "hicollie.h"
 
@@ -188,6 +189,49 @@ public:
      */
     void GetSamplerResult(uint64_t &samplerStartTime, uint64_t &samplerFinishTime, int32_t &samplerCount);
 
+    /**
+     * @brief Keep the stack sampler and its parsed symbols loaded between freeze samples,
+     * so that back-to-back samples skip reloading maps and ELFs. Costs the memory they hold.
+     *
+     * @param isEnable true to keep them, false to release them after the current sample
+     */
+    void SetSamplerWarmCache(bool isEnable);
+
+    /**
+     * @brief Save the stacks of the following StartSample as a compact unsymbolized record, file
+     * freeze_*.tsr, instead of text. It is symbolized offline by the sample_symbolizer tool.
+     *
+     * @param isEnable true for the record, false for the symbolized text
+     */
+    void SetFreezeSampleRecord(bool isEnable);
+
+    /**
+     * @brief Set the format the stacks of the following StartSample are saved in.
+     *
+     * @param format 0: symbolized text, freeze_*.txt
+     *               1: unsymbolized record, freeze_*.tsr, same as SetFreezeSampleRecord(true)
+     *               2: collapsed stacks for flamegraphs, freeze_*.folded
+     *               3: pprof profile, freeze_*.pb
+     * @return true if the format is valid
+     */
+    bool SetFreezeSampleFormat(int format);
+
+    /**
+     * @brief Keep sampling the main thread at a low rate into a ring of raw pcs, so that main thread
+     * jank, service warning and freeze reports also show the last window of stacks before them.
+     * Costs at most 5 permille of one core and 64KB for the ring, samples over the budget are skipped.
+     *
+     * @param sampleInterval the sample interval in millisecond, at least 50
+     * @param window the time span kept in millisecond, bounded by the ring size
+     * @return true when started
+     */
+    bool StartFlightRecorder(uint32_t sampleInterval = 100, uint32_t window = 5000);
+
+    /**
+     * @brief Stop the flight recorder and release the sampler it holds.
+     */
+    void StopFlightRecorder();
+
     /**
      * Add handler to watchdog thread with customized check interval
      *
@@ -203,12 +247,92 @@ public:
     int AddThread(const std::string &name, std::shared_ptr<AppExecFwk::EventHandler> handler,
         TimeOutCallback timeOutCallback, uint64_t interval, uint32_t priority);
 
+    /**
+     * Add handler to watchdog thread, checked by the progress counter its looper bumps instead of
+     * a task posted every interval. A looper inside one event, or with pending events and no
+     * progress, for a whole interval is reported blocked.
+     *
+     * @param name, the name of handler check task
+     * @param handler, the handler whose looper is checked, its queue state is read when it does not beat
+     * @param heartbeat, the slot the looper bumps around every event, nullptr for the main looper,
+     *                   which beats through the main looper watcher
+     * @param timeOutCallback, callback when timeout
+     * @param interval, the period in millisecond
+     * @return 0 if added
+     *
+     */
+    int AddHeartbeatThread(const std::string &name, std::shared_ptr<AppExecFwk::EventHandler> handler,
+        std::shared_ptr<HeartbeatSlot> heartbeat, TimeOutCallback timeOutCallback = nullptr,
+        uint64_t interval = WATCHDOG_TIMEVAL);
+
+    /**
+     * Add handler to watchdog thread with an adaptive check interval. The handler is probed up to
+     * twice as rarely while its probes run at once, and re-checked several times a second while a
+     * probe is pending, so the reported block time is how long the probe has actually waited.
+     * A probe pending for one interval is reported as a warning and for two as a block.
+     *
+     * @param name, the name of handler check task
+     * @param handler, the handler to be checked
+     * @param timeOutCallback, callback when timeout
+     * @param interval, the warning threshold in millisecond
+     * @return 0 if added
+     *
+     */
+    int AddAdaptiveThread(const std::string &name, std::shared_ptr<AppExecFwk::EventHandler> handler,
+        TimeOutCallback timeOutCallback = nullptr, uint64_t interval = WATCHDOG_TIMEVAL);
+
+    /**
+     * @brief Post immediate and vip probes next to every probe of a handler check at a lower priority.
+     * When the check stalls, its SERVICE_WARNING tells whether the thread is blocked in one task,
+     * starved by higher priority work or just slow.
+     * @param name, the name of handler check task
+     * @param isEnable, true to enable the ladder, false to disable it
+     * @return false if the handler check is not found
+     */
+    bool SetProbeLadder(const std::string& name, bool isEnable);
+
     /**
      * @brief Get sampler result.
      * @return reserved Time
      */
     int32_t GetReservedTimeForLogging();
 
+    /**
+     * @brief Get the wakeups of the watchdog thread over the last full minute.
+     * @return wakeups per minute
+     */
+    uint64_t GetWakeupsPerMinute();
+    /**
+     * @brief Dump how late watchdog tasks start and how long they run, per task class and task name.
+     * @param isJson, false for readable text, true for one json object with the same content
+     * @return p50/p90/p99/p999/max in microseconds with the scheduler counters
+     */
+    std::string DumpSchedulerStats(bool isJson = false);
+
+    /**
+     * @brief Dump how long the check task posted to every watched handler waited before it ran.
+     * @param isJson, false for readable text, true for one json object with the same content
+     * @return p50/p90/p99/p999/max in microseconds, and how long the current check task has waited
+     */
+    std::string DumpProbeLatency(bool isJson = false);
+
+    /**
+     * @brief Let an out of process supervisor watch XCollie timers and the main looper heartbeat,
+     * so they need no watchdog thread in this process. Call it before adding any watchdog task.
+     * @param slotCount, the number of timers and heartbeats the shared region holds
+     * @return the fd of the shared region to hand to the supervisor, -1 if failed
+     */
+    int EnableSupervisedMode(uint32_t slotCount);
+
+    /**
+     * @brief Collect the evidence of a fault the supervisor found, on the calling thread.
+     * @param slot, the slot of the fault
+     * @param generation, the generation of the slot when the fault was found
+     * @param waitState, the stall level of a heartbeat, ignored for a timer
+     * @return false if the slot has been released or reused since
+     */
+    bool HandleSupervisorFault(uint32_t slot, uint64_t generation, int waitState);
+
     void* SetFreezeHandler(OH_HiCollie_FreezeCallback handler);
     std::string ReadDataFromBuffer(int type);
     std::string GetOutSelfProcName();
@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2026 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef RELIABILITY_WATCHDOG_HEARTBEAT_H
+#define RELIABILITY_WATCHDOG_HEARTBEAT_H
+
+#include <atomic>
+#include <cstdint>
+
+namespace OHOS {
+namespace HiviewDFX {
+/*
+ * Progress counter of one watched looper, for Watchdog::AddHeartbeatThread.
+ * The looper calls BeginEvent and EndEvent around every event it runs, only that thread may call them.
+ * The watchdog compares the counter between two checks instead of posting a task into the looper.
+ * Every slot owns a whole cache line, so loopers bumping their slots never contend.
+ */
+class alignas(64) HeartbeatSlot {
+public:
+    void BeginEvent()
+    {
+        Bump();
+    }
+
+    void EndEvent()
+    {
+        Bump();
+    }
+
+    uint64_t GetBeats() const
+    {
+        return beats_.load(std::memory_order_acquire);
+    }
+
+    // an odd counter means the looper is inside an event
+    static bool IsInEvent(uint64_t beats)
+    {
+        return (beats & 1) != 0;
+    }
+
+    // a detached slot is no longer bumped, the watchdog posts a check task to the looper instead
+    void SetAttached(bool isAttached)
+    {
+        isAttached_.store(isAttached, std::memory_order_release);
+    }
+
+    bool IsAttached() const
+    {
+        return isAttached_.load(std::memory_order_acquire);
+    }
+
+private:
+    void Bump()
+    {
+        // single writer, a plain store is enough and avoids a locked instruction per event
+        beats_.store(beats_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    std::atomic<uint64_t> beats_ {0};
+    std::atomic_bool isAttached_ {true};
+};
+} // end of namespace HiviewDFX
+} // end of namespace OHOS
+#endif